@@ -21,7 +21,7 @@ void print_help() {
       << "  karing [--url <url>] [--api-key <key>] [--json] swap <id1> <id2>\n"
       << "  karing [--url <url>] [--api-key <key>] [--json] resequence\n"
       << "  karing [--url <url>] [--api-key <key>] [--json] find [query] [--limit|-l <n>] [--type|-t text|file]\n"
-      << "                                  [--sort|-s id|store|update] [--asc] [--desc] [--full]\n"
+      << "                                  [--sort|-s id|store|update|rank] [--asc] [--desc] [--full]\n"
       << "  karing [--url <url>] [--api-key <key>] [--json] health\n"
       << "  karing --help\n"
       << "  karing --version\n"
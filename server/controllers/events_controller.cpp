@@ -0,0 +1,129 @@
+#include "events_controller.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <drogon/drogon.h>
+
+#include "http/event_stream.h"
+#include "store/change_feed.h"
+#include "utils/limits.h"
+#include "utils/options.h"
+
+using drogon::HttpRequestPtr;
+using drogon::HttpResponsePtr;
+
+namespace karing::controllers {
+
+namespace {
+
+std::optional<uint64_t> parse_last_event_id(const std::string& raw) {
+  if (raw.empty() || raw.size() > 20 || raw.find_first_not_of("0123456789") != std::string::npos) return std::nullopt;
+  try {
+    return std::stoull(raw);
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+// Forwards one subscription to one open response stream. Pumping runs on
+// whichever thread published, so the mutex keeps frames in event order.
+struct sse_client {
+  std::mutex mutex;
+  drogon::ResponseStreamPtr stream;
+  std::shared_ptr<karing::store::change_subscription> subscription;
+
+  void pump() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stream || !subscription) return;
+    bool lost = false;
+    const auto events = subscription->take(lost);
+    bool open = true;
+    if (lost) open = stream->send(karing::http::format_reset_event());
+    for (const auto& event : events) {
+      if (!open) break;
+      open = stream->send(karing::http::format_change_event(event));
+    }
+    if (!open) shutdown();
+  }
+
+  void keep_alive() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stream && !stream->send(karing::http::format_keep_alive())) shutdown();
+  }
+
+ private:
+  // Closing the subscription drops its wake, which owns this client.
+  void shutdown() {
+    if (subscription) subscription->close();
+    subscription.reset();
+    stream.reset();
+  }
+};
+
+std::mutex& clients_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<std::weak_ptr<sse_client>>& clients() {
+  static std::vector<std::weak_ptr<sse_client>> open;
+  return open;
+}
+
+void track(const std::shared_ptr<sse_client>& client) {
+  static std::once_flag timer;
+  std::call_once(timer, [] {
+    drogon::app().getLoop()->runEvery(karing::limits::kSseKeepAliveSeconds, [] { events_controller::keep_alive(); });
+  });
+  std::lock_guard<std::mutex> lock(clients_mutex());
+  clients().push_back(client);
+}
+
+}  // namespace
+
+void events_controller::keep_alive() {
+  std::vector<std::shared_ptr<sse_client>> open;
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex());
+    auto& tracked = clients();
+    tracked.erase(std::remove_if(tracked.begin(), tracked.end(), [](const auto& client) { return client.expired(); }),
+                  tracked.end());
+    for (const auto& client : tracked) {
+      if (auto locked = client.lock()) open.push_back(std::move(locked));
+    }
+  }
+  for (const auto& client : open) client->keep_alive();
+}
+
+void events_controller::events(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  const auto last_event_id = parse_last_event_id(req->getHeader("Last-Event-ID"));
+  const auto db_path = karing::options::current().db_path;
+
+  auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+      [last_event_id, db_path](drogon::ResponseStreamPtr stream) {
+        auto client = std::make_shared<sse_client>();
+        client->stream = std::move(stream);
+        // The wake owns the client until the subscription is closed, which
+        // happens on the first failed send: an event or a keep-alive frame.
+        auto subscription =
+            karing::store::change_feed::for_path(db_path).subscribe(last_event_id, [client] { client->pump(); });
+        {
+          std::lock_guard<std::mutex> lock(client->mutex);
+          client->subscription = std::move(subscription);
+        }
+        track(client);
+        client->pump();
+      },
+      true);
+  resp->setContentTypeString("text/event-stream");
+  resp->addHeader("Cache-Control", "no-cache");
+  resp->addHeader("X-Accel-Buffering", "no");
+  cb(resp);
+}
+
+}  // namespace karing::controllers
@@ -0,0 +1,21 @@
+#pragma once
+#include <drogon/HttpController.h>
+
+namespace karing::controllers {
+
+// Server-Sent Events stream of committed entry changes; resumes after the
+// Last-Event-ID header while the event is still in the feed's ring.
+class events_controller : public drogon::HttpController<events_controller> {
+ public:
+  METHOD_LIST_BEGIN
+  ADD_METHOD_TO(events_controller::events, "/events", drogon::Get);
+  METHOD_LIST_END
+
+  void events(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+  // Writes a comment frame to every open stream and ends the subscriptions of
+  // clients that went away; runs every kSseKeepAliveSeconds once a stream opened.
+  static void keep_alive();
+};
+
+}
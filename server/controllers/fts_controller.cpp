@@ -0,0 +1,36 @@
+#include "fts_controller.h"
+
+#include <drogon/drogon.h>
+
+#include "http/deferred.h"
+#include "http/fts_json.h"
+#include "store/fts_maintenance.h"
+#include "utils/executor.h"
+#include "utils/json_response.h"
+#include "utils/options.h"
+
+namespace karing::controllers {
+
+namespace {
+
+drogon::HttpResponsePtr handle_optimize(const drogon::HttpRequestPtr&) {
+  auto& maintenance = karing::store::fts_maintenance::for_path(karing::options::current().db_path);
+  if (!maintenance.optimize()) {
+    return karing::http::error(drogon::k500InternalServerError, "E_INTERNAL", "Optimize failed");
+  }
+  return karing::http::ok(karing::http::fts_stats_json(maintenance.stats()));
+}
+
+}  // namespace
+
+void fts_controller::optimize(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::write, req, std::move(cb), handle_optimize);
+}
+
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<drogon::HttpResponsePtr> fts_controller::optimize_task(drogon::HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(karing::executor::lane::write, req, handle_optimize);
+}
+#endif
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <drogon/HttpController.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
+
+namespace karing::controllers {
+
+// Maintenance of the full-text indexes; POST /fts/optimize merges every
+// index into one segment and answers with the resulting stats.
+class fts_controller : public drogon::HttpController<fts_controller> {
+ public:
+  METHOD_LIST_BEGIN
+#if defined(KARING_USE_COROUTINES)
+  ADD_METHOD_TO(fts_controller::optimize_task, "/fts/optimize", drogon::Post);
+#else
+  ADD_METHOD_TO(fts_controller::optimize, "/fts/optimize", drogon::Post);
+#endif
+  METHOD_LIST_END
+
+  void optimize(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+#if defined(KARING_USE_COROUTINES)
+  drogon::Task<drogon::HttpResponsePtr> optimize_task(drogon::HttpRequestPtr req);
+#endif
+};
+
+}
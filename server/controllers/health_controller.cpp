@@ -4,14 +4,43 @@
 
 #include <drogon/drogon.h>
 
+#include "db/connection_pool.h"
 #include "db/db_introspection.h"
+#include "db/wal_checkpointer.h"
+#include "http/deferred.h"
+#include "http/fts_json.h"
+#include "services/live_search_cache.h"
+#include "store/body_index.h"
+#include "store/change_feed.h"
+#include "store/entry_store.h"
+#include "store/fts_maintenance.h"
+#include "store/write_queue.h"
+#include "utils/executor.h"
 #include "utils/options.h"
 #include "utils/limits.h"
 #include "version.h"
 
 namespace karing::controllers {
 
-void health_controller::health(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+namespace {
+
+Json::Value lane_json(karing::executor::lane lane) {
+  const auto stats = karing::executor::stats(lane);
+  Json::Value out(Json::objectValue);
+  out["threads"] = stats.threads;
+  out["queued"] = stats.queued;
+  out["active"] = stats.active;
+  out["max_queue"] = stats.max_queue;
+  out["submitted"] = Json::Int64(stats.submitted);
+  out["completed"] = Json::Int64(stats.completed);
+  out["rejected"] = Json::Int64(stats.rejected);
+  const long long started = stats.completed + stats.active;
+  out["avg_wait_us"] = Json::Int64(started > 0 ? stats.wait_us_total / started : 0);
+  out["max_wait_us"] = Json::Int64(stats.wait_us_max);
+  return out;
+}
+
+drogon::HttpResponsePtr handle_health(const drogon::HttpRequestPtr&) {
   const auto& options = karing::options::current();
   Json::Value out;
   out["status"] = "ok";
@@ -37,9 +66,93 @@ void health_controller::health(const drogon::HttpRequestPtr& req, std::function<
     db["next_id"] = info->next_id;
     out["db"] = db;
   }
+  const auto pool_stats = karing::db::connection_pool::for_path(options.db_path).stats();
+  Json::Value pool(Json::objectValue);
+  pool["size"] = pool_stats.readers;
+  pool["open"] = pool_stats.open;
+  pool["idle"] = pool_stats.idle;
+  pool["in_use"] = pool_stats.in_use;
+  pool["acquired"] = Json::Int64(pool_stats.acquired);
+  pool["opened"] = Json::Int64(pool_stats.opened);
+  pool["waits"] = Json::Int64(pool_stats.waits);
+  pool["timeouts"] = Json::Int64(pool_stats.timeouts);
+  pool["health_checks"] = Json::Int64(pool_stats.health_checks);
+  pool["discarded"] = Json::Int64(pool_stats.discarded);
+  pool["statements_prepared"] = Json::Int64(pool_stats.statements_prepared);
+  pool["statement_hits"] = Json::Int64(pool_stats.statement_hits);
+  out["pool"] = pool;
+  Json::Value wal(Json::objectValue);
+  wal["journal_mode"] = options.journal_mode;
+  if (options.journal_mode == "wal") {
+    const auto checkpoint = karing::db::wal_checkpointer::for_path(options.db_path).stats();
+    wal["checkpointer"] = checkpoint.running;
+    wal["size_bytes"] = Json::Int64(checkpoint.wal_bytes);
+    wal["frames"] = checkpoint.wal_frames;
+    wal["checkpointed_frames"] = checkpoint.checkpointed_frames;
+    wal["checkpoint_lag_frames"] = checkpoint.wal_frames - checkpoint.checkpointed_frames;
+    wal["passive_checkpoints"] = Json::Int64(checkpoint.passive_runs);
+    wal["truncate_checkpoints"] = Json::Int64(checkpoint.truncate_runs);
+    wal["busy"] = Json::Int64(checkpoint.busy);
+    wal["last_checkpoint_at"] = Json::Int64(checkpoint.last_checkpoint_at);
+  }
+  out["wal"] = wal;
+  const auto write_stats = karing::store::write_queue::for_path(options.db_path).stats();
+  Json::Value writes(Json::objectValue);
+  writes["pending"] = write_stats.pending;
+  writes["jobs"] = Json::Int64(write_stats.jobs);
+  writes["batches"] = Json::Int64(write_stats.batches);
+  writes["failed_jobs"] = Json::Int64(write_stats.failed_jobs);
+  writes["failed_commits"] = Json::Int64(write_stats.failed_commits);
+  writes["last_batch"] = write_stats.last_batch;
+  writes["max_batch"] = write_stats.max_batch;
+  writes["generation"] = Json::UInt64(karing::store::entry_store::write_generation(options.db_path));
+  out["writes"] = writes;
+  const auto cache_stats = karing::services::live_search_cache::for_path(options.db_path).stats();
+  Json::Value live_cache(Json::objectValue);
+  live_cache["capacity"] = cache_stats.capacity;
+  live_cache["entries"] = cache_stats.entries;
+  live_cache["hits"] = Json::Int64(cache_stats.hits);
+  live_cache["refined"] = Json::Int64(cache_stats.refined);
+  live_cache["misses"] = Json::Int64(cache_stats.misses);
+  live_cache["invalidations"] = Json::Int64(cache_stats.invalidations);
+  out["live_cache"] = live_cache;
+  const auto feed_stats = karing::store::change_feed::for_path(options.db_path).stats();
+  Json::Value events(Json::objectValue);
+  events["subscribers"] = feed_stats.subscribers;
+  events["published"] = Json::Int64(feed_stats.published);
+  events["dropped"] = Json::Int64(feed_stats.dropped);
+  out["events"] = events;
+  const auto backfill = karing::store::body_backfill::for_path(options.db_path).stats();
+  Json::Value body_index(Json::objectValue);
+  body_index["max_bytes"] = Json::UInt64(karing::store::body_index_max_bytes());
+  body_index["backfill_running"] = backfill.running;
+  body_index["backfilled"] = Json::Int64(backfill.indexed);
+  out["body_index"] = body_index;
+  Json::Value fts = karing::http::fts_stats_json(karing::store::fts_maintenance::for_path(options.db_path).stats());
+  fts["tokenizer"] = options.fts_tokenizer;
+  fts["automerge"] = options.fts_automerge;
+  fts["crisismerge"] = options.fts_crisismerge;
+  out["fts"] = fts;
+  Json::Value executor(Json::objectValue);
+  executor["read"] = lane_json(karing::executor::lane::read);
+  executor["write"] = lane_json(karing::executor::lane::write);
+  executor["file"] = lane_json(karing::executor::lane::file);
+  out["executor"] = executor;
   auto resp = drogon::HttpResponse::newHttpJsonResponse(out);
   resp->setStatusCode(drogon::k200OK);
-  cb(resp);
+  return resp;
+}
+
+}  // namespace
+
+void health_controller::health(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::read, req, std::move(cb), handle_health);
+}
+
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<drogon::HttpResponsePtr> health_controller::health_task(drogon::HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(karing::executor::lane::read, req, handle_health);
 }
+#endif
 
 }
@@ -1,15 +1,26 @@
 #pragma once
 #include <drogon/HttpController.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace karing::controllers {
 
 class health_controller : public drogon::HttpController<health_controller> {
  public:
   METHOD_LIST_BEGIN
+#if defined(KARING_USE_COROUTINES)
+  ADD_METHOD_TO(health_controller::health_task, "/health", drogon::Get);
+#else
   ADD_METHOD_TO(health_controller::health, "/health", drogon::Get);
+#endif
   METHOD_LIST_END
 
   void health(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+#if defined(KARING_USE_COROUTINES)
+  drogon::Task<drogon::HttpResponsePtr> health_task(drogon::HttpRequestPtr req);
+#endif
 };
 
 }
@@ -2,13 +2,21 @@
 
 #include <drogon/MultiPart.h>
 #include <drogon/drogon.h>
+#include <cstdio>
 #include <optional>
 #include <string>
+#include <string_view>
 
+#include "http/byte_range.h"
+#include "http/conditional.h"
+#include "http/deferred.h"
 #include "http/download_response.h"
 #include "http/record_json.h"
 #include "http/request_params.h"
 #include "services/root_service.h"
+#include "storage/file_storage.h"
+#include "utils/compression.h"
+#include "utils/executor.h"
 #include "utils/json_response.h"
 #include "utils/options.h"
 #include "utils/upload_mime.h"
@@ -26,246 +34,319 @@ services::root_service make_root_service() {
   return services::root_service(options.db_path, options.upload_path);
 }
 
-}  // namespace
+// Keeps the ETags of JSON bodies apart from the raw body and from each other,
+// since fields= changes the bytes.
+std::string json_variant(const karing::http::record_fields& fields) {
+  const bool keys[] = {fields.is_file, fields.content, fields.preview, fields.content_length, fields.filename,
+                       fields.mime,    fields.created_at, fields.updated_at, fields.score, fields.snippet};
+  unsigned mask = 0;
+  for (const bool key : keys) mask = (mask << 1) | (key ? 1u : 0u);
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "j%x", mask);
+  return buffer;
+}
 
-void karing_root_controller::get_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+// 304 for a conditional GET of entry `id` (the latest when empty) whose
+// validators still match, decided from the entry's metadata without reading
+// its content; nullptr when the body has to be sent.
+HttpResponsePtr not_modified(const services::root_service& service,
+                             const HttpRequestPtr& req,
+                             std::optional<int> id,
+                             std::string_view variant) {
+  if (req->getHeader("if-none-match").empty() && req->getHeader("if-modified-since").empty()) return nullptr;
+  karing::dao::Projection metadata;
+  metadata.content = false;
+  const auto rec = id ? service.record_by_id(*id, metadata) : service.latest_record(metadata);
+  if (!rec) return nullptr;
+  const auto modified = karing::http::modified_at(*rec);
+  const auto tag = karing::http::not_modified_tag(req, karing::http::entity_tag(*rec, variant), modified);
+  if (!tag) return nullptr;
+  // The body size is not known here, so any entry the 200 could compress or
+  // send gzip-stored gets the Vary that such a 200 carries.
+  const bool vary = karing::http::compression_enabled() || karing::storage::file_storage::gzip_text();
+  return karing::http::make_not_modified(*tag, modified, vary);
+}
+
+// The raw body of a text entry, with its validators.
+HttpResponsePtr text_response(const karing::dao::KaringRecord& rec) {
+  auto resp = karing::http::make_text_response(rec.content);
+  karing::http::set_validators(resp, karing::http::entity_tag(rec), karing::http::modified_at(rec));
+  return resp;
+}
+
+// A JSON body of one record, tagged per fields= list.
+HttpResponsePtr record_json_response(const karing::dao::KaringRecord& rec, const karing::http::record_fields& fields) {
+  auto resp = karing::http::json_text(karing::http::ok_records_body({rec}, fields));
+  karing::http::set_validators(resp, karing::http::entity_tag(rec, json_variant(fields)),
+                               karing::http::modified_at(rec));
+  return resp;
+}
+
+enum class blob_view {
+  text,
+  inline_file,
+  attachment,
+};
+
+// Raw body of an upload or text file, streamed from disk, honoring a single
+// Range. A gzip-stored upload goes out as stored to clients that accept gzip,
+// with ranges over the stored bytes; only the rest make the server inflate it
+// into memory, and they get the whole body.
+HttpResponsePtr blob_response(const services::root_service& service, const HttpRequestPtr& req, int id, blob_view view) {
+  services::stored_file file;
+  if (!service.stored_file_by_id(id, file)) {
+    return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found");
+  }
+  const auto etag = karing::http::entity_tag(file.record);
+  const auto modified = karing::http::modified_at(file.record);
+  if (file.gzip && !karing::http::accepts_gzip(req)) {
+    services::file_blob blob;
+    if (!service.file_blob_by_id(id, blob)) {
+      return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found");
+    }
+    auto resp = view == blob_view::text
+                    ? karing::http::make_text_blob_response(blob.mime, std::move(blob.data))
+                    : karing::http::make_file_response(blob.mime, blob.filename, std::move(blob.data),
+                                                       view == blob_view::attachment);
+    karing::http::set_validators(resp, etag, modified);
+    resp->addHeader("Vary", "Accept-Encoding");
+    return resp;
+  }
+
+  const auto selected = karing::http::select_range(
+      req, file.size, file.gzip ? karing::http::coded_entity_tag(etag, karing::http::content_coding::gzip) : etag,
+      karing::http::http_date(modified));
+  if (selected.kind == karing::http::range_kind::unsatisfiable) {
+    return karing::http::make_range_not_satisfiable(file.size);
+  }
+  std::optional<karing::http::byte_range> range;
+  if (selected.kind == karing::http::range_kind::partial) range = selected.range;
+
+  auto resp = view == blob_view::text
+                  ? karing::http::make_text_file_response(file.record.mime, file.path, file.size, range)
+                  : karing::http::make_stored_file_response(file.record.mime, file.record.filename, file.path,
+                                                            view == blob_view::attachment, file.size, range);
+  karing::http::set_validators(resp, etag, modified);
+  if (file.gzip) karing::http::set_content_encoding(resp, karing::http::content_coding::gzip);
+  return resp;
+}
+
+HttpResponsePtr handle_get(const HttpRequestPtr& req) {
   const auto service = make_root_service();
   const auto params = req->getParameters();
   const bool want_json = (params.find("json") != params.end() && params.at("json") == "true");
 
   if (want_json) {
+    karing::http::record_fields fields;
+    if (const auto it = params.find("fields"); it != params.end() && !it->second.empty()) {
+      const auto parsed = karing::http::parse_record_fields(it->second);
+      if (!parsed) return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid fields");
+      fields = *parsed;
+    }
+    const auto projection = karing::http::projection_for(fields);
     if (params.find("id") != params.end()) {
       const auto id = karing::http::parse_int_param(params, "id");
       if (id.status != karing::http::int_param_status::ok) {
-        return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id"));
+        return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id");
       }
-      auto rec = service.record_by_id(id.value);
-      if (!rec) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found"));
-      Json::Value data = Json::arrayValue;
-      data.append(karing::http::record_to_json(*rec));
-      return cb(karing::http::ok(data));
+      if (auto resp = not_modified(service, req, id.value, json_variant(fields))) return resp;
+      auto rec = service.record_by_id(id.value, projection);
+      if (!rec) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found");
+      return record_json_response(*rec, fields);
     }
-    auto rec = service.latest_record();
-    if (!rec) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found"));
-    Json::Value data = Json::arrayValue;
-    data.append(karing::http::record_to_json(*rec));
-    return cb(karing::http::ok(data));
+    if (auto resp = not_modified(service, req, std::nullopt, json_variant(fields))) return resp;
+    auto rec = service.latest_record(projection);
+    if (!rec) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found");
+    return record_json_response(*rec, fields);
   }
 
   if (params.empty()) {
+    if (auto resp = not_modified(service, req, std::nullopt, {})) return resp;
     auto rec = service.latest_record();
-    if (!rec) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found"));
+    if (!rec) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found");
     if (!rec->is_file) {
-      if (karing::http::is_downloadable_text_record(*rec)) {
-        services::file_blob blob;
-        if (!service.file_blob_by_id(rec->id, blob)) {
-          return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found"));
-        }
-        return cb(karing::http::make_text_blob_response(blob.mime, std::move(blob.data)));
-      }
-      return cb(karing::http::make_text_response(rec->content));
-    }
-    services::file_blob blob;
-    if (!service.file_blob_by_id(rec->id, blob)) {
-      return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found"));
+      if (karing::http::is_downloadable_text_record(*rec)) return blob_response(service, req, rec->id, blob_view::text);
+      return text_response(*rec);
     }
-    return cb(karing::http::make_file_response(blob.mime, blob.filename, std::move(blob.data), false));
+    return blob_response(service, req, rec->id, blob_view::inline_file);
   }
 
   if (params.find("id") != params.end()) {
     const auto id = karing::http::parse_int_param(params, "id");
     if (id.status != karing::http::int_param_status::ok) {
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id"));
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id");
     }
+    if (auto resp = not_modified(service, req, id.value, {})) return resp;
     if (params.find("as") != params.end() && params.at("as") == "download") {
-      services::file_blob blob;
-      if (!service.file_blob_by_id(id.value, blob)) {
-        return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found"));
-      }
-      return cb(karing::http::make_file_response(blob.mime, blob.filename, std::move(blob.data), true));
+      return blob_response(service, req, id.value, blob_view::attachment);
     }
     auto rec = service.record_by_id(id.value);
-    if (!rec) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found"));
+    if (!rec) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found");
     if (!rec->is_file) {
-      if (karing::http::is_downloadable_text_record(*rec)) {
-        services::file_blob blob;
-        if (!service.file_blob_by_id(rec->id, blob)) {
-          return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found"));
-        }
-        return cb(karing::http::make_text_blob_response(blob.mime, std::move(blob.data)));
-      }
-      return cb(karing::http::make_text_response(rec->content));
+      if (karing::http::is_downloadable_text_record(*rec)) return blob_response(service, req, rec->id, blob_view::text);
+      return text_response(*rec);
     }
-    services::file_blob blob;
-    if (!service.file_blob_by_id(rec->id, blob)) {
-      return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "File not found"));
-    }
-    return cb(karing::http::make_file_response(blob.mime, blob.filename, std::move(blob.data), false));
+    return blob_response(service, req, rec->id, blob_view::inline_file);
   }
 
-  return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Unsupported query on root path"));
+  return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Unsupported query on root path");
 }
 
-void karing_root_controller::post_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_post(const HttpRequestPtr& req) {
   const auto& options = karing::options::current();
   const auto service = make_root_service();
   const auto& ctype = req->getHeader("content-type");
 
   if (ctype.find("application/json") != std::string::npos) {
     auto json = req->getJsonObject();
-    if (!json || !(*json)["content"].isString()) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Content required"));
+    if (!json || !(*json)["content"].isString()) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Content required");
     std::string content = (*json)["content"].asString();
     if (static_cast<long long>(content.size()) > static_cast<long long>(options.max_text_bytes)) {
-      return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large"));
+      return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large");
     }
     int id = service.create_text(content);
-    if (id < 0) return cb(karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Insert failed"));
-    return cb(karing::http::created(id));
+    if (id < 0) return karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Insert failed");
+    return karing::http::created(id);
   }
 
   if (ctype.find("multipart/form-data") != std::string::npos) {
     drogon::MultiPartParser mpp;
-    if (mpp.parse(req) != 0) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error"));
+    if (mpp.parse(req) != 0) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error");
     const auto& files = mpp.getFiles();
-    if (files.empty()) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "File required"));
+    if (files.empty()) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "File required");
     const auto& f = files.front();
     std::string filename = mpp.getParameter<std::string>("filename");
     if (filename.empty()) filename = f.getFileName();
     std::string mime = karing::upload_mime::normalise(mpp.getParameter<std::string>("mime"), filename);
     if (mime.empty()) mime = "application/octet-stream";
-    if (!karing::upload_mime::is_supported(mime)) return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type"));
+    if (!karing::upload_mime::is_supported(mime)) return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type");
     std::string data(f.fileData(), f.fileLength());
     if (static_cast<long long>(data.size()) > static_cast<long long>(options.max_file_bytes)) {
-      return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large"));
+      return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large");
     }
     int id = service.create_file(filename, mime, data);
-    if (id < 0) return cb(karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Insert failed"));
-    return cb(karing::http::created(id));
+    if (id < 0) return karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Insert failed");
+    return karing::http::created(id);
   }
 
-  return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type"));
+  return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type");
 }
 
-void karing_root_controller::swap_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_swap(const HttpRequestPtr& req) {
   const auto service = make_root_service();
   const auto params = req->getParameters();
 
   const auto id1 = karing::http::parse_int_param(params, "id1");
   const auto id2 = karing::http::parse_int_param(params, "id2");
   if (id1.status == karing::http::int_param_status::missing || id2.status == karing::http::int_param_status::missing) {
-    return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 are required"));
+    return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 are required");
   }
   if (id1.status != karing::http::int_param_status::ok || id2.status != karing::http::int_param_status::ok) {
-    return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 must be integers"));
+    return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 must be integers");
   }
 
   if (id1.value == id2.value) {
-    return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 must be different"));
+    return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "id1 and id2 must be different");
   }
 
   const auto swapped = service.swap(id1.value, id2.value);
   if (!swapped) {
-    return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Swap failed"));
+    return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Swap failed");
   }
 
   Json::Value out = Json::arrayValue;
   out.append(karing::http::record_to_json(swapped->first));
   out.append(karing::http::record_to_json(swapped->second));
-  return cb(karing::http::ok(out));
+  return karing::http::ok(out);
 }
 
-void karing_root_controller::resequence_karing(const HttpRequestPtr&,
-                                               std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_resequence(const HttpRequestPtr&) {
   const auto service = make_root_service();
   const auto resequenced = service.resequence();
   if (!resequenced) {
-    return cb(karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Resequence failed"));
+    return karing::http::error(HttpStatusCode::k500InternalServerError, "E_INTERNAL", "Resequence failed");
   }
 
-  Json::Value out = Json::arrayValue;
-  for (const auto& record : resequenced->first) {
-    out.append(karing::http::record_to_json(record));
-  }
   Json::Value meta(Json::objectValue);
   meta["count"] = static_cast<int>(resequenced->first.size());
   meta["next_id"] = resequenced->second;
-  return cb(karing::http::ok(out, meta));
+  return karing::http::json_text(karing::http::ok_records_body(resequenced->first, {}, meta));
 }
 
-void karing_root_controller::put_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_put(const HttpRequestPtr& req) {
   const auto& options = karing::options::current();
   const auto service = make_root_service();
   const auto params = req->getParameters();
   const auto id = karing::http::parse_int_param(params, "id");
-  if (id.status == karing::http::int_param_status::missing) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Id required"));
-  if (id.status != karing::http::int_param_status::ok) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id"));
+  if (id.status == karing::http::int_param_status::missing) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Id required");
+  if (id.status != karing::http::int_param_status::ok) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id");
   const auto& ctype = req->getHeader("content-type");
 
   if (ctype.find("application/json") != std::string::npos) {
     auto json = req->getJsonObject();
-    if (!json || !(*json)["content"].isString()) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Content required"));
+    if (!json || !(*json)["content"].isString()) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Content required");
     std::string content = (*json)["content"].asString();
-    if (static_cast<long long>(content.size()) > static_cast<long long>(options.max_text_bytes)) return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large"));
-    if (!service.replace_text(id.value, content)) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Update failed"));
+    if (static_cast<long long>(content.size()) > static_cast<long long>(options.max_text_bytes)) return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large");
+    if (!service.replace_text(id.value, content)) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Update failed");
     Json::Value out;
     out["id"] = id.value;
-    return cb(karing::http::ok(out));
+    return karing::http::ok(out);
   }
 
   if (ctype.find("multipart/form-data") != std::string::npos) {
     drogon::MultiPartParser mpp;
-    if (mpp.parse(req) != 0) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error"));
+    if (mpp.parse(req) != 0) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error");
     const auto& files = mpp.getFiles();
-    if (files.empty()) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "File required"));
+    if (files.empty()) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "File required");
     const auto& f = files.front();
     std::string filename = mpp.getParameter<std::string>("filename");
     if (filename.empty()) filename = f.getFileName();
     std::string mime = karing::upload_mime::normalise(mpp.getParameter<std::string>("mime"), filename);
     if (mime.empty()) mime = "application/octet-stream";
-    if (!karing::upload_mime::is_supported(mime)) return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type"));
+    if (!karing::upload_mime::is_supported(mime)) return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type");
     std::string data(f.fileData(), f.fileLength());
-    if (static_cast<long long>(data.size()) > static_cast<long long>(options.max_file_bytes)) return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large"));
-    if (!service.replace_file(id.value, filename, mime, data)) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Update failed"));
+    if (static_cast<long long>(data.size()) > static_cast<long long>(options.max_file_bytes)) return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large");
+    if (!service.replace_file(id.value, filename, mime, data)) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Update failed");
     Json::Value out;
     out["id"] = id.value;
-    return cb(karing::http::ok(out));
+    return karing::http::ok(out);
   }
 
-  return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type"));
+  return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type");
 }
 
-void karing_root_controller::patch_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_patch(const HttpRequestPtr& req) {
   const auto& options = karing::options::current();
   const auto service = make_root_service();
   const auto params = req->getParameters();
   const auto id = karing::http::parse_int_param(params, "id");
-  if (id.status == karing::http::int_param_status::missing) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Id required"));
-  if (id.status != karing::http::int_param_status::ok) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id"));
+  if (id.status == karing::http::int_param_status::missing) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Id required");
+  if (id.status != karing::http::int_param_status::ok) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id");
   const auto& ctype = req->getHeader("content-type");
 
   if (ctype.find("application/json") != std::string::npos) {
     auto json = req->getJsonObject();
-    if (!json) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "JSON required"));
+    if (!json) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "JSON required");
     std::optional<std::string> content;
     if ((*json)["content"].isString()) {
       content = (*json)["content"].asString();
-      if (static_cast<long long>(content->size()) > static_cast<long long>(options.max_text_bytes)) return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large"));
+      if (static_cast<long long>(content->size()) > static_cast<long long>(options.max_text_bytes)) return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "Text too large");
     }
-    if (!service.patch_text(id.value, content)) return cb(karing::http::error(HttpStatusCode::k409Conflict, "E_CONFLICT", "Patch failed"));
+    if (!service.patch_text(id.value, content)) return karing::http::error(HttpStatusCode::k409Conflict, "E_CONFLICT", "Patch failed");
     Json::Value out;
     out["id"] = id.value;
-    return cb(karing::http::ok(out));
+    return karing::http::ok(out);
   }
 
   if (ctype.find("multipart/form-data") != std::string::npos) {
     drogon::MultiPartParser mpp;
-    if (mpp.parse(req) != 0) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error"));
+    if (mpp.parse(req) != 0) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Multipart parse error");
     const auto& files = mpp.getFiles();
     std::optional<std::string> data;
     if (!files.empty()) {
       const auto& f = files.front();
       data = std::string(f.fileData(), f.fileLength());
-      if (static_cast<long long>(data->size()) > static_cast<long long>(options.max_file_bytes)) return cb(karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large"));
+      if (static_cast<long long>(data->size()) > static_cast<long long>(options.max_file_bytes)) return karing::http::error(HttpStatusCode::k413RequestEntityTooLarge, "E_SIZE", "File too large");
     }
     std::optional<std::string> filename;
     std::optional<std::string> mime;
@@ -273,37 +354,114 @@ void karing_root_controller::patch_karing(const HttpRequestPtr& req, std::functi
     if (auto p = mpp.getParameter<std::string>("mime"); !p.empty()) {
       const auto normalised = karing::upload_mime::normalise(p, filename.value_or(files.empty() ? std::string{} : files.front().getFileName()));
       if (normalised.empty() || !karing::upload_mime::is_supported(normalised)) {
-        return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type"));
+        return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported media type");
       }
       mime = normalised;
     } else if (!files.empty()) {
       const auto guessed = karing::upload_mime::normalise("", filename.value_or(files.front().getFileName()));
       if (!guessed.empty()) mime = guessed;
     }
-    if (!service.patch_file(id.value, filename, mime, data)) return cb(karing::http::error(HttpStatusCode::k409Conflict, "E_CONFLICT", "Patch failed"));
+    if (!service.patch_file(id.value, filename, mime, data)) return karing::http::error(HttpStatusCode::k409Conflict, "E_CONFLICT", "Patch failed");
     Json::Value out;
     out["id"] = id.value;
-    return cb(karing::http::ok(out));
+    return karing::http::ok(out);
   }
 
-  return cb(karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type"));
+  return karing::http::error(HttpStatusCode::k415UnsupportedMediaType, "E_MIME", "Unsupported content-type");
 }
 
-void karing_root_controller::delete_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+HttpResponsePtr handle_delete(const HttpRequestPtr& req) {
   const auto service = make_root_service();
   const auto params = req->getParameters();
   if (params.find("id") == params.end()) {
     if (!service.delete_latest_recent(600)) {
-      return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "No recent latest record to delete"));
+      return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "No recent latest record to delete");
     }
   } else {
     const auto id = karing::http::parse_int_param(params, "id");
-    if (id.status != karing::http::int_param_status::ok) return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id"));
-    if (!service.delete_by_id(id.value)) return cb(karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found"));
+    if (id.status != karing::http::int_param_status::ok) return karing::http::error(HttpStatusCode::k400BadRequest, "E_VALIDATION", "Invalid id");
+    if (!service.delete_by_id(id.value)) return karing::http::error(HttpStatusCode::k404NotFound, "E_NOT_FOUND", "Not found");
   }
   auto resp = drogon::HttpResponse::newHttpResponse();
   resp->setStatusCode(HttpStatusCode::k204NoContent);
-  cb(resp);
+  return resp;
+}
+
+// Multipart bodies carry file blobs, so they go to the file lane.
+karing::executor::lane body_lane(const HttpRequestPtr& req) {
+  const auto& ctype = req->getHeader("content-type");
+  return ctype.find("multipart/form-data") != std::string::npos ? karing::executor::lane::file
+                                                                : karing::executor::lane::write;
+}
+
+}  // namespace
+
+void karing_root_controller::get_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  // Only ?json=true stays off the upload directory.
+  const auto params = req->getParameters();
+  const auto json = params.find("json");
+  const bool want_json = json != params.end() && json->second == "true";
+  karing::http::run_on(want_json ? karing::executor::lane::read : karing::executor::lane::file, req, std::move(cb),
+                       handle_get);
+}
+
+void karing_root_controller::post_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(body_lane(req), req, std::move(cb), handle_post);
+}
+
+void karing_root_controller::swap_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::write, req, std::move(cb), handle_swap);
+}
+
+void karing_root_controller::resequence_karing(const HttpRequestPtr& req,
+                                               std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::write, req, std::move(cb), handle_resequence);
+}
+
+void karing_root_controller::put_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(body_lane(req), req, std::move(cb), handle_put);
+}
+
+void karing_root_controller::patch_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(body_lane(req), req, std::move(cb), handle_patch);
+}
+
+void karing_root_controller::delete_karing(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::write, req, std::move(cb), handle_delete);
+}
+
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<HttpResponsePtr> karing_root_controller::get_karing_task(HttpRequestPtr req) {
+  const auto params = req->getParameters();
+  const auto json = params.find("json");
+  const bool want_json = json != params.end() && json->second == "true";
+  co_return co_await karing::http::run_on(
+      want_json ? karing::executor::lane::read : karing::executor::lane::file, req, handle_get);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::post_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(body_lane(req), req, handle_post);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::swap_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(karing::executor::lane::write, req, handle_swap);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::resequence_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(karing::executor::lane::write, req, handle_resequence);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::put_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(body_lane(req), req, handle_put);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::patch_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(body_lane(req), req, handle_patch);
+}
+
+drogon::Task<HttpResponsePtr> karing_root_controller::delete_karing_task(HttpRequestPtr req) {
+  co_return co_await karing::http::run_on(karing::executor::lane::write, req, handle_delete);
 }
+#endif
 
 }  // namespace karing::controllers
@@ -1,11 +1,23 @@
 #pragma once
 #include <drogon/HttpController.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace karing::controllers {
 
 class karing_root_controller : public drogon::HttpController<karing_root_controller> {
  public:
   METHOD_LIST_BEGIN
+#if defined(KARING_USE_COROUTINES)
+  ADD_METHOD_TO(karing_root_controller::get_karing_task, "/", drogon::Get);
+  ADD_METHOD_TO(karing_root_controller::post_karing_task, "/", drogon::Post);
+  ADD_METHOD_TO(karing_root_controller::swap_karing_task, "/swap", drogon::Post);
+  ADD_METHOD_TO(karing_root_controller::resequence_karing_task, "/resequence", drogon::Post);
+  ADD_METHOD_TO(karing_root_controller::put_karing_task, "/", drogon::Put);
+  ADD_METHOD_TO(karing_root_controller::patch_karing_task, "/", drogon::Patch);
+  ADD_METHOD_TO(karing_root_controller::delete_karing_task, "/", drogon::Delete);
+#else
   ADD_METHOD_TO(karing_root_controller::get_karing, "/", drogon::Get);
   ADD_METHOD_TO(karing_root_controller::post_karing, "/", drogon::Post);
   ADD_METHOD_TO(karing_root_controller::swap_karing, "/swap", drogon::Post);
@@ -13,6 +25,7 @@ class karing_root_controller : public drogon::HttpController<karing_root_control
   ADD_METHOD_TO(karing_root_controller::put_karing, "/", drogon::Put);
   ADD_METHOD_TO(karing_root_controller::patch_karing, "/", drogon::Patch);
   ADD_METHOD_TO(karing_root_controller::delete_karing, "/", drogon::Delete);
+#endif
   METHOD_LIST_END
 
   void get_karing(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
@@ -22,6 +35,16 @@ class karing_root_controller : public drogon::HttpController<karing_root_control
   void put_karing(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
   void patch_karing(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
   void delete_karing(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+#if defined(KARING_USE_COROUTINES)
+  drogon::Task<drogon::HttpResponsePtr> get_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> post_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> swap_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> resequence_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> put_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> patch_karing_task(drogon::HttpRequestPtr req);
+  drogon::Task<drogon::HttpResponsePtr> delete_karing_task(drogon::HttpRequestPtr req);
+#endif
 };
 
 }
@@ -4,8 +4,11 @@
 
 #include <drogon/drogon.h>
 
+#include "http/deferred.h"
 #include "http/record_json.h"
 #include "services/search_service.h"
+#include "utils/compression.h"
+#include "utils/executor.h"
 #include "utils/json_response.h"
 #include "utils/options.h"
 
@@ -15,8 +18,9 @@ using drogon::HttpStatusCode;
 
 namespace karing::controllers {
 
-void karing_search_controller::search(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
-  const auto& options = karing::options::current();
+namespace {
+
+services::search_request read_request(const HttpRequestPtr& req, int default_limit) {
   auto params = req->getParameters();
   auto get_str = [&](const char* key) -> std::string {
     auto it = params.find(key);
@@ -33,27 +37,45 @@ void karing_search_controller::search(const HttpRequestPtr& req, std::function<v
     return fallback;
   };
 
-  services::search_service service(options.db_path, options.upload_path, options.limit);
-  const auto result = service.search({
-      .q = get_str("q"),
-      .limit = get_int("limit", options.limit),
-      .type = get_str("type"),
-      .sort = get_str("sort"),
-      .order = get_str("order"),
-  });
+  services::search_request request;
+  request.q = get_str("q");
+  request.limit = get_int("limit", default_limit);
+  request.type = get_str("type");
+  request.mime = get_str("mime");
+  request.sort = get_str("sort");
+  request.order = get_str("order");
+  request.after = get_str("after");
+  request.snippet = get_str("snippet") == "true";
+  request.mode = get_str("mode");
+  request.fields = get_str("fields");
+  return request;
+}
 
+HttpResponsePtr search_response(const services::search_result& result) {
   switch (result.error) {
-    case services::search_error::invalid_sort:
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid sort"));
+    case services::search_error::invalid_sort: {
+      Json::Value detail;
+      if (result.detail_reason.has_value()) detail["reason"] = *result.detail_reason;
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid sort", detail);
+    }
     case services::search_error::invalid_order:
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid order"));
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid order");
     case services::search_error::invalid_query: {
       Json::Value detail;
       if (result.detail_reason.has_value()) detail["reason"] = *result.detail_reason;
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid search query", detail));
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid search query", detail);
     }
+    case services::search_error::invalid_mode:
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid mode");
+    case services::search_error::invalid_cursor:
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid cursor");
+    case services::search_error::invalid_fields:
+      return karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid fields");
+    case services::search_error::busy:
+    case services::search_error::cancelled:
+      return karing::http::busy();
     case services::search_error::fts_unavailable:
-      return cb(karing::http::error(HttpStatusCode::k503ServiceUnavailable, "E_FTS_UNAVAILABLE", "Full-text search unavailable"));
+      return karing::http::error(HttpStatusCode::k503ServiceUnavailable, "E_FTS_UNAVAILABLE", "Full-text search unavailable");
     case services::search_error::none:
     case services::search_error::missing_query:
       break;
@@ -65,10 +87,31 @@ void karing_search_controller::search(const HttpRequestPtr& req, std::function<v
   meta["sort"] = result.sort;
   meta["order"] = result.order;
   if (result.has_total) meta["total"] = Json::Int64(result.total);
+  if (result.next_cursor) meta["next_cursor"] = *result.next_cursor;
+  return karing::http::json_text(karing::http::ok_records_body(result.records, result.fields, meta));
+}
 
-  Json::Value data = Json::arrayValue;
-  for (const auto& record : result.records) data.append(karing::http::record_to_json(record));
-  return cb(karing::http::ok(data, meta));
+HttpResponsePtr handle_search(const HttpRequestPtr& req) {
+  const auto& options = karing::options::current();
+  services::search_service service(options.db_path, options.upload_path, options.limit, options.fts_tokenizer == "trigram");
+  return search_response(service.search(read_request(req, options.limit)));
+}
+
+}  // namespace
+
+void karing_search_controller::search(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::read, req, std::move(cb), handle_search);
+}
+
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<HttpResponsePtr> karing_search_controller::search_task(HttpRequestPtr req) {
+  const auto& options = karing::options::current();
+  services::search_service service(options.db_path, options.upload_path, options.limit, options.fts_tokenizer == "trigram");
+  const auto result = co_await service.search_async(read_request(req, options.limit));
+  auto response = search_response(result);
+  karing::http::compress_response(req, response);
+  co_return response;
 }
+#endif
 
 }  // namespace karing::controllers
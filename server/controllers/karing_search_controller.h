@@ -1,15 +1,26 @@
 #pragma once
 #include <drogon/HttpController.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace karing::controllers {
 
 class karing_search_controller : public drogon::HttpController<karing_search_controller> {
  public:
   METHOD_LIST_BEGIN
+#if defined(KARING_USE_COROUTINES)
+  ADD_METHOD_TO(karing_search_controller::search_task, "/search", drogon::Get);
+#else
   ADD_METHOD_TO(karing_search_controller::search, "/search", drogon::Get);
+#endif
   METHOD_LIST_END
 
   void search(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+#if defined(KARING_USE_COROUTINES)
+  drogon::Task<drogon::HttpResponsePtr> search_task(drogon::HttpRequestPtr req);
+#endif
 };
 
 }
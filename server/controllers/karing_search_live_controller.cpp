@@ -4,19 +4,22 @@
 
 #include <drogon/drogon.h>
 
-#include "http/record_json.h"
+#include "http/deferred.h"
+#include "http/live_search_json.h"
 #include "services/search_service.h"
+#include "utils/compression.h"
+#include "utils/executor.h"
 #include "utils/json_response.h"
 #include "utils/options.h"
 
 using drogon::HttpRequestPtr;
 using drogon::HttpResponsePtr;
-using drogon::HttpStatusCode;
 
 namespace karing::controllers {
 
-void karing_search_live_controller::search_live(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
-  const auto& options = karing::options::current();
+namespace {
+
+services::search_request read_request(const HttpRequestPtr& req, int default_limit) {
   auto params = req->getParameters();
   auto get_str = [&](const char* key) -> std::string {
     auto it = params.find(key);
@@ -33,43 +36,46 @@ void karing_search_live_controller::search_live(const HttpRequestPtr& req, std::
     return fallback;
   };
 
-  services::search_service service(options.db_path, options.upload_path, options.limit);
-  const auto result = service.live_search({
-      .q = get_str("q"),
-      .limit = get_int("limit", std::min(options.limit, 10)),
-      .type = get_str("type"),
-      .sort = get_str("sort"),
-      .order = get_str("order"),
-  });
+  services::search_request request;
+  request.q = get_str("q");
+  request.limit = get_int("limit", default_limit);
+  request.type = get_str("type");
+  request.mime = get_str("mime");
+  request.sort = get_str("sort");
+  request.order = get_str("order");
+  request.after = get_str("after");
+  request.snippet = get_str("snippet") == "true";
+  request.mode = get_str("mode");
+  request.fields = get_str("fields");
+  return request;
+}
 
-  switch (result.error) {
-    case services::search_error::missing_query:
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "q is required"));
-    case services::search_error::invalid_sort:
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid sort"));
-    case services::search_error::invalid_order:
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid order"));
-    case services::search_error::invalid_query: {
-      Json::Value detail;
-      if (result.detail_reason.has_value()) detail["reason"] = *result.detail_reason;
-      return cb(karing::http::error(HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid live search query", detail));
-    }
-    case services::search_error::fts_unavailable:
-      return cb(karing::http::error(HttpStatusCode::k503ServiceUnavailable, "E_FTS_UNAVAILABLE", "Full-text search unavailable"));
-    case services::search_error::none:
-      break;
-  }
+HttpResponsePtr search_live_response(const services::search_result& result) {
+  auto reply = karing::http::live_search_reply_for(result);
+  return karing::http::json_text(std::move(reply.body), reply.status);
+}
 
-  Json::Value meta(Json::objectValue);
-  meta["count"] = static_cast<int>(result.records.size());
-  meta["limit"] = result.limit;
-  meta["sort"] = result.sort;
-  meta["order"] = result.order;
-  meta["live"] = result.live;
+HttpResponsePtr handle_search_live(const HttpRequestPtr& req) {
+  const auto& options = karing::options::current();
+  services::search_service service(options.db_path, options.upload_path, options.limit, options.fts_tokenizer == "trigram");
+  return search_live_response(service.live_search(read_request(req, std::min(options.limit, 10))));
+}
+
+}  // namespace
+
+void karing_search_live_controller::search_live(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& cb) {
+  karing::http::run_on(karing::executor::lane::read, req, std::move(cb), handle_search_live);
+}
 
-  Json::Value data = Json::arrayValue;
-  for (const auto& record : result.records) data.append(karing::http::record_to_live_json(record));
-  return cb(karing::http::ok(data, meta));
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<HttpResponsePtr> karing_search_live_controller::search_live_task(HttpRequestPtr req) {
+  const auto& options = karing::options::current();
+  services::search_service service(options.db_path, options.upload_path, options.limit, options.fts_tokenizer == "trigram");
+  const auto result = co_await service.live_search_async(read_request(req, std::min(options.limit, 10)));
+  auto response = search_live_response(result);
+  karing::http::compress_response(req, response);
+  co_return response;
 }
+#endif
 
 }  // namespace karing::controllers
@@ -1,15 +1,26 @@
 #pragma once
 #include <drogon/HttpController.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace karing::controllers {
 
 class karing_search_live_controller : public drogon::HttpController<karing_search_live_controller> {
  public:
   METHOD_LIST_BEGIN
+#if defined(KARING_USE_COROUTINES)
+  ADD_METHOD_TO(karing_search_live_controller::search_live_task, "/search/live", drogon::Get);
+#else
   ADD_METHOD_TO(karing_search_live_controller::search_live, "/search/live", drogon::Get);
+#endif
   METHOD_LIST_END
 
   void search_live(const drogon::HttpRequestPtr& req, std::function<void(const drogon::HttpResponsePtr&)>&& cb);
+
+#if defined(KARING_USE_COROUTINES)
+  drogon::Task<drogon::HttpResponsePtr> search_live_task(drogon::HttpRequestPtr req);
+#endif
 };
 
 }
@@ -0,0 +1,97 @@
+#include "karing_search_live_ws_controller.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <json/json.h>
+
+#include "http/live_search_json.h"
+#include "services/live_search_session.h"
+#include "utils/json_response.h"
+#include "utils/options.h"
+
+using drogon::HttpRequestPtr;
+using drogon::WebSocketConnectionPtr;
+using drogon::WebSocketMessageType;
+
+namespace karing::controllers {
+
+namespace {
+
+std::string to_text(const Json::Value& value) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, value);
+}
+
+void send_json(const WebSocketConnectionPtr& conn, Json::Value body, long long seq) {
+  body["seq"] = Json::Int64(seq);
+  conn->send(to_text(body));
+}
+
+// Same fields as the GET query string; `snippet` may be a bool or "true".
+services::search_request read_message(const Json::Value& message, int default_limit) {
+  auto get_str = [&](const char* key) -> std::string {
+    const auto& value = message[key];
+    return value.isString() ? value.asString() : std::string();
+  };
+  const auto& limit = message["limit"];
+  const auto& snippet = message["snippet"];
+
+  services::search_request request;
+  request.q = get_str("q");
+  request.limit = limit.isInt() ? limit.asInt() : default_limit;
+  request.type = get_str("type");
+  request.mime = get_str("mime");
+  request.sort = get_str("sort");
+  request.order = get_str("order");
+  request.after = get_str("after");
+  request.snippet = snippet.isBool() ? snippet.asBool() : get_str("snippet") == "true";
+  request.mode = get_str("mode");
+  request.fields = get_str("fields");
+  return request;
+}
+
+}  // namespace
+
+void karing_search_live_ws_controller::handleNewConnection(const HttpRequestPtr&, const WebSocketConnectionPtr& conn) {
+  const auto& options = karing::options::current();
+  services::search_service service(options.db_path, options.upload_path, options.limit, options.fts_tokenizer == "trigram");
+  // The connection owns the session, so the callback must not own the connection.
+  std::weak_ptr<drogon::WebSocketConnection> weak_conn = conn;
+  auto session = std::make_shared<services::live_search_session>(
+      std::move(service), [weak_conn](long long seq, const services::search_result& result) {
+        if (auto target = weak_conn.lock()) target->send(karing::http::live_search_reply_for(result, seq).body);
+      });
+  conn->setContext(session);
+}
+
+void karing_search_live_ws_controller::handleNewMessage(const WebSocketConnectionPtr& conn,
+                                                        std::string&& message,
+                                                        const WebSocketMessageType& type) {
+  if (type != WebSocketMessageType::Text) return;
+  auto session = conn->getContext<services::live_search_session>();
+  if (!session) return;
+
+  Json::Value parsed;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  if (!reader->parse(message.data(), message.data() + message.size(), &parsed, &errors) || !parsed.isObject()) {
+    send_json(conn, karing::http::error_body("E_QUERY", "Message must be a JSON object"), 0);
+    return;
+  }
+
+  const long long seq = parsed["seq"].isIntegral() ? parsed["seq"].asInt64() : 0;
+  const auto& options = karing::options::current();
+  if (!session->submit(read_message(parsed, std::min(options.limit, 10)), seq)) {
+    send_json(conn, karing::http::error_body("E_BUSY", "Server busy"), seq);
+  }
+}
+
+void karing_search_live_ws_controller::handleConnectionClosed(const WebSocketConnectionPtr& conn) {
+  if (auto session = conn->getContext<services::live_search_session>()) session->close();
+}
+
+}  // namespace karing::controllers
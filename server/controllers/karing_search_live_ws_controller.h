@@ -0,0 +1,21 @@
+#pragma once
+#include <drogon/WebSocketController.h>
+
+namespace karing::controllers {
+
+// /search/live over one WebSocket: each text message is a live query, a newer
+// message cancels the one still running, and only the newest result is sent.
+class karing_search_live_ws_controller : public drogon::WebSocketController<karing_search_live_ws_controller> {
+ public:
+  WS_PATH_LIST_BEGIN
+  WS_PATH_ADD("/search/live/ws", drogon::Get);
+  WS_PATH_LIST_END
+
+  void handleNewConnection(const drogon::HttpRequestPtr& req, const drogon::WebSocketConnectionPtr& conn) override;
+  void handleNewMessage(const drogon::WebSocketConnectionPtr& conn,
+                        std::string&& message,
+                        const drogon::WebSocketMessageType& type) override;
+  void handleConnectionClosed(const drogon::WebSocketConnectionPtr& conn) override;
+};
+
+}
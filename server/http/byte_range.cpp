@@ -0,0 +1,99 @@
+#include "http/byte_range.h"
+
+#include <cctype>
+#include <limits>
+
+namespace karing::http {
+
+namespace {
+
+std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+  return value;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+  }
+  return true;
+}
+
+// Positions past what a file can hold saturate instead of failing.
+bool parse_position(std::string_view digits, uint64_t& out) {
+  if (digits.empty()) return false;
+  out = 0;
+  for (char ch : digits) {
+    if (ch < '0' || ch > '9') return false;
+    const uint64_t digit = static_cast<uint64_t>(ch - '0');
+    if (out > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      out = std::numeric_limits<uint64_t>::max();
+    } else {
+      out = out * 10 + digit;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+range_selection parse_range(std::string_view header, uint64_t size) {
+  range_selection out;
+  header = trim(header);
+  const auto eq = header.find('=');
+  if (eq == std::string_view::npos || !iequals(trim(header.substr(0, eq)), "bytes")) return out;
+  const auto spec = trim(header.substr(eq + 1));
+  // Multipart/byteranges bodies are not produced; refuse instead of guessing.
+  if (spec.find(',') != std::string_view::npos) {
+    out.kind = range_kind::unsatisfiable;
+    return out;
+  }
+  const auto dash = spec.find('-');
+  if (dash == std::string_view::npos) return out;
+  const auto first_text = trim(spec.substr(0, dash));
+  const auto last_text = trim(spec.substr(dash + 1));
+
+  if (first_text.empty()) {
+    uint64_t suffix = 0;
+    if (!parse_position(last_text, suffix)) return out;
+    if (suffix == 0 || size == 0) {
+      out.kind = range_kind::unsatisfiable;
+      return out;
+    }
+    out.kind = range_kind::partial;
+    out.range.length = suffix < size ? suffix : size;
+    out.range.offset = size - out.range.length;
+    return out;
+  }
+
+  uint64_t first = 0;
+  uint64_t last = std::numeric_limits<uint64_t>::max();
+  if (!parse_position(first_text, first)) return out;
+  if (!last_text.empty() && (!parse_position(last_text, last) || last < first)) return out;
+  if (first >= size) {
+    out.kind = range_kind::unsatisfiable;
+    return out;
+  }
+  if (last > size - 1) last = size - 1;
+  out.kind = range_kind::partial;
+  out.range.offset = first;
+  out.range.length = last - first + 1;
+  return out;
+}
+
+range_selection select_range(const drogon::HttpRequestPtr& req,
+                             uint64_t size,
+                             const std::string& etag,
+                             const std::string& last_modified) {
+  const auto& range = req->getHeader("range");
+  if (range.empty()) return {};
+  // If-Range holds an entity tag or a date; anything but an exact match with
+  // the current one gets the whole body. Weak tags never match.
+  const auto if_range = trim(req->getHeader("if-range"));
+  if (!if_range.empty() && if_range != etag && if_range != last_modified) return {};
+  return parse_range(range, size);
+}
+
+}
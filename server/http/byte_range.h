@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <drogon/drogon.h>
+
+namespace karing::http {
+
+struct byte_range {
+  uint64_t offset{0};
+  uint64_t length{0};
+};
+
+enum class range_kind {
+  // No usable Range header: send the whole body.
+  full,
+  partial,
+  // A well-formed range that misses the body, or more than one range.
+  unsatisfiable,
+};
+
+struct range_selection {
+  range_kind kind{range_kind::full};
+  byte_range range;
+};
+
+// One `bytes=first-last`, `bytes=first-` or `bytes=-suffix` range against a
+// body of `size` bytes. Headers in other units or with bad syntax are ignored.
+range_selection parse_range(std::string_view header, uint64_t size);
+
+// Range of `req`, ignored when its If-Range matches neither `etag` (strong
+// comparison) nor `last_modified` (exact date).
+range_selection select_range(const drogon::HttpRequestPtr& req,
+                             uint64_t size,
+                             const std::string& etag,
+                             const std::string& last_modified);
+
+}
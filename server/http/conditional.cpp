@@ -0,0 +1,130 @@
+#include "http/conditional.h"
+
+#include <cstdio>
+#include <ctime>
+
+#include "utils/compression.h"
+
+namespace karing::http {
+
+namespace {
+
+constexpr const char* kDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+  return value;
+}
+
+bool parse_digits(std::string_view text, int& out) {
+  out = 0;
+  for (char ch : text) {
+    if (ch < '0' || ch > '9') return false;
+    out = out * 10 + (ch - '0');
+  }
+  return !text.empty();
+}
+
+// If-None-Match compares weakly: W/ is dropped and any coding of the tag counts.
+bool names_representation(std::string_view candidate, const std::string& etag) {
+  if (candidate.rfind("W/", 0) == 0) candidate.remove_prefix(2);
+  return candidate == etag || candidate == coded_entity_tag(etag, content_coding::gzip) ||
+         candidate == coded_entity_tag(etag, content_coding::br);
+}
+
+}  // namespace
+
+std::string entity_tag(const karing::dao::KaringRecord& record, std::string_view variant) {
+  char buffer[112];
+  std::snprintf(buffer, sizeof(buffer), "%x-%llx-%llx-%llx-%llx", static_cast<unsigned>(record.id),
+                static_cast<unsigned long long>(record.created_at),
+                static_cast<unsigned long long>(record.updated_at.value_or(0)),
+                static_cast<unsigned long long>(record.size_bytes),
+                static_cast<unsigned long long>(record.revision));
+  std::string tag = "\"";
+  tag += buffer;
+  if (!variant.empty()) {
+    tag.push_back('-');
+    tag.append(variant);
+  }
+  tag.push_back('"');
+  return tag;
+}
+
+int64_t modified_at(const karing::dao::KaringRecord& record) {
+  return record.updated_at.value_or(record.created_at);
+}
+
+std::string http_date(int64_t epoch_seconds) {
+  const auto seconds = static_cast<std::time_t>(epoch_seconds);
+  std::tm tm{};
+  gmtime_r(&seconds, &tm);
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT", kDays[tm.tm_wday], tm.tm_mday,
+                kMonths[tm.tm_mon], tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+  return buffer;
+}
+
+bool parse_http_date(std::string_view text, int64_t& out) {
+  // "Sun, 06 Nov 1994 08:49:37 GMT"
+  text = trim(text);
+  if (text.size() != 29 || text.substr(3, 2) != ", " || text.substr(25) != " GMT" || text[7] != ' ' ||
+      text[11] != ' ' || text[16] != ' ' || text[19] != ':' || text[22] != ':') {
+    return false;
+  }
+  std::tm tm{};
+  tm.tm_mon = -1;
+  for (int i = 0; i < 12; ++i) {
+    if (text.substr(8, 3) == kMonths[i]) tm.tm_mon = i;
+  }
+  int year = 0;
+  if (tm.tm_mon < 0 || !parse_digits(text.substr(5, 2), tm.tm_mday) || !parse_digits(text.substr(12, 4), year) ||
+      !parse_digits(text.substr(17, 2), tm.tm_hour) || !parse_digits(text.substr(20, 2), tm.tm_min) ||
+      !parse_digits(text.substr(23, 2), tm.tm_sec)) {
+    return false;
+  }
+  tm.tm_year = year - 1900;
+  out = static_cast<int64_t>(timegm(&tm));
+  return true;
+}
+
+std::optional<std::string> not_modified_tag(const drogon::HttpRequestPtr& req,
+                                            const std::string& etag,
+                                            int64_t modified_at) {
+  const auto& if_none_match = req->getHeader("if-none-match");
+  if (!if_none_match.empty()) {
+    std::string_view list = if_none_match;
+    if (trim(list) == "*") return etag;
+    while (!list.empty()) {
+      const auto comma = list.find(',');
+      const auto candidate = trim(list.substr(0, comma));
+      if (names_representation(candidate, etag)) {
+        return std::string(candidate.rfind("W/", 0) == 0 ? candidate.substr(2) : candidate);
+      }
+      if (comma == std::string_view::npos) break;
+      list.remove_prefix(comma + 1);
+    }
+    return std::nullopt;
+  }
+  int64_t since = 0;
+  if (parse_http_date(req->getHeader("if-modified-since"), since) && modified_at <= since) return etag;
+  return std::nullopt;
+}
+
+void set_validators(const drogon::HttpResponsePtr& resp, const std::string& etag, int64_t modified_at) {
+  resp->addHeader("ETag", etag);
+  resp->addHeader("Last-Modified", http_date(modified_at));
+}
+
+drogon::HttpResponsePtr make_not_modified(const std::string& etag, int64_t modified_at, bool vary_encoding) {
+  auto resp = drogon::HttpResponse::newHttpResponse();
+  resp->setStatusCode(drogon::k304NotModified);
+  set_validators(resp, etag, modified_at);
+  if (vary_encoding) resp->addHeader("Vary", "Accept-Encoding");
+  return resp;
+}
+
+}
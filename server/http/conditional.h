@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <drogon/drogon.h>
+
+#include "dao/karing_dao.h"
+
+namespace karing::http {
+
+// Strong entity tag of one representation of `record`, built from its id,
+// stored_at, updated_at, size and revision; the revision tells apart writes
+// within one second and swapped entries. `variant` keeps other
+// representations of the same entry, such as JSON with a fields list, apart.
+std::string entity_tag(const karing::dao::KaringRecord& record, std::string_view variant = {});
+// When the entry last changed: updated_at, or stored_at if never updated.
+int64_t modified_at(const karing::dao::KaringRecord& record);
+
+// IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string http_date(int64_t epoch_seconds);
+// Parses an IMF-fixdate; the obsolete RFC 850 and asctime forms are rejected.
+bool parse_http_date(std::string_view text, int64_t& out);
+
+// The tag to answer 304 with when the client's copy is current: If-None-Match
+// names `etag` or one of its content-coded variants, or, without it,
+// If-Modified-Since is not before `modified_at`. nullopt means send the body.
+std::optional<std::string> not_modified_tag(const drogon::HttpRequestPtr& req,
+                                            const std::string& etag,
+                                            int64_t modified_at);
+
+void set_validators(const drogon::HttpResponsePtr& resp, const std::string& etag, int64_t modified_at);
+// A 304 repeats the validators and the Vary of the 200 it stands for
+// (RFC 9110 15.4.5); `vary_encoding` when that 200 may be content-coded.
+drogon::HttpResponsePtr make_not_modified(const std::string& etag, int64_t modified_at, bool vary_encoding);
+
+}
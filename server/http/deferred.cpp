@@ -0,0 +1,49 @@
+#include "http/deferred.h"
+
+#include <memory>
+
+#include "utils/compression.h"
+#include "utils/json_response.h"
+
+namespace karing::http {
+
+void run_on(karing::executor::lane lane,
+            const drogon::HttpRequestPtr& req,
+            response_callback&& cb,
+            deferred_handler handler) {
+  auto callback = std::make_shared<response_callback>(std::move(cb));
+  const bool queued = karing::executor::submit(lane, [req, callback, handler] {
+    drogon::HttpResponsePtr response;
+    try {
+      response = handler(req);
+      compress_response(req, response);
+    } catch (...) {
+      response = error(drogon::k500InternalServerError, "E_INTERNAL", "Request failed");
+    }
+    (*callback)(response);
+  });
+  if (!queued) (*callback)(busy());
+}
+
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<drogon::HttpResponsePtr> run_on(karing::executor::lane lane,
+                                             drogon::HttpRequestPtr req,
+                                             deferred_handler handler) {
+  const bool queued = co_await karing::executor::resume_on(lane);
+  if (!queued) co_return busy();
+  drogon::HttpResponsePtr response;
+  try {
+    response = handler(req);
+    compress_response(req, response);
+  } catch (...) {
+    response = error(drogon::k500InternalServerError, "E_INTERNAL", "Request failed");
+  }
+  co_return response;
+}
+#endif
+
+drogon::HttpResponsePtr busy() {
+  return error(drogon::k503ServiceUnavailable, "E_BUSY", "Server busy");
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+
+#include <drogon/drogon.h>
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
+
+#include "utils/executor.h"
+
+namespace karing::http {
+
+using response_callback = std::function<void(const drogon::HttpResponsePtr&)>;
+using deferred_handler = drogon::HttpResponsePtr (*)(const drogon::HttpRequestPtr&);
+
+// Runs `handler` on an executor lane instead of the IO thread and compresses
+// its response there; answers 503 when the lane is full.
+void run_on(karing::executor::lane lane,
+            const drogon::HttpRequestPtr& req,
+            response_callback&& cb,
+            deferred_handler handler);
+
+#if defined(KARING_USE_COROUTINES)
+// Coroutine form: suspends the handler until `handler` has run on the lane.
+drogon::Task<drogon::HttpResponsePtr> run_on(karing::executor::lane lane,
+                                             drogon::HttpRequestPtr req,
+                                             deferred_handler handler);
+#endif
+
+drogon::HttpResponsePtr busy();
+
+}
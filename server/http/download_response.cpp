@@ -4,6 +4,8 @@
 #include <sstream>
 #include <string_view>
 
+#include "utils/json_response.h"
+
 namespace karing::http {
 
 namespace {
@@ -46,6 +48,26 @@ std::string content_disposition(std::string_view disposition, std::string_view f
          "; filename*=UTF-8''" + percent_encode_utf8(filename);
 }
 
+drogon::HttpResponsePtr file_response(const std::string& path,
+                                      const std::string& type,
+                                      uint64_t size,
+                                      const std::optional<byte_range>& range) {
+  if (!range) {
+    auto resp = drogon::HttpResponse::newFileResponse(path, "", drogon::CT_CUSTOM, type);
+    resp->addHeader("Accept-Ranges", "bytes");
+    return resp;
+  }
+  auto resp = drogon::HttpResponse::newFileResponse(path, static_cast<size_t>(range->offset),
+                                                    static_cast<size_t>(range->length), false, "",
+                                                    drogon::CT_CUSTOM, type);
+  resp->setStatusCode(drogon::k206PartialContent);
+  resp->addHeader("Accept-Ranges", "bytes");
+  resp->addHeader("Content-Range", "bytes " + std::to_string(range->offset) + "-" +
+                                       std::to_string(range->offset + range->length - 1) + "/" +
+                                       std::to_string(size));
+  return resp;
+}
+
 }  // namespace
 
 bool is_downloadable_text_record(const karing::dao::KaringRecord& record) {
@@ -70,6 +92,32 @@ drogon::HttpResponsePtr make_text_blob_response(const std::string& mime, std::st
   return resp;
 }
 
+drogon::HttpResponsePtr make_text_file_response(const std::string& mime,
+                                                const std::string& path,
+                                                uint64_t size,
+                                                const std::optional<byte_range>& range) {
+  return file_response(path, mime.empty() ? "text/plain; charset=utf-8" : mime, size, range);
+}
+
+drogon::HttpResponsePtr make_stored_file_response(const std::string& mime,
+                                                  const std::string& filename,
+                                                  const std::string& path,
+                                                  bool attachment,
+                                                  uint64_t size,
+                                                  const std::optional<byte_range>& range) {
+  // Drogon's own attachment header lacks the filename* fallback, so set ours.
+  auto resp = file_response(path, mime, size, range);
+  resp->addHeader("Content-Disposition",
+                  content_disposition(attachment ? "attachment" : "inline", filename));
+  return resp;
+}
+
+drogon::HttpResponsePtr make_range_not_satisfiable(uint64_t size) {
+  auto resp = karing::http::error(drogon::k416RequestedRangeNotSatisfiable, "E_RANGE", "Range not satisfiable");
+  resp->addHeader("Content-Range", "bytes */" + std::to_string(size));
+  return resp;
+}
+
 drogon::HttpResponsePtr make_file_response(const std::string& mime,
                                            const std::string& filename,
                                            std::string body,
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 #include <drogon/drogon.h>
 
 #include "dao/karing_dao.h"
+#include "http/byte_range.h"
 
 namespace karing::http {
 
@@ -17,4 +20,20 @@ drogon::HttpResponsePtr make_file_response(const std::string& mime,
                                            std::string body,
                                            bool attachment);
 
+// Same responses served from the `size`-byte file at `path`: Drogon sends it
+// with sendfile, so memory use does not grow with the file. With `range` only
+// those bytes go out, as 206 Partial Content.
+drogon::HttpResponsePtr make_text_file_response(const std::string& mime,
+                                                const std::string& path,
+                                                uint64_t size,
+                                                const std::optional<byte_range>& range = std::nullopt);
+drogon::HttpResponsePtr make_stored_file_response(const std::string& mime,
+                                                  const std::string& filename,
+                                                  const std::string& path,
+                                                  bool attachment,
+                                                  uint64_t size,
+                                                  const std::optional<byte_range>& range = std::nullopt);
+// 416 for a range outside a `size`-byte body.
+drogon::HttpResponsePtr make_range_not_satisfiable(uint64_t size);
+
 }
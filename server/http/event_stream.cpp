@@ -0,0 +1,32 @@
+#include "http/event_stream.h"
+
+#include <json/json.h>
+
+#include "http/record_json.h"
+
+namespace karing::http {
+
+std::string format_change_event(const karing::store::change_event& event) {
+  Json::Value data(Json::objectValue);
+  data["ids"] = Json::arrayValue;
+  for (const int id : event.ids) data["ids"].append(id);
+  if (!event.records.empty()) {
+    data["records"] = Json::arrayValue;
+    for (const auto& record : event.records) data["records"].append(record_to_json(record));
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return "id: " + std::to_string(event.id) + "\nevent: " + karing::store::change_kind_name(event.kind) +
+         "\ndata: " + Json::writeString(builder, data) + "\n\n";
+}
+
+std::string format_reset_event() {
+  return "event: reset\ndata: {}\n\n";
+}
+
+std::string format_keep_alive() {
+  return ": keep-alive\n\n";
+}
+
+}
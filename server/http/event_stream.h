@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "store/change_feed.h"
+
+namespace karing::http {
+
+// One Server-Sent Events frame: `id`, `event` (the change kind) and a one-line
+// JSON `data` with the changed ids and their record_to_json metadata.
+std::string format_change_event(const karing::store::change_event& event);
+// Tells the client that events were lost and it should reload its view.
+std::string format_reset_event();
+// An SSE comment; clients ignore it, but writing it notices a closed connection.
+std::string format_keep_alive();
+
+}
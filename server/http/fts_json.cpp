@@ -0,0 +1,31 @@
+#include "http/fts_json.h"
+
+namespace karing::http {
+
+namespace {
+
+Json::Value index_json(const karing::store::fts_index_stats& stats) {
+  Json::Value out(Json::objectValue);
+  out["segments"] = stats.segments;
+  out["size_bytes"] = Json::Int64(stats.size_bytes);
+  return out;
+}
+
+}  // namespace
+
+Json::Value fts_stats_json(const karing::store::fts_maintenance_stats& stats) {
+  Json::Value out(Json::objectValue);
+  out["maintenance"] = stats.running;
+  out["merge_steps"] = Json::Int64(stats.merge_steps);
+  out["optimize_runs"] = Json::Int64(stats.optimize_runs);
+  out["failures"] = Json::Int64(stats.failures);
+  out["last_merge_at"] = Json::Int64(stats.last_merge_at);
+  out["last_optimize_at"] = Json::Int64(stats.last_optimize_at);
+  Json::Value indexes(Json::objectValue);
+  if (stats.words.present) indexes["entries_fts"] = index_json(stats.words);
+  if (stats.trigram.present) indexes["entries_fts_tri"] = index_json(stats.trigram);
+  out["indexes"] = indexes;
+  return out;
+}
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <json/json.h>
+
+#include "store/fts_maintenance.h"
+
+namespace karing::http {
+
+// FTS maintenance counters and per-index segment counts and sizes; shared by
+// /health and POST /fts/optimize.
+Json::Value fts_stats_json(const karing::store::fts_maintenance_stats& stats);
+
+}
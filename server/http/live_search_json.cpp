@@ -0,0 +1,75 @@
+#include "http/live_search_json.h"
+
+#include "http/record_json.h"
+#include "utils/json_response.h"
+#include "utils/json_writer.h"
+
+using drogon::HttpStatusCode;
+
+namespace karing::http {
+
+namespace {
+
+Json::Value seq_field(std::optional<long long> seq) {
+  Json::Value extra;
+  if (seq) extra["seq"] = Json::Int64(*seq);
+  return extra;
+}
+
+live_search_reply failure(std::optional<long long> seq,
+                          HttpStatusCode status,
+                          const std::string& code,
+                          const std::string& message,
+                          Json::Value details = Json::nullValue) {
+  auto body = error_body(code, message, std::move(details));
+  if (seq) body["seq"] = Json::Int64(*seq);
+  json_writer out;
+  out.value(body);
+  return {status, out.take()};
+}
+
+Json::Value reason_detail(const services::search_result& result) {
+  Json::Value detail;
+  if (result.detail_reason.has_value()) detail["reason"] = *result.detail_reason;
+  return detail;
+}
+
+}  // namespace
+
+live_search_reply live_search_reply_for(const services::search_result& result, std::optional<long long> seq) {
+  switch (result.error) {
+    case services::search_error::missing_query:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "q is required");
+    case services::search_error::invalid_sort:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid sort", reason_detail(result));
+    case services::search_error::invalid_order:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid order");
+    case services::search_error::invalid_query:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid live search query", reason_detail(result));
+    case services::search_error::invalid_mode:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid mode");
+    case services::search_error::invalid_cursor:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid cursor");
+    case services::search_error::invalid_fields:
+      return failure(seq, HttpStatusCode::k400BadRequest, "E_QUERY", "Invalid fields");
+    case services::search_error::busy:
+      return failure(seq, HttpStatusCode::k503ServiceUnavailable, "E_BUSY", "Server busy");
+    case services::search_error::cancelled:
+      return failure(seq, HttpStatusCode::k503ServiceUnavailable, "E_CANCELLED", "Search cancelled");
+    case services::search_error::fts_unavailable:
+      return failure(seq, HttpStatusCode::k503ServiceUnavailable, "E_FTS_UNAVAILABLE", "Full-text search unavailable");
+    case services::search_error::none:
+      break;
+  }
+
+  Json::Value meta(Json::objectValue);
+  meta["count"] = static_cast<int>(result.records.size());
+  meta["limit"] = result.limit;
+  meta["sort"] = result.sort;
+  meta["order"] = result.order;
+  meta["live"] = result.live;
+  if (result.next_cursor) meta["next_cursor"] = *result.next_cursor;
+  return {HttpStatusCode::k200OK, ok_records_body(result.records, result.fields, meta, seq_field(seq))};
+}
+
+}
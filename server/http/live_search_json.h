@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <drogon/HttpTypes.h>
+
+#include "services/search_service.h"
+
+namespace karing::http {
+
+// A /search/live answer as a serialized JSON body and the HTTP status it is
+// sent with; shared by the GET endpoint and the WebSocket channel.
+struct live_search_reply {
+  drogon::HttpStatusCode status{drogon::k200OK};
+  std::string body;
+};
+
+// `seq` is added to the body for WebSocket replies.
+live_search_reply live_search_reply_for(const karing::services::search_result& result,
+                                        std::optional<long long> seq = std::nullopt);
+
+}
@@ -2,33 +2,127 @@
 
 #include <algorithm>
 
+#include "utils/limits.h"
+
 namespace karing::http {
 
-Json::Value record_to_json(const karing::dao::KaringRecord& record) {
-  Json::Value out;
-  out["id"] = record.id;
-  out["is_file"] = record.is_file;
-  if (!record.is_file && !record.content.empty()) out["content"] = record.content;
-  if (!record.filename.empty()) out["filename"] = record.filename;
-  if (!record.mime.empty()) out["mime"] = record.mime;
-  out["created_at"] = Json::Int64(record.created_at);
-  if (record.updated_at) out["updated_at"] = Json::Int64(*record.updated_at);
-  return out;
+namespace {
+
+void add_snippet(const karing::dao::KaringRecord& record, Json::Value& out) {
+  out["snippet"] = *record.snippet;
+  Json::Value highlights(Json::arrayValue);
+  for (const auto& [offset, length] : record.highlights) {
+    Json::Value range(Json::arrayValue);
+    range.append(offset);
+    range.append(length);
+    highlights.append(range);
+  }
+  out["highlights"] = highlights;
+}
+
+}  // namespace
+
+record_fields live_record_fields() {
+  record_fields fields;
+  fields.content = false;
+  fields.preview = true;
+  return fields;
+}
+
+std::optional<record_fields> parse_record_fields(const std::string& raw) {
+  record_fields fields{false, false, false, false, false, false, false, false, false, false};
+  size_t start = 0;
+  while (start <= raw.size()) {
+    const auto end = std::min(raw.find(',', start), raw.size());
+    const auto name = raw.substr(start, end - start);
+    start = end + 1;
+    if (name == "id") continue;
+    if (name == "is_file") fields.is_file = true;
+    else if (name == "content") fields.content = true;
+    else if (name == "preview") fields.preview = true;
+    else if (name == "content_length") fields.content_length = true;
+    else if (name == "filename") fields.filename = true;
+    else if (name == "mime") fields.mime = true;
+    else if (name == "created_at") fields.created_at = true;
+    else if (name == "updated_at") fields.updated_at = true;
+    else if (name == "score") fields.score = true;
+    else if (name == "snippet") fields.snippet = true;
+    else return std::nullopt;
+  }
+  return fields;
+}
+
+karing::dao::Projection projection_for(const record_fields& fields) {
+  if (fields.content) return {true, 0};
+  if (fields.preview) return {true, karing::limits::kLivePreviewChars};
+  return {false, 0};
 }
 
-Json::Value record_to_live_json(const karing::dao::KaringRecord& record) {
+Json::Value record_to_json(const karing::dao::KaringRecord& record, const record_fields& fields) {
   Json::Value out;
   out["id"] = record.id;
-  out["is_file"] = record.is_file;
-  if (!record.filename.empty()) out["filename"] = record.filename;
-  if (!record.mime.empty()) out["mime"] = record.mime;
+  if (fields.is_file) out["is_file"] = record.is_file;
+  const bool snippet = fields.snippet && record.snippet;
+  if (snippet) add_snippet(record, out);
   if (!record.is_file && !record.content.empty()) {
-    const auto preview_size = std::min<size_t>(record.content.size(), 120);
-    out["preview"] = record.content.substr(0, preview_size);
+    if (fields.content) out["content"] = record.content;
+    if (fields.preview && !snippet) {
+      out["preview"] = record.content.substr(0, std::min<size_t>(record.content.size(), karing::limits::kLivePreviewChars));
+    }
   }
-  out["created_at"] = Json::Int64(record.created_at);
-  if (record.updated_at) out["updated_at"] = Json::Int64(*record.updated_at);
+  if (fields.content_length) out["content_length"] = Json::Int64(record.size_bytes);
+  if (fields.filename && !record.filename.empty()) out["filename"] = record.filename;
+  if (fields.mime && !record.mime.empty()) out["mime"] = record.mime;
+  if (fields.created_at) out["created_at"] = Json::Int64(record.created_at);
+  if (fields.updated_at && record.updated_at) out["updated_at"] = Json::Int64(*record.updated_at);
+  if (fields.score && record.score) out["score"] = *record.score;
   return out;
 }
 
+void write_record(json_writer& out, const karing::dao::KaringRecord& record, const record_fields& fields) {
+  out.begin_object();
+  out.key("id").value(record.id);
+  if (fields.is_file) out.key("is_file").value(record.is_file);
+  const bool snippet = fields.snippet && record.snippet;
+  if (snippet) {
+    out.key("snippet").value(*record.snippet);
+    out.key("highlights").begin_array();
+    for (const auto& [offset, length] : record.highlights) out.begin_array().value(offset).value(length).end_array();
+    out.end_array();
+  }
+  if (!record.is_file && !record.content.empty()) {
+    if (fields.content) out.key("content").value(record.content);
+    if (fields.preview && !snippet) {
+      out.key("preview").value(
+          std::string_view(record.content).substr(0, std::min<size_t>(record.content.size(), karing::limits::kLivePreviewChars)));
+    }
+  }
+  if (fields.content_length) out.key("content_length").value(record.size_bytes);
+  if (fields.filename && !record.filename.empty()) out.key("filename").value(record.filename);
+  if (fields.mime && !record.mime.empty()) out.key("mime").value(record.mime);
+  if (fields.created_at) out.key("created_at").value(record.created_at);
+  if (fields.updated_at && record.updated_at) out.key("updated_at").value(*record.updated_at);
+  if (fields.score && record.score) out.key("score").value(*record.score);
+  out.end_object();
+}
+
+std::string ok_records_body(const std::vector<karing::dao::KaringRecord>& records,
+                            const record_fields& fields,
+                            const Json::Value& meta,
+                            const Json::Value& extra) {
+  json_writer out;
+  out.begin_object();
+  out.key("success").value(true);
+  out.key("message").value("OK");
+  out.key("data").begin_array();
+  for (const auto& record : records) write_record(out, record, fields);
+  out.end_array();
+  if (!meta.isNull()) out.key("meta").value(meta);
+  if (extra.isObject()) {
+    for (const auto& name : extra.getMemberNames()) out.key(name).value(extra[name]);
+  }
+  out.end_object();
+  return out.take();
+}
+
 }
@@ -1,12 +1,48 @@
 #pragma once
 
+#include <optional>
+#include <string>
+#include <vector>
+
 #include <json/json.h>
 
 #include "dao/karing_dao.h"
+#include "utils/json_writer.h"
 
 namespace karing::http {
 
-Json::Value record_to_json(const karing::dao::KaringRecord& record);
-Json::Value record_to_live_json(const karing::dao::KaringRecord& record);
+// Keys record_to_json emits besides id; a `fields=` list selects a subset.
+struct record_fields {
+  bool is_file{true};
+  bool content{true};
+  // Leading kLivePreviewChars of a text body.
+  bool preview{false};
+  // Stored bytes of the text body or file.
+  bool content_length{false};
+  bool filename{true};
+  bool mime{true};
+  bool created_at{true};
+  bool updated_at{true};
+  bool score{true};
+  // snippet and highlights, when snippets were requested.
+  bool snippet{true};
+};
+
+// The /search/live default: a preview in place of the full content.
+record_fields live_record_fields();
+// Comma-separated keys, e.g. "id,filename,created_at"; nullopt if one is unknown.
+std::optional<record_fields> parse_record_fields(const std::string& raw);
+// What the repository has to read from each row to fill `fields`.
+karing::dao::Projection projection_for(const record_fields& fields);
+
+Json::Value record_to_json(const karing::dao::KaringRecord& record, const record_fields& fields = {});
+// The record_to_json object written straight into `out`.
+void write_record(json_writer& out, const karing::dao::KaringRecord& record, const record_fields& fields = {});
+// The ok_body envelope around `records`, serialized without building a tree;
+// `extra` adds top-level keys such as the WebSocket `seq`.
+std::string ok_records_body(const std::vector<karing::dao::KaringRecord>& records,
+                            const record_fields& fields,
+                            const Json::Value& meta = Json::nullValue,
+                            const Json::Value& extra = Json::nullValue);
 
 }
@@ -8,10 +8,19 @@
 
 #include <drogon/drogon.h>
 
+#include "db/connection_pool.h"
 #include "db/db_init.h"
 #include "db/db_introspection.h"
 #include "db/db_path.h"
+#include "db/wal_checkpointer.h"
 #include "init/cli_output.h"
+#include "services/live_search_cache.h"
+#include "storage/file_storage.h"
+#include "store/body_index.h"
+#include "store/fts_maintenance.h"
+#include "store/write_queue.h"
+#include "utils/compression.h"
+#include "utils/executor.h"
 #include "utils/options.h"
 #include "utils/limits.h"
 #include "version.h"
@@ -31,6 +40,15 @@ int clamp_limit(int limit_override) {
   return limit_value;
 }
 
+int clamp_pool_size(int pool_size) {
+  if (pool_size < 1) return 1;
+  if (pool_size > karing::limits::kMaxDbPoolSize) {
+    LOG_WARN << "db pool size " << pool_size << " exceeds max " << karing::limits::kMaxDbPoolSize << "; clamping.";
+    return karing::limits::kMaxDbPoolSize;
+  }
+  return pool_size;
+}
+
 long long clamp_size(long long override_value, long long hard_max, const char* label) {
   if (override_value < 1) {
     throw std::runtime_error(std::string(label) + " must be >= 1 MB");
@@ -112,6 +130,53 @@ int bootstrap::execute() {
   }
 
   const int limit_value = clamp_limit(options.limit);
+  const int pool_size = clamp_pool_size(options.db_pool_size);
+  const bool use_wal = options.journal_mode == "wal";
+  {
+    karing::db::pool_options pool;
+    pool.readers = pool_size;
+    pool.wal = use_wal;
+    options.sqlite_mmap_mb = std::clamp(options.sqlite_mmap_mb, 0, karing::limits::kMaxSqliteMmapMb);
+    options.sqlite_cache_mb = std::clamp(options.sqlite_cache_mb, 0, karing::limits::kMaxSqliteCacheMb);
+    pool.reader_mmap_bytes = static_cast<long long>(options.sqlite_mmap_mb) * karing::limits::kBytesPerMb;
+    pool.reader_cache_kib = options.sqlite_cache_mb * 1024;
+    pool.wal_autocheckpoint = std::max(0, options.wal_autocheckpoint);
+    karing::db::connection_pool::configure(pool);
+
+    karing::store::write_queue_options writes;
+    writes.batch_window_ms = std::clamp(options.write_batch_ms, 0, karing::limits::kMaxWriteBatchMs);
+    writes.max_batch = std::clamp(options.write_batch_size, 1, karing::limits::kMaxWriteBatchSize);
+    karing::store::write_queue::configure(writes);
+    options.write_batch_ms = writes.batch_window_ms;
+    options.write_batch_size = writes.max_batch;
+
+    karing::executor::executor_options executor;
+    executor.read_threads = std::clamp(options.read_threads, 1, karing::limits::kMaxExecutorThreads);
+    executor.write_threads = std::clamp(options.write_threads, 1, karing::limits::kMaxExecutorThreads);
+    executor.file_threads = std::clamp(options.file_threads, 1, karing::limits::kMaxExecutorThreads);
+    executor.max_queue = std::clamp(options.executor_queue, 1, karing::limits::kMaxExecutorQueue);
+    karing::executor::configure(executor);
+    options.read_threads = executor.read_threads;
+    options.write_threads = executor.write_threads;
+    options.file_threads = executor.file_threads;
+    options.executor_queue = executor.max_queue;
+
+    options.live_cache_entries = std::clamp(options.live_cache_entries, 0, karing::limits::kMaxLiveCacheEntries);
+    karing::services::live_search_cache::configure(options.live_cache_entries);
+
+    options.fts_body_kb = std::clamp(options.fts_body_kb, 0, karing::limits::kMaxFtsBodyKb);
+    karing::store::body_index_options body_index;
+    body_index.max_bytes = static_cast<size_t>(options.fts_body_kb) * 1024;
+    karing::store::configure_body_index(body_index);
+
+    options.compress_min_bytes = std::clamp(options.compress_min_bytes, 0, karing::limits::kMaxCompressMinBytes);
+    karing::http::compression_options compression;
+    compression.min_bytes = static_cast<size_t>(options.compress_min_bytes);
+    karing::http::configure_compression(compression);
+    karing::storage::file_storage_options storage;
+    storage.gzip_text = options.store_gzip;
+    karing::storage::file_storage::configure(storage);
+  }
 
   try {
     const std::string cfg_name = "karing.sqlite";
@@ -129,7 +194,20 @@ int bootstrap::execute() {
   } catch (...) {
   }
 
-  const auto init_result = karing::db::init_sqlite_schema_file(resolved_db, limit_value, options.force);
+  karing::db::fts_options fts;
+  fts.tokenizer = options.fts_tokenizer == "trigram" ? karing::db::fts_tokenizer::trigram : karing::db::fts_tokenizer::unicode61;
+  fts.prefix = options.fts_prefix;
+  options.fts_automerge = std::clamp(options.fts_automerge, 0, karing::limits::kMaxFtsAutomerge);
+  options.fts_crisismerge = std::clamp(options.fts_crisismerge, 2, karing::limits::kMaxFtsCrisismerge);
+  options.fts_merge_idle_seconds = std::clamp(options.fts_merge_idle_seconds, 0, karing::limits::kMaxFtsMergeIdleSeconds);
+  fts.automerge = options.fts_automerge;
+  fts.crisismerge = options.fts_crisismerge;
+  const auto init_result = karing::db::init_sqlite_schema_file(
+      resolved_db,
+      limit_value,
+      options.force,
+      use_wal ? karing::db::journal_mode::wal : karing::db::journal_mode::rollback,
+      fts);
   if (!init_result.ok) {
     LOG_ERROR << "failed to initialize sqlite schema: " << init_result.error;
     return 1;
@@ -213,6 +291,7 @@ int bootstrap::execute() {
   options.limit = limit_value;
   options.max_file_bytes = static_cast<int>(max_file_bytes);
   options.max_text_bytes = static_cast<int>(max_text_bytes);
+  options.db_pool_size = pool_size;
   options.listen_address = listen_address;
   options.port = listen_port;
   options.upload_path = upload_path.string();
@@ -267,7 +346,26 @@ int bootstrap::execute() {
     }
   }
 
+  if (use_wal) {
+    karing::db::checkpoint_options checkpoint;
+    checkpoint.interval_ms = karing::limits::kWalCheckpointIntervalMs;
+    checkpoint.truncate_idle_seconds = karing::limits::kWalTruncateIdleSeconds;
+    karing::db::wal_checkpointer::for_path(resolved_db).start(checkpoint);
+  }
+  if (options.fts_body_kb > 0) karing::store::body_backfill::for_path(resolved_db).start({});
+  {
+    karing::store::fts_maintenance_options maintenance;
+    maintenance.interval_ms = karing::limits::kFtsMaintenanceIntervalMs;
+    maintenance.idle_seconds = options.fts_merge_idle_seconds;
+    maintenance.merge_pages = karing::limits::kFtsMergePages;
+    karing::store::fts_maintenance::for_path(resolved_db).start(maintenance);
+  }
+
   drogon::app().run();
+  karing::executor::stop();
+  karing::store::body_backfill::for_path(resolved_db).stop();
+  karing::store::fts_maintenance::for_path(resolved_db).stop();
+  karing::db::wal_checkpointer::for_path(resolved_db).stop();
   return 0;
 }
 
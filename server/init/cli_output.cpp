@@ -20,6 +20,26 @@ void print_help() {
       << "  --max-file <mb>       Override file size cap in MB\n"
       << "  --limit <n>           Override active item limit\n"
       << "  --upload-path <path>  Override upload staging path\n"
+      << "  --db-pool-size <n>    Override pooled SQLite reader connections\n"
+      << "  --read-threads <n>    Worker threads for JSON reads, /search and /health\n"
+      << "  --write-threads <n>   Worker threads for JSON writes\n"
+      << "  --file-threads <n>    Worker threads for uploads and file downloads\n"
+      << "  --executor-queue <n>  Queued requests per worker lane before 503\n"
+      << "  --sqlite-mmap-mb <mb> Memory-mapped I/O size for read connections (0 disables)\n"
+      << "  --sqlite-cache-mb <mb> Page cache size per read connection\n"
+      << "  --journal-mode <mode> SQLite journal mode: wal (default) or delete\n"
+      << "  --fts-tokenizer <name> unicode61 (default) or trigram for substring/CJK search\n"
+      << "  --fts-prefix <lengths> Prefix index lengths for live search, e.g. \"2 3\" (0 disables)\n"
+      << "  --fts-body-kb <kb>    Leading KiB of uploaded text files indexed for search (0 disables)\n"
+      << "  --fts-automerge <n>   FTS5 automerge setting, 0 to 16 (default: 4)\n"
+      << "  --fts-crisismerge <n> FTS5 crisismerge setting, 2 to 255 (default: 16)\n"
+      << "  --fts-merge-idle <s>  Idle seconds before FTS segments are merged (0 disables)\n"
+      << "  --wal-autocheckpoint <n> WAL pages before the writer checkpoints (0 disables)\n"
+      << "  --write-batch-ms <ms> Time the writer waits to group queued writes\n"
+      << "  --write-batch-size <n> Max writes committed in one transaction\n"
+      << "  --live-cache-entries <n> Live-search results kept in memory (0 disables)\n"
+      << "  --compress-min-bytes <n> Smallest response sent with gzip/br (0 disables)\n"
+      << "  --store-gzip          Store text-like uploads gzip-compressed\n"
       << "  --check-db            Check current database schema without modifying it\n"
       << "  --init-db             Initialize or resize database schema then exit\n"
       << "  -h, --help            Show this help message\n"
@@ -0,0 +1,223 @@
+#include "services/live_search_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+
+#include "utils/limits.h"
+
+namespace karing::services {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+int& configured_capacity() {
+  static int capacity = karing::limits::kDefaultLiveCacheEntries;
+  return capacity;
+}
+
+std::map<std::string, std::unique_ptr<live_search_cache>>& registry() {
+  static std::map<std::string, std::unique_ptr<live_search_cache>> caches;
+  return caches;
+}
+
+std::string cache_key(const std::string& scope, const std::string& query) {
+  std::string key = scope;
+  key.push_back('\x1f');
+  key.append(query);
+  return key;
+}
+
+bool is_ascii(const std::string& s) {
+  return std::all_of(s.begin(), s.end(), [](unsigned char c) { return c < 0x80; });
+}
+
+bool is_word_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+std::vector<std::string> split_query(const std::string& query) {
+  std::vector<std::string> terms;
+  size_t start = 0;
+  while (start <= query.size()) {
+    const auto end = std::min(query.find(' ', start), query.size());
+    if (end > start) terms.push_back(query.substr(start, end - start));
+    start = end + 1;
+  }
+  return terms;
+}
+
+// Terms whose FTS match can be reproduced on ASCII text: unicode61 splits
+// ASCII into alphanumeric runs, and the trigram index is a plain substring
+// search with ASCII case folding.
+bool refinable_terms(const std::vector<std::string>& terms, karing::search::match_mode mode) {
+  if (terms.empty()) return false;
+  for (const auto& term : terms) {
+    if (!is_ascii(term)) return false;
+    if (mode == karing::search::match_mode::word && !std::all_of(term.begin(), term.end(), is_word_char)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same result as the live FTS query for refinable terms: every term starts a
+// word (word mode) or occurs anywhere (substring mode).
+bool matches(const std::string& text, const std::vector<std::string>& terms, karing::search::match_mode mode) {
+  for (const auto& term : terms) {
+    auto pos = text.find(term);
+    if (mode == karing::search::match_mode::word) {
+      while (pos != std::string::npos && pos > 0 && is_word_char(text[pos - 1])) pos = text.find(term, pos + 1);
+    }
+    if (pos == std::string::npos) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+live_search_cache::live_search_cache(int capacity) : capacity_(std::max(0, capacity)) {
+  stats_.capacity = capacity_;
+}
+
+void live_search_cache::configure(int capacity) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  configured_capacity() = capacity;
+}
+
+live_search_cache& live_search_cache::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& caches = registry();
+  auto it = caches.find(db_path);
+  if (it == caches.end()) {
+    it = caches.emplace(db_path, std::make_unique<live_search_cache>(configured_capacity())).first;
+  }
+  return *it->second;
+}
+
+std::string live_search_cache::normalize(const std::string& raw) {
+  size_t a = 0;
+  while (a < raw.size() && std::isspace(static_cast<unsigned char>(raw[a]))) ++a;
+  // build_live_fts_query drops everything past 512 bytes of the trimmed input.
+  const std::string s = raw.substr(a, 512);
+  std::string out;
+  bool pending_space = false;
+  for (const char c : s) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      pending_space = !out.empty();
+      continue;
+    }
+    if (pending_space) out.push_back(' ');
+    pending_space = false;
+    out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+  }
+  return out;
+}
+
+std::optional<std::vector<karing::dao::KaringRecord>> live_search_cache::find(const std::string& scope,
+                                                                              const std::string& query,
+                                                                              karing::search::match_mode mode,
+                                                                              bool refine,
+                                                                              uint64_t generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled() || !adopt_generation(generation)) {
+    ++stats_.misses;
+    return std::nullopt;
+  }
+
+  const auto key = cache_key(scope, query);
+  if (const auto it = entries_.find(key); it != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    ++stats_.hits;
+    return it->second.records;
+  }
+
+  // A longer query only narrows a prefix's hits, so complete hits of any
+  // cached prefix hold every answer; the longest such prefix scans the least.
+  const auto terms = split_query(query);
+  if (refine && refinable_terms(terms, mode)) {
+    for (size_t n = query.size() - 1; n > 0; --n) {
+      if (query[n - 1] == ' ') continue;
+      const auto base = entries_.find(cache_key(scope, query.substr(0, n)));
+      if (base == entries_.end() || !base->second.refinable) continue;
+
+      entry narrowed;
+      narrowed.refinable = true;
+      const auto& source = base->second;
+      for (size_t i = 0; i < source.records.size(); ++i) {
+        if (!matches(*source.texts[i], terms, mode)) continue;
+        narrowed.records.push_back(source.records[i]);
+        narrowed.texts.push_back(source.texts[i]);
+      }
+      auto records = narrowed.records;
+      insert(key, std::move(narrowed));
+      ++stats_.refined;
+      return records;
+    }
+  }
+
+  ++stats_.misses;
+  return std::nullopt;
+}
+
+void live_search_cache::store(const std::string& scope,
+                              const std::string& query,
+                              uint64_t generation,
+                              std::vector<karing::dao::KaringRecord> records,
+                              bool complete,
+                              std::vector<std::string> texts) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled() || !adopt_generation(generation)) return;
+
+  entry value;
+  value.records = std::move(records);
+  value.refinable = complete && texts.size() == value.records.size() &&
+                    std::all_of(texts.begin(), texts.end(), [](const std::string& text) { return is_ascii(text); });
+  if (value.refinable) {
+    value.texts.reserve(texts.size());
+    for (auto& text : texts) {
+      std::transform(text.begin(), text.end(), text.begin(),
+                     [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      value.texts.push_back(std::make_shared<const std::string>(std::move(text)));
+    }
+  }
+  insert(cache_key(scope, query), std::move(value));
+}
+
+live_cache_stats live_search_cache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  live_cache_stats out = stats_;
+  out.entries = static_cast<int>(entries_.size());
+  return out;
+}
+
+bool live_search_cache::adopt_generation(uint64_t generation) {
+  if (generation < generation_) return false;
+  if (generation > generation_) {
+    if (!entries_.empty()) ++stats_.invalidations;
+    entries_.clear();
+    lru_.clear();
+    generation_ = generation;
+  }
+  return true;
+}
+
+void live_search_cache::insert(const std::string& key, entry value) {
+  if (const auto it = entries_.find(key); it != entries_.end()) {
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  lru_.push_front(key);
+  value.lru = lru_.begin();
+  entries_.emplace(key, std::move(value));
+  while (static_cast<int>(entries_.size()) > capacity_) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+}
+
+}  // namespace karing::services
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dao/karing_dao.h"
+#include "utils/search_query.h"
+
+namespace karing::services {
+
+struct live_cache_stats {
+  int capacity{0};
+  int entries{0};
+  long long hits{0};
+  long long refined{0};
+  long long misses{0};
+  long long invalidations{0};
+};
+
+// Recent /search/live results for one database, keyed by scope (every request
+// field that shapes the result except q) and normalized q. A query that
+// extends a cached query whose hits were complete is answered by filtering
+// those hits in memory. Entries belong to one entry_store write generation;
+// the first lookup or store at a newer generation drops them all.
+class live_search_cache {
+ public:
+  explicit live_search_cache(int capacity);
+
+  live_search_cache(const live_search_cache&) = delete;
+  live_search_cache& operator=(const live_search_cache&) = delete;
+
+  // Applies to caches created after the call; set once at startup. 0 disables.
+  static void configure(int capacity);
+  static live_search_cache& for_path(const std::string& db_path);
+
+  // Lowercased terms of `raw` joined by single spaces, as build_live_fts_query splits them.
+  static std::string normalize(const std::string& raw);
+
+  bool enabled() const { return capacity_ > 0; }
+
+  // `refine`: false when the order of hits depends on q (sort=rank).
+  std::optional<std::vector<karing::dao::KaringRecord>> find(const std::string& scope,
+                                                             const std::string& query,
+                                                             karing::search::match_mode mode,
+                                                             bool refine,
+                                                             uint64_t generation);
+  // `texts` holds the searchable text of each record when `complete` (fewer
+  // hits than the limit); leave it empty to allow exact hits only.
+  void store(const std::string& scope,
+             const std::string& query,
+             uint64_t generation,
+             std::vector<karing::dao::KaringRecord> records,
+             bool complete,
+             std::vector<std::string> texts);
+
+  live_cache_stats stats() const;
+
+ private:
+  struct entry {
+    std::vector<karing::dao::KaringRecord> records;
+    // Complete hits whose lowercased search text is in `texts`, one per record.
+    bool refinable{false};
+    std::vector<std::shared_ptr<const std::string>> texts;
+    std::list<std::string>::iterator lru;
+  };
+
+  // Caller holds mutex_. False if `generation` is older than the cached one.
+  bool adopt_generation(uint64_t generation);
+  void insert(const std::string& key, entry value);
+
+  int capacity_{0};
+  mutable std::mutex mutex_;
+  uint64_t generation_{0};
+  std::unordered_map<std::string, entry> entries_;
+  // Most recently used first.
+  std::list<std::string> lru_;
+  live_cache_stats stats_;
+};
+
+}  // namespace karing::services
@@ -0,0 +1,65 @@
+#include "services/live_search_session.h"
+
+#include "utils/executor.h"
+
+namespace karing::services {
+
+live_search_session::live_search_session(search_service service, deliver on_result)
+    : service_(std::move(service)), on_result_(std::move(on_result)) {}
+
+bool live_search_session::submit(search_request request, long long seq) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) return true;
+    if (running_cancel_) running_cancel_->store(true);
+    pending_ = pending_query{std::move(request), seq};
+    if (running_) return true;
+    running_ = true;
+  }
+
+  auto self = shared_from_this();
+  if (karing::executor::submit(karing::executor::lane::read, [self] { self->drain(); })) return true;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+  pending_.reset();
+  return false;
+}
+
+void live_search_session::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  pending_.reset();
+  if (running_cancel_) running_cancel_->store(true);
+}
+
+void live_search_session::drain() {
+  for (;;) {
+    pending_query query;
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (closed_ || !pending_) {
+        running_ = false;
+        running_cancel_.reset();
+        return;
+      }
+      query = std::move(*pending_);
+      pending_.reset();
+      running_cancel_ = cancel;
+    }
+
+    query.request.cancel = cancel.get();
+    const auto result = service_.live_search(query.request);
+
+    bool superseded = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      superseded = closed_ || pending_.has_value();
+    }
+    if (superseded || result.error == search_error::cancelled) continue;
+    on_result_(query.seq, result);
+  }
+}
+
+}  // namespace karing::services
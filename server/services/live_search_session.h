@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "services/search_service.h"
+
+namespace karing::services {
+
+// One client's stream of live queries. A submitted query replaces the one
+// still waiting and cancels the one running, and a result is delivered only
+// if nothing newer arrived while it ran. Queries run on the executor's read
+// lane, one at a time per session.
+class live_search_session : public std::enable_shared_from_this<live_search_session> {
+ public:
+  // Called on a lane thread with the `seq` the query was submitted with.
+  using deliver = std::function<void(long long seq, const search_result& result)>;
+
+  live_search_session(search_service service, deliver on_result);
+
+  live_search_session(const live_search_session&) = delete;
+  live_search_session& operator=(const live_search_session&) = delete;
+
+  // False if the read lane is full; the query is dropped.
+  bool submit(search_request request, long long seq);
+  // Cancels the running query and drops everything still queued.
+  void close();
+
+ private:
+  struct pending_query {
+    search_request request;
+    long long seq{0};
+  };
+
+  void drain();
+
+  search_service service_;
+  deliver on_result_;
+
+  std::mutex mutex_;
+  std::optional<pending_query> pending_;
+  std::shared_ptr<std::atomic<bool>> running_cancel_;
+  bool running_{false};
+  bool closed_{false};
+};
+
+}  // namespace karing::services
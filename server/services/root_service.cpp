@@ -1,5 +1,9 @@
 #include "services/root_service.h"
 
+#include <filesystem>
+
+#include "storage/file_storage.h"
+
 namespace karing::services {
 
 root_service::root_service(std::string db_path, std::string upload_path)
@@ -16,16 +20,40 @@ std::optional<karing::dao::KaringRecord> root_service::latest_record() const {
   return dao.get_by_id(*latest);
 }
 
+std::optional<karing::dao::KaringRecord> root_service::latest_record(const karing::dao::Projection& projection) const {
+  auto dao = make_dao();
+  const auto latest = dao.latest_id();
+  if (!latest) return std::nullopt;
+  return dao.get_by_id(*latest, projection);
+}
+
 std::optional<karing::dao::KaringRecord> root_service::record_by_id(int id) const {
   auto dao = make_dao();
   return dao.get_by_id(id);
 }
 
+std::optional<karing::dao::KaringRecord> root_service::record_by_id(int id, const karing::dao::Projection& projection) const {
+  auto dao = make_dao();
+  return dao.get_by_id(id, projection);
+}
+
 bool root_service::file_blob_by_id(int id, file_blob& out) const {
   auto dao = make_dao();
   return dao.get_file_blob(id, out.mime, out.filename, out.data);
 }
 
+bool root_service::stored_file_by_id(int id, stored_file& out) const {
+  auto dao = make_dao();
+  if (!dao.get_file_location(id, out.record, out.path)) return false;
+  // A row whose file went missing answers 404 like one without a file.
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(out.path, ec)) return false;
+  out.size = std::filesystem::file_size(out.path, ec);
+  if (ec) return false;
+  out.gzip = karing::storage::file_storage::is_gzip(out.path);
+  return true;
+}
+
 int root_service::create_text(const std::string& content) const {
   auto dao = make_dao();
   return dao.insert_text(content);
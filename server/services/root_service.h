@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <utility>
@@ -14,13 +15,27 @@ struct file_blob {
   std::string data;
 };
 
+// An upload on disk, for responses that stream it instead of reading it.
+struct stored_file {
+  // The entry, with its mime type and filename defaulted.
+  karing::dao::KaringRecord record;
+  std::string path;
+  // The file holds a gzip stream (stored with --store-gzip).
+  bool gzip{false};
+  // Bytes on disk; record.size_bytes is the size before compression.
+  uint64_t size{0};
+};
+
 class root_service {
  public:
   root_service(std::string db_path, std::string upload_path);
 
   std::optional<karing::dao::KaringRecord> latest_record() const;
+  std::optional<karing::dao::KaringRecord> latest_record(const karing::dao::Projection& projection) const;
   std::optional<karing::dao::KaringRecord> record_by_id(int id) const;
+  std::optional<karing::dao::KaringRecord> record_by_id(int id, const karing::dao::Projection& projection) const;
   bool file_blob_by_id(int id, file_blob& out) const;
+  bool stored_file_by_id(int id, stored_file& out) const;
 
   int create_text(const std::string& content) const;
   int create_file(const std::string& filename, const std::string& mime, const std::string& data) const;
@@ -1,7 +1,12 @@
 #include "services/search_service.h"
 
 #include <algorithm>
+#include <cctype>
 
+#include "services/live_search_cache.h"
+#include "utils/executor.h"
+#include "utils/limits.h"
+#include "utils/search_cursor.h"
 #include "utils/search_query.h"
 
 namespace karing::services {
@@ -12,6 +17,7 @@ std::optional<dao::SortField> parse_sort_field(const std::string& value) {
   if (value.empty() || value == "id") return dao::SortField::id;
   if (value == "stored_at") return dao::SortField::stored_at;
   if (value == "updated_at") return dao::SortField::updated_at;
+  if (value == "rank") return dao::SortField::rank;
   return std::nullopt;
 }
 
@@ -21,12 +27,82 @@ std::optional<bool> parse_sort_order(const std::string& value) {
   return std::nullopt;
 }
 
+// Substring matching needs the trigram index and is opt-in: its terms need
+// three characters, while the first keystrokes of a word must still match.
+std::optional<karing::search::match_mode> parse_match_mode(const std::string& value, bool trigram) {
+  if (value.empty() || value == "word") return karing::search::match_mode::word;
+  if (value == "substring" && trigram) return karing::search::match_mode::substring;
+  return std::nullopt;
+}
+
 std::optional<int> parse_type_filter(const std::string& value) {
   if (value == "text") return 0;
   if (value == "file") return 1;
   return std::nullopt;
 }
 
+dao::KaringDao::Filters make_filters(const search_request& request, dao::SortField sort, bool desc) {
+  dao::KaringDao::Filters filters;
+  if (!request.type.empty()) filters.is_file = parse_type_filter(request.type);
+  std::string mime = request.mime;
+  std::transform(mime.begin(), mime.end(), mime.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  if (mime.size() >= 2 && mime.compare(mime.size() - 2, 2, "/*") == 0) mime.pop_back();
+  if (!mime.empty()) {
+    if (mime.back() == '/') {
+      filters.mime_prefix = mime;
+    } else {
+      filters.mime = mime;
+    }
+  }
+  filters.sort = sort;
+  filters.order_desc = desc;
+  filters.snippet = request.snippet && !request.q.empty();
+  return filters;
+}
+
+// list_latest reads full rows; anything narrower goes through list_filtered.
+bool has_filters(const dao::KaringDao::Filters& filters) {
+  return filters.is_file.has_value() || filters.mime.has_value() || filters.mime_prefix.has_value() ||
+         filters.after.has_value() || !filters.projection.content || filters.projection.preview_chars > 0;
+}
+
+// Leaves `fields` alone when `raw` is empty; false if it names an unknown key.
+bool apply_fields(const std::string& raw, search_result& result, dao::KaringDao::Filters& filters) {
+  if (!raw.empty()) {
+    const auto parsed = karing::http::parse_record_fields(raw);
+    if (!parsed) return false;
+    result.fields = *parsed;
+  }
+  filters.projection = karing::http::projection_for(result.fields);
+  filters.snippet = filters.snippet && result.fields.snippet;
+  return true;
+}
+
+// False if `token` is malformed or was issued for a different sort/order.
+// Relevance pages have no stable key, so sort=rank takes no cursor.
+bool apply_cursor(const std::string& token, const search_result& result, dao::KaringDao::Filters& filters) {
+  if (token.empty()) return true;
+  if (filters.sort == dao::SortField::rank) return false;
+  const auto cursor = karing::search::decode_cursor(token);
+  if (!cursor || cursor->sort != result.sort || cursor->order != result.order) return false;
+  if (filters.sort == dao::SortField::stored_at && !cursor->value) return false;
+  filters.after = dao::KaringDao::PageCursor{cursor->value, cursor->id};
+  return true;
+}
+
+void set_next_cursor(search_result& result, dao::SortField sort) {
+  if (sort == dao::SortField::rank) return;
+  if (result.records.empty() || static_cast<int>(result.records.size()) < result.limit) return;
+  const auto& last = result.records.back();
+  karing::search::Cursor cursor;
+  cursor.sort = result.sort;
+  cursor.order = result.order;
+  cursor.id = last.id;
+  if (sort == dao::SortField::stored_at) cursor.value = last.created_at;
+  if (sort == dao::SortField::updated_at) cursor.value = last.updated_at;
+  result.next_cursor = karing::search::encode_cursor(cursor);
+}
+
 search_result make_error(search_error error, std::optional<std::string> detail_reason = std::nullopt) {
   search_result result;
   result.error = error;
@@ -36,8 +112,8 @@ search_result make_error(search_error error, std::optional<std::string> detail_r
 
 }  // namespace
 
-search_service::search_service(std::string db_path, std::string upload_path, int max_limit)
-    : db_path_(std::move(db_path)), upload_path_(std::move(upload_path)), max_limit_(max_limit) {}
+search_service::search_service(std::string db_path, std::string upload_path, int max_limit, bool trigram)
+    : db_path_(std::move(db_path)), upload_path_(std::move(upload_path)), max_limit_(max_limit), trigram_(trigram) {}
 
 karing::dao::KaringDao search_service::make_dao() const {
   return karing::dao::KaringDao(db_path_, upload_path_);
@@ -53,37 +129,31 @@ search_result search_service::search(const search_request& request) const {
   if (!sort.has_value()) return make_error(search_error::invalid_sort);
   const auto order_desc = parse_sort_order(request.order);
   if (!order_desc.has_value()) return make_error(search_error::invalid_order);
-
-  std::optional<int> is_file;
-  if (!request.type.empty()) {
-    is_file = parse_type_filter(request.type);
-    if (!is_file.has_value()) is_file.reset();
+  if (*sort == dao::SortField::rank && request.q.empty()) {
+    return make_error(search_error::invalid_sort, "sort=rank requires q");
   }
 
+  const auto mode = parse_match_mode(request.mode, trigram_);
+  if (!mode.has_value()) return make_error(search_error::invalid_mode);
+
+  auto filters = make_filters(request, *sort, *order_desc);
+  if (!apply_cursor(request.after, result, filters)) return make_error(search_error::invalid_cursor);
+  if (!apply_fields(request.fields, result, filters)) return make_error(search_error::invalid_fields);
+  filters.substring = *mode == karing::search::match_mode::substring;
+
   auto dao = make_dao();
   if (!request.q.empty()) {
-    auto qb = karing::search::build_fts_query(request.q);
+    auto qb = karing::search::build_fts_query(request.q, *mode);
     if (qb.err) return make_error(search_error::invalid_query, *qb.err);
 
-    if (is_file.has_value()) {
-      std::vector<dao::KaringRecord> tmp;
-      if (!dao.try_search_fts(qb.fts, result.limit, *sort, *order_desc, tmp)) {
-        return make_error(search_error::fts_unavailable);
-      }
-      for (auto& record : tmp) {
-        if (static_cast<int>(record.is_file) == *is_file) result.records.push_back(std::move(record));
-      }
-    } else if (!dao.try_search_fts(qb.fts, result.limit, *sort, *order_desc, result.records)) {
+    if (!dao.try_search_fts(qb.fts, result.limit, filters, result.records)) {
       return make_error(search_error::fts_unavailable);
     }
+    set_next_cursor(result, *sort);
     return result;
   }
 
-  if (is_file.has_value()) {
-    dao::KaringDao::Filters filters;
-    filters.is_file = *is_file;
-    filters.sort = *sort;
-    filters.order_desc = *order_desc;
+  if (has_filters(filters)) {
     result.records = dao.list_filtered(result.limit, filters);
     result.total = dao.count_filtered(filters);
   } else {
@@ -91,6 +161,7 @@ search_result search_service::search(const search_request& request) const {
     result.total = dao.count_active();
   }
   result.has_total = true;
+  set_next_cursor(result, *sort);
   return result;
 }
 
@@ -99,6 +170,7 @@ search_result search_service::live_search(const search_request& request) const {
 
   search_result result;
   result.live = true;
+  result.fields = karing::http::live_record_fields();
   result.limit = std::min(std::max(1, request.limit > 0 ? request.limit : std::min(max_limit_, 10)), max_limit_);
   result.sort = request.sort.empty() ? "id" : request.sort;
   result.order = request.order.empty() ? "desc" : request.order;
@@ -107,30 +179,74 @@ search_result search_service::live_search(const search_request& request) const {
   if (!sort.has_value()) return make_error(search_error::invalid_sort);
   const auto order_desc = parse_sort_order(request.order);
   if (!order_desc.has_value()) return make_error(search_error::invalid_order);
+  const auto mode = parse_match_mode(request.mode, trigram_);
+  if (!mode.has_value()) return make_error(search_error::invalid_mode);
 
-  std::optional<int> is_file;
-  if (!request.type.empty()) {
-    is_file = parse_type_filter(request.type);
-    if (!is_file.has_value()) is_file.reset();
-  }
+  auto filters = make_filters(request, *sort, *order_desc);
+  if (!apply_cursor(request.after, result, filters)) return make_error(search_error::invalid_cursor);
+  if (!apply_fields(request.fields, result, filters)) return make_error(search_error::invalid_fields);
+  filters.cancel = request.cancel;
+  filters.substring = *mode == karing::search::match_mode::substring;
 
-  const auto qb = karing::search::build_live_fts_query(request.q);
+  const auto qb = karing::search::build_live_fts_query(request.q, *mode);
   if (qb.err) return make_error(search_error::invalid_query, *qb.err);
 
   auto dao = make_dao();
-  if (is_file.has_value()) {
-    std::vector<dao::KaringRecord> tmp;
-    if (!dao.try_search_fts(qb.fts, result.limit, *sort, *order_desc, tmp)) {
-      return make_error(search_error::fts_unavailable);
+  auto& cache = live_search_cache::for_path(db_path_);
+  // Cursor pages and snippets depend on more than the hit list, so they always query SQLite.
+  const bool cacheable = cache.enabled() && !filters.after && !filters.snippet;
+  const bool refine = *sort != dao::SortField::rank;
+  std::string scope;
+  std::string query;
+  uint64_t generation = 0;
+  if (cacheable) {
+    scope = request.type + '\n' + request.mime + '\n' + result.sort + '\n' + result.order + '\n' +
+            (filters.substring ? "substring" : "word") + '\n' + std::to_string(result.limit) + '\n' +
+            (filters.projection.content ? std::to_string(filters.projection.preview_chars) : "-");
+    query = live_search_cache::normalize(request.q);
+    // Read before querying so a write that lands meanwhile leaves the entry stale, never the cache.
+    generation = dao.write_generation();
+    if (auto hit = cache.find(scope, query, *mode, refine, generation)) {
+      result.records = std::move(*hit);
+      set_next_cursor(result, *sort);
+      return result;
     }
-    for (auto& record : tmp) {
-      if (static_cast<int>(record.is_file) == *is_file) result.records.push_back(std::move(record));
-    }
-  } else if (!dao.try_search_fts(qb.fts, result.limit, *sort, *order_desc, result.records)) {
+  }
+
+  if (request.cancel && request.cancel->load()) return make_error(search_error::cancelled);
+  if (!dao.try_search_fts(qb.fts, result.limit, filters, result.records)) {
+    if (request.cancel && request.cancel->load()) return make_error(search_error::cancelled);
     return make_error(search_error::fts_unavailable);
   }
+  set_next_cursor(result, *sort);
+
+  if (cacheable) {
+    const bool complete = static_cast<int>(result.records.size()) < result.limit;
+    std::vector<std::string> texts;
+    if (complete && refine) {
+      std::vector<int> ids;
+      ids.reserve(result.records.size());
+      for (const auto& record : result.records) ids.push_back(record.id);
+      if (!dao.load_search_text(ids, karing::limits::kLiveCacheTextBytes, texts)) texts.clear();
+    }
+    cache.store(scope, query, generation, result.records, complete, std::move(texts));
+  }
 
   return result;
 }
 
+#if defined(KARING_USE_COROUTINES)
+drogon::Task<search_result> search_service::search_async(search_request request) const {
+  const bool queued = co_await executor::resume_on(executor::lane::read);
+  if (!queued) co_return make_error(search_error::busy);
+  co_return search(request);
+}
+
+drogon::Task<search_result> search_service::live_search_async(search_request request) const {
+  const bool queued = co_await executor::resume_on(executor::lane::read);
+  if (!queued) co_return make_error(search_error::busy);
+  co_return live_search(request);
+}
+#endif
+
 }  // namespace karing::services
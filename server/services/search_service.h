@@ -1,10 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "dao/karing_dao.h"
+#include "http/record_json.h"
+
+#if defined(KARING_USE_COROUTINES)
+#include <drogon/utils/coroutine.h>
+#endif
 
 namespace karing::services {
 
@@ -15,14 +21,32 @@ enum class search_error {
   invalid_order,
   invalid_query,
   fts_unavailable,
+  invalid_cursor,
+  invalid_mode,
+  invalid_fields,
+  busy,
+  // search_request::cancel was set before the query finished.
+  cancelled,
 };
 
 struct search_request {
   std::string q;
   int limit{0};
   std::string type;
+  // Exact mime type, or a prefix such as "image/" or "image/*".
+  std::string mime;
   std::string sort;
   std::string order;
+  // Cursor from a previous page's next_cursor.
+  std::string after;
+  // Return FTS snippets instead of content bodies; needs q.
+  bool snippet{false};
+  // "word" or "substring"; empty uses the server default.
+  std::string mode;
+  // Comma-separated record keys to return; empty returns the endpoint's default keys.
+  std::string fields;
+  // live_search only: setting this abandons the running query.
+  const std::atomic<bool>* cancel{nullptr};
 };
 
 struct search_result {
@@ -35,21 +59,35 @@ struct search_result {
   std::string sort{"id"};
   std::string order{"desc"};
   bool live{false};
+  // Set when the page is full; pass back as search_request::after.
+  std::optional<std::string> next_cursor;
+  // Keys to render for each record.
+  karing::http::record_fields fields;
 };
 
 class search_service {
  public:
-  search_service(std::string db_path, std::string upload_path, int max_limit);
+  // `trigram`: entries_fts_tri exists, so requests may ask for mode=substring;
+  // word stays the default either way.
+  search_service(std::string db_path, std::string upload_path, int max_limit, bool trigram = false);
 
   search_result search(const search_request& request) const;
   search_result live_search(const search_request& request) const;
 
+#if defined(KARING_USE_COROUTINES)
+  // Suspend the caller while the query runs on the executor's read lane;
+  // report search_error::busy when that lane is full.
+  drogon::Task<search_result> search_async(search_request request) const;
+  drogon::Task<search_result> live_search_async(search_request request) const;
+#endif
+
  private:
   karing::dao::KaringDao make_dao() const;
 
   std::string db_path_;
   std::string upload_path_;
   int max_limit_{0};
+  bool trigram_{false};
 };
 
 }  // namespace karing::services
@@ -0,0 +1,146 @@
+#include "compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+#if defined(KARING_HAVE_BROTLI)
+#include <brotli/encode.h>
+#endif
+
+#include "storage/gzip.h"
+#include "utils/limits.h"
+
+namespace karing::http {
+
+namespace {
+
+std::atomic<size_t>& configured_min_bytes() {
+  static std::atomic<size_t> min_bytes{compression_options{}.min_bytes};
+  return min_bytes;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+  return s;
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+         });
+}
+
+// q-value the header gives `coding`, falling back to "*"; 0 when neither is listed.
+double quality(std::string_view accept_encoding, std::string_view coding) {
+  double wildcard = 0.0;
+  size_t start = 0;
+  while (start <= accept_encoding.size()) {
+    const auto end = std::min(accept_encoding.find(',', start), accept_encoding.size());
+    const auto item = accept_encoding.substr(start, end - start);
+    start = end + 1;
+
+    const auto semicolon = item.find(';');
+    const auto name = trim(item.substr(0, semicolon));
+    double q = 1.0;
+    if (semicolon != std::string_view::npos) {
+      const auto param = trim(item.substr(semicolon + 1));
+      if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+        q = std::strtod(std::string(param.substr(2)).c_str(), nullptr);
+      }
+    }
+    if (equals_ignore_case(name, coding)) return q;
+    if (name == "*") wildcard = q;
+  }
+  return wildcard;
+}
+
+bool compressible(const std::string& content_type) {
+  const auto mime = content_type.substr(0, content_type.find(';'));
+  return mime.rfind("text/", 0) == 0 || mime.find("json") != std::string::npos ||
+         mime.find("xml") != std::string::npos || mime.find("javascript") != std::string::npos ||
+         mime.find("yaml") != std::string::npos || mime.find("toml") != std::string::npos;
+}
+
+#if defined(KARING_HAVE_BROTLI)
+bool brotli_compress(std::string_view data, std::string& out) {
+  size_t size = BrotliEncoderMaxCompressedSize(data.size());
+  if (size == 0) return false;
+  out.resize(size);
+  if (!BrotliEncoderCompress(karing::limits::kBrotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                             reinterpret_cast<const uint8_t*>(data.data()), &size,
+                             reinterpret_cast<uint8_t*>(out.data()))) {
+    return false;
+  }
+  out.resize(size);
+  return true;
+}
+#endif
+
+const char* coding_name(content_coding coding) {
+  return coding == content_coding::br ? "br" : "gzip";
+}
+
+}  // namespace
+
+void configure_compression(const compression_options& options) {
+  configured_min_bytes().store(options.min_bytes, std::memory_order_relaxed);
+}
+
+bool compression_enabled() {
+  return configured_min_bytes().load(std::memory_order_relaxed) != 0;
+}
+
+content_coding negotiate(std::string_view accept_encoding) {
+#if defined(KARING_HAVE_BROTLI)
+  const double br = quality(accept_encoding, "br");
+#else
+  const double br = 0.0;
+#endif
+  const double gzip = quality(accept_encoding, "gzip");
+  if (br <= 0.0 && gzip <= 0.0) return content_coding::identity;
+  return br >= gzip ? content_coding::br : content_coding::gzip;
+}
+
+bool accepts_gzip(const drogon::HttpRequestPtr& req) {
+  return quality(req->getHeader("accept-encoding"), "gzip") > 0.0;
+}
+
+void compress_response(const drogon::HttpRequestPtr& req, const drogon::HttpResponsePtr& resp) {
+  const auto min_bytes = configured_min_bytes().load(std::memory_order_relaxed);
+  if (!resp || min_bytes == 0 || resp->statusCode() != drogon::k200OK) return;
+  if (!resp->getHeader("content-encoding").empty()) return;
+  const auto body = resp->getBody();
+  if (body.size() < min_bytes || !compressible(resp->contentTypeString())) return;
+
+  // Caches must keep the variants apart even when this client gets identity.
+  resp->addHeader("Vary", "Accept-Encoding");
+  const auto coding = negotiate(req->getHeader("accept-encoding"));
+  std::string packed;
+  bool ok = false;
+  if (coding == content_coding::gzip) ok = karing::storage::gzip_compress(body, karing::limits::kGzipLevel, packed);
+#if defined(KARING_HAVE_BROTLI)
+  if (coding == content_coding::br) ok = brotli_compress(body, packed);
+#endif
+  if (!ok || packed.size() >= body.size()) return;
+  resp->setBody(std::move(packed));
+  set_content_encoding(resp, coding);
+}
+
+void set_content_encoding(const drogon::HttpResponsePtr& resp, content_coding coding) {
+  if (coding == content_coding::identity) return;
+  resp->addHeader("Content-Encoding", coding_name(coding));
+  resp->addHeader("Vary", "Accept-Encoding");
+  const auto etag = resp->getHeader("etag");
+  if (!etag.empty()) resp->addHeader("ETag", coded_entity_tag(etag, coding));
+}
+
+std::string coded_entity_tag(const std::string& etag, content_coding coding) {
+  if (coding == content_coding::identity || etag.size() < 2 || etag.back() != '"') return etag;
+  return etag.substr(0, etag.size() - 1) + "-" + coding_name(coding) + "\"";
+}
+
+}
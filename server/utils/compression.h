@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+
+namespace karing::http {
+
+enum class content_coding {
+  identity,
+  gzip,
+  br,
+};
+
+struct compression_options {
+  // Smallest body compressed per request; 0 turns response compression off.
+  size_t min_bytes{1024};
+};
+
+// Applies to every response after the call; set once at startup.
+void configure_compression(const compression_options& options);
+
+// Whether compress_response may encode bodies at all (min_bytes is not 0).
+bool compression_enabled();
+
+// The coding this build should use for an Accept-Encoding value: the highest
+// q among br (when built with brotli) and gzip, preferring br on a tie.
+content_coding negotiate(std::string_view accept_encoding);
+// Whether the request takes a gzip body, e.g. a file stored gzip-compressed.
+bool accepts_gzip(const drogon::HttpRequestPtr& req);
+
+// Compresses a 200 text or JSON body of at least min_bytes in place for the
+// request's Accept-Encoding. Called on the executor, never on the IO loop;
+// bodies that already carry a Content-Encoding are left alone.
+void compress_response(const drogon::HttpRequestPtr& req, const drogon::HttpResponsePtr& resp);
+// Marks a body that is already encoded, such as a gzip-stored upload; an ETag
+// on the response becomes coded_entity_tag of it.
+void set_content_encoding(const drogon::HttpResponsePtr& resp, content_coding coding);
+// ETag of the `coding` encoding of the representation tagged `etag`, e.g.
+// "abc" -> "abc-gzip", so strong tags stay distinct per byte sequence.
+std::string coded_entity_tag(const std::string& etag, content_coding coding);
+
+}
@@ -0,0 +1,157 @@
+#include "utils/executor.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace karing::executor {
+
+namespace {
+
+using std::chrono::steady_clock;
+
+struct queued_task {
+  steady_clock::time_point enqueued;
+  std::function<void()> work;
+};
+
+struct lane_queue {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<queued_task> tasks;
+  std::vector<std::thread> workers;
+  bool stopping{false};
+  lane_stats stats;
+
+  void run() {
+    for (;;) {
+      queued_task task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        const auto waited =
+            std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - task.enqueued).count();
+        stats.wait_us_total += waited;
+        stats.wait_us_max = std::max<long long>(stats.wait_us_max, waited);
+        ++stats.active;
+      }
+      try {
+        task.work();
+      } catch (...) {
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      --stats.active;
+      ++stats.completed;
+    }
+  }
+};
+
+class executor {
+ public:
+  explicit executor(const executor_options& options) {
+    start(lanes_[index(lane::read)], options.read_threads, options.max_queue);
+    start(lanes_[index(lane::write)], options.write_threads, options.max_queue);
+    start(lanes_[index(lane::file)], options.file_threads, options.max_queue);
+  }
+
+  ~executor() { stop(); }
+
+  bool submit(lane which, std::function<void()> work) {
+    auto& queue = lanes_[index(which)];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.stopping || static_cast<int>(queue.tasks.size()) >= queue.stats.max_queue) {
+        ++queue.stats.rejected;
+        return false;
+      }
+      queue.tasks.push_back({steady_clock::now(), std::move(work)});
+      ++queue.stats.submitted;
+    }
+    queue.wake.notify_one();
+    return true;
+  }
+
+  lane_stats stats(lane which) {
+    auto& queue = lanes_[index(which)];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    lane_stats out = queue.stats;
+    out.queued = static_cast<int>(queue.tasks.size());
+    return out;
+  }
+
+  void stop() {
+    for (auto& queue : lanes_) {
+      {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.stopping = true;
+      }
+      queue.wake.notify_all();
+    }
+    for (auto& queue : lanes_) {
+      for (auto& worker : queue.workers) {
+        if (worker.joinable()) worker.join();
+      }
+      queue.workers.clear();
+    }
+  }
+
+ private:
+  static std::size_t index(lane which) { return static_cast<std::size_t>(which); }
+
+  static void start(lane_queue& queue, int threads, int max_queue) {
+    queue.stats.threads = std::max(1, threads);
+    queue.stats.max_queue = std::max(1, max_queue);
+    for (int i = 0; i < queue.stats.threads; ++i) queue.workers.emplace_back([&queue] { queue.run(); });
+  }
+
+  std::array<lane_queue, 3> lanes_;
+};
+
+std::mutex& instance_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+executor_options& configured_options() {
+  static executor_options options;
+  return options;
+}
+
+executor& instance() {
+  static executor shared([] {
+    std::lock_guard<std::mutex> lock(instance_mutex());
+    return configured_options();
+  }());
+  return shared;
+}
+
+}  // namespace
+
+void configure(const executor_options& options) {
+  std::lock_guard<std::mutex> lock(instance_mutex());
+  configured_options() = options;
+}
+
+bool submit(lane which, std::function<void()> task) {
+  return instance().submit(which, std::move(task));
+}
+
+lane_stats stats(lane which) {
+  return instance().stats(which);
+}
+
+void stop() {
+  instance().stop();
+}
+
+}  // namespace karing::executor
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#if defined(KARING_USE_COROUTINES)
+#include <coroutine>
+#endif
+
+namespace karing::executor {
+
+// Separate queues so slow uploads cannot starve searches and vice versa.
+enum class lane {
+  read,
+  write,
+  file,
+};
+
+struct executor_options {
+  int read_threads{4};
+  int write_threads{2};
+  int file_threads{2};
+  // Queued tasks per lane before submit() starts rejecting.
+  int max_queue{256};
+};
+
+struct lane_stats {
+  int threads{0};
+  int queued{0};
+  int active{0};
+  int max_queue{0};
+  long long submitted{0};
+  long long completed{0};
+  long long rejected{0};
+  long long wait_us_total{0};
+  long long wait_us_max{0};
+};
+
+// Applies before the first submit(); set once at startup.
+void configure(const executor_options& options);
+
+// Queues `task` on `which`; false if the lane is full or stopped.
+bool submit(lane which, std::function<void()> task);
+
+lane_stats stats(lane which);
+
+// Runs what is already queued, then joins the worker threads.
+void stop();
+
+#if defined(KARING_USE_COROUTINES)
+// `co_await resume_on(lane)` continues the coroutine on a lane thread; it
+// yields false and keeps running on the caller if the lane is full.
+struct lane_awaiter {
+  lane which;
+  bool queued{false};
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) {
+    // The lane may resume the coroutine before submit() returns, so set the flag first.
+    queued = true;
+    if (submit(which, [handle] { handle.resume(); })) return true;
+    queued = false;
+    return false;
+  }
+  bool await_resume() const noexcept { return queued; }
+};
+
+inline lane_awaiter resume_on(lane which) {
+  return lane_awaiter{which};
+}
+#endif
+
+}  // namespace karing::executor
@@ -6,17 +6,29 @@ using drogon::HttpResponse;
 using drogon::HttpResponsePtr;
 using drogon::HttpStatusCode;
 
-HttpResponsePtr ok(Json::Value data, Json::Value meta) {
+Json::Value ok_body(Json::Value data, Json::Value meta) {
   Json::Value root;
   root["success"] = true;
   root["message"] = "OK";
   root["data"] = std::move(data);
   if (!meta.isNull()) root["meta"] = std::move(meta);
-  auto resp = HttpResponse::newHttpJsonResponse(root);
+  return root;
+}
+
+HttpResponsePtr ok(Json::Value data, Json::Value meta) {
+  auto resp = HttpResponse::newHttpJsonResponse(ok_body(std::move(data), std::move(meta)));
   resp->setStatusCode(HttpStatusCode::k200OK);
   return resp;
 }
 
+HttpResponsePtr json_text(std::string body, HttpStatusCode status) {
+  auto resp = HttpResponse::newHttpResponse();
+  resp->setStatusCode(status);
+  resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+  resp->setBody(std::move(body));
+  return resp;
+}
+
 HttpResponsePtr created(int id) {
   Json::Value root; root["success"] = true; root["message"] = "Created"; root["id"] = id;
   auto resp = HttpResponse::newHttpJsonResponse(root);
@@ -24,16 +36,20 @@ HttpResponsePtr created(int id) {
   return resp;
 }
 
-HttpResponsePtr error(HttpStatusCode status,
-                      const std::string& code,
-                      const std::string& message,
-                      Json::Value details) {
+Json::Value error_body(const std::string& code, const std::string& message, Json::Value details) {
   Json::Value root;
   root["success"] = false;
   root["code"] = code;
   root["message"] = message;
   if (!details.isNull()) root["details"] = std::move(details);
-  auto resp = HttpResponse::newHttpJsonResponse(root);
+  return root;
+}
+
+HttpResponsePtr error(HttpStatusCode status,
+                      const std::string& code,
+                      const std::string& message,
+                      Json::Value details) {
+  auto resp = HttpResponse::newHttpJsonResponse(error_body(code, message, std::move(details)));
   resp->setStatusCode(status);
   return resp;
 }
@@ -7,6 +7,10 @@ namespace karing::http {
 
 // Standard JSON success response: { success: true, message: "OK", data, meta? }
 drogon::HttpResponsePtr ok(Json::Value data, Json::Value meta = Json::nullValue);
+Json::Value ok_body(Json::Value data, Json::Value meta = Json::nullValue);
+
+// JSON response around a body that is already serialized, e.g. by json_writer.
+drogon::HttpResponsePtr json_text(std::string body, drogon::HttpStatusCode status = drogon::k200OK);
 
 // 201 Created: { success: true, message: "Created", id }
 drogon::HttpResponsePtr created(int id);
@@ -16,5 +20,6 @@ drogon::HttpResponsePtr error(drogon::HttpStatusCode status,
                               const std::string& code,
                               const std::string& message,
                               Json::Value details = Json::nullValue);
+Json::Value error_body(const std::string& code, const std::string& message, Json::Value details = Json::nullValue);
 
 }
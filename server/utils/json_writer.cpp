@@ -0,0 +1,143 @@
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace karing::http {
+
+namespace {
+
+// Size of the last body written on this thread, capped so one huge page does
+// not pin memory; executor threads serve pages of similar size, so the next
+// body rarely has to grow its buffer.
+constexpr size_t kMaxReserve = 1 << 20;
+thread_local size_t reserve_hint = 4096;
+
+void append_escaped(std::string& out, std::string_view text) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  out.push_back('"');
+  size_t plain = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out.append(text.data() + plain, i - plain);
+    plain = i + 1;
+    switch (c) {
+      case '"': out.append("\\\""); break;
+      case '\\': out.append("\\\\"); break;
+      case '\b': out.append("\\b"); break;
+      case '\f': out.append("\\f"); break;
+      case '\n': out.append("\\n"); break;
+      case '\r': out.append("\\r"); break;
+      case '\t': out.append("\\t"); break;
+      default:
+        out.append("\\u00");
+        out.push_back(kHex[c >> 4]);
+        out.push_back(kHex[c & 0xf]);
+    }
+  }
+  out.append(text.data() + plain, text.size() - plain);
+  out.push_back('"');
+}
+
+}  // namespace
+
+json_writer::json_writer() {
+  out_.reserve(reserve_hint);
+}
+
+void json_writer::separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (first_.empty()) return;
+  if (!first_.back()) out_.push_back(',');
+  first_.back() = false;
+}
+
+json_writer& json_writer::begin_object() {
+  separate();
+  out_.push_back('{');
+  first_.push_back(true);
+  return *this;
+}
+
+json_writer& json_writer::end_object() {
+  out_.push_back('}');
+  first_.pop_back();
+  return *this;
+}
+
+json_writer& json_writer::begin_array() {
+  separate();
+  out_.push_back('[');
+  first_.push_back(true);
+  return *this;
+}
+
+json_writer& json_writer::end_array() {
+  out_.push_back(']');
+  first_.pop_back();
+  return *this;
+}
+
+json_writer& json_writer::key(std::string_view name) {
+  separate();
+  append_escaped(out_, name);
+  out_.push_back(':');
+  after_key_ = true;
+  return *this;
+}
+
+json_writer& json_writer::value(std::string_view text) {
+  separate();
+  append_escaped(out_, text);
+  return *this;
+}
+
+json_writer& json_writer::value(bool flag) {
+  separate();
+  out_.append(flag ? "true" : "false");
+  return *this;
+}
+
+json_writer& json_writer::value(int64_t number) {
+  separate();
+  out_.append(std::to_string(number));
+  return *this;
+}
+
+json_writer& json_writer::value(double number) {
+  separate();
+  if (!std::isfinite(number)) {
+    out_.append("null");
+    return *this;
+  }
+  // Same precision as jsoncpp, which keeps integral doubles recognizable.
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+  const std::string_view text(buffer, static_cast<size_t>(std::max(0, size)));
+  out_.append(text);
+  if (text.find_first_of(".e") == std::string_view::npos) out_.append(".0");
+  return *this;
+}
+
+json_writer& json_writer::value(const Json::Value& tree) {
+  separate();
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  builder["emitUTF8"] = true;
+  out_.append(Json::writeString(builder, tree));
+  return *this;
+}
+
+std::string json_writer::take() {
+  reserve_hint = std::clamp<size_t>(out_.size() + out_.size() / 8, 256, kMaxReserve);
+  first_.clear();
+  after_key_ = false;
+  return std::move(out_);
+}
+
+}
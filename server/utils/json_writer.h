@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <json/json.h>
+
+namespace karing::http {
+
+// Compact JSON written straight into one string, for bodies too large to go
+// through a Json::Value tree. Commas are inserted automatically; keys and
+// values must alternate inside objects. Strings are emitted as UTF-8, as
+// Drogon's JSON responses do.
+class json_writer {
+ public:
+  // Reserves what the previous body written on this thread needed.
+  json_writer();
+
+  json_writer& begin_object();
+  json_writer& end_object();
+  json_writer& begin_array();
+  json_writer& end_array();
+  json_writer& key(std::string_view name);
+
+  json_writer& value(std::string_view text);
+  json_writer& value(const std::string& text) { return value(std::string_view(text)); }
+  json_writer& value(const char* text) { return value(std::string_view(text)); }
+  json_writer& value(bool flag);
+  json_writer& value(int number) { return value(static_cast<int64_t>(number)); }
+  json_writer& value(int64_t number);
+  json_writer& value(double number);
+  // Small values such as meta blocks go through jsoncpp.
+  json_writer& value(const Json::Value& tree);
+
+  // The finished body; the writer is empty afterwards.
+  std::string take();
+
+ private:
+  void separate();
+
+  std::string out_;
+  // One entry per open container: true until its first element is written.
+  std::vector<bool> first_;
+  bool after_key_{false};
+};
+
+}
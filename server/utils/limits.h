@@ -4,6 +4,13 @@ namespace karing::limits {
 
 inline constexpr int kDefaultLimit = 100;
 inline constexpr int kMaxLimit = 1000;
+// Characters of content_text kept for /search/live previews.
+inline constexpr int kLivePreviewChars = 120;
+// Recent /search/live results kept in memory; refining a cached prefix scans at
+// most kLiveCacheTextBytes of hit text per entry.
+inline constexpr int kDefaultLiveCacheEntries = 256;
+inline constexpr int kMaxLiveCacheEntries = 65536;
+inline constexpr int kLiveCacheTextBytes = 64 * 1024;
 
 inline constexpr int kBytesPerMb = 1024 * 1024;
 
@@ -17,4 +24,53 @@ inline constexpr int kMaxTextMb = 10;
 inline constexpr int kDefaultMaxTextBytes = kDefaultMaxTextMb * kBytesPerMb;
 inline constexpr int kMaxTextBytes = kMaxTextMb * kBytesPerMb;
 
+inline constexpr int kDefaultDbPoolSize = 4;
+inline constexpr int kMaxDbPoolSize = 64;
+
+inline constexpr int kDefaultReadThreads = 4;
+inline constexpr int kDefaultWriteThreads = 2;
+inline constexpr int kDefaultFileThreads = 2;
+inline constexpr int kMaxExecutorThreads = 64;
+inline constexpr int kDefaultExecutorQueue = 256;
+inline constexpr int kMaxExecutorQueue = 65536;
+
+inline constexpr int kDefaultSqliteMmapMb = 256;
+inline constexpr int kMaxSqliteMmapMb = 65536;
+inline constexpr int kDefaultSqliteCacheMb = 16;
+inline constexpr int kMaxSqliteCacheMb = 4096;
+
+// FTS5 rejects prefix index lengths above 999; live terms rarely need more than a few.
+inline constexpr int kMaxFtsPrefixLength = 999;
+// Leading KiB of each uploaded text file indexed for search.
+inline constexpr int kDefaultFtsBodyKb = 256;
+inline constexpr int kMaxFtsBodyKb = 10 * 1024;
+// FTS5 segment merging: automerge 0 leaves merging to the idle merge steps.
+inline constexpr int kDefaultFtsAutomerge = 4;
+inline constexpr int kMaxFtsAutomerge = 16;
+inline constexpr int kDefaultFtsCrisismerge = 16;
+inline constexpr int kMaxFtsCrisismerge = 255;
+inline constexpr int kDefaultFtsMergeIdleSeconds = 10;
+inline constexpr int kMaxFtsMergeIdleSeconds = 24 * 60 * 60;
+inline constexpr int kFtsMaintenanceIntervalMs = 1000;
+inline constexpr int kFtsMergePages = 256;
+
+// Responses smaller than this go out uncompressed; 0 turns compression off.
+inline constexpr int kDefaultCompressMinBytes = 1024;
+inline constexpr int kMaxCompressMinBytes = 64 * 1024 * 1024;
+// Per-request levels favour speed; stored uploads are compressed at level 9 once.
+inline constexpr int kGzipLevel = 6;
+inline constexpr int kBrotliQuality = 5;
+
+// Comment frames on idle /events streams; a failed one ends the subscription.
+inline constexpr int kSseKeepAliveSeconds = 15;
+
+inline constexpr int kDefaultWalAutocheckpoint = 1000;
+inline constexpr int kWalCheckpointIntervalMs = 1000;
+inline constexpr int kWalTruncateIdleSeconds = 30;
+
+inline constexpr int kDefaultWriteBatchMs = 1;
+inline constexpr int kMaxWriteBatchMs = 100;
+inline constexpr int kDefaultWriteBatchSize = 64;
+inline constexpr int kMaxWriteBatchSize = 1024;
+
 }  // namespace karing::limits
@@ -1,6 +1,7 @@
 #include "utils/options.h"
 
 #include <cstdlib>
+#include <sstream>
 #include <string>
 
 #include "utils/limits.h"
@@ -17,6 +18,37 @@ void parse_int(const char* raw, int& out) {
   }
 }
 
+// Rewrites "2,3" or "2 3" as "2 3" and "0" as ""; false on anything else.
+bool normalize_fts_prefix(std::string& value) {
+  for (auto& c : value) {
+    if (c == ',') c = ' ';
+  }
+  std::istringstream in(value);
+  std::string normalized;
+  std::string token;
+  bool disabled = false;
+  while (in >> token) {
+    int length = 0;
+    try {
+      size_t used = 0;
+      length = std::stoi(token, &used);
+      if (used != token.size()) return false;
+    } catch (...) {
+      return false;
+    }
+    if (length == 0) {
+      disabled = true;
+      continue;
+    }
+    if (length < 1 || length > karing::limits::kMaxFtsPrefixLength) return false;
+    if (!normalized.empty()) normalized.push_back(' ');
+    normalized += std::to_string(length);
+  }
+  if (disabled && !normalized.empty()) return false;
+  value = normalized;
+  return true;
+}
+
 }  // namespace
 
 server_options parse(int argc, char** argv) {
@@ -31,6 +63,28 @@ server_options parse(int argc, char** argv) {
   parse_int(std::getenv("KARING_LIMIT"), out.limit);
   parse_int(std::getenv("KARING_MAX_FILE"), out.max_file_bytes);
   parse_int(std::getenv("KARING_MAX_TEXT"), out.max_text_bytes);
+  parse_int(std::getenv("KARING_DB_POOL_SIZE"), out.db_pool_size);
+  parse_int(std::getenv("KARING_READ_THREADS"), out.read_threads);
+  parse_int(std::getenv("KARING_WRITE_THREADS"), out.write_threads);
+  parse_int(std::getenv("KARING_FILE_THREADS"), out.file_threads);
+  parse_int(std::getenv("KARING_EXECUTOR_QUEUE"), out.executor_queue);
+  parse_int(std::getenv("KARING_SQLITE_MMAP_MB"), out.sqlite_mmap_mb);
+  parse_int(std::getenv("KARING_SQLITE_CACHE_MB"), out.sqlite_cache_mb);
+  parse_int(std::getenv("KARING_WAL_AUTOCHECKPOINT"), out.wal_autocheckpoint);
+  parse_int(std::getenv("KARING_WRITE_BATCH_MS"), out.write_batch_ms);
+  parse_int(std::getenv("KARING_WRITE_BATCH_SIZE"), out.write_batch_size);
+  parse_int(std::getenv("KARING_LIVE_CACHE_ENTRIES"), out.live_cache_entries);
+  parse_int(std::getenv("KARING_COMPRESS_MIN_BYTES"), out.compress_min_bytes);
+  int store_gzip = 0;
+  parse_int(std::getenv("KARING_STORE_GZIP"), store_gzip);
+  out.store_gzip = store_gzip != 0;
+  parse_int(std::getenv("KARING_FTS_BODY_KB"), out.fts_body_kb);
+  parse_int(std::getenv("KARING_FTS_AUTOMERGE"), out.fts_automerge);
+  parse_int(std::getenv("KARING_FTS_CRISISMERGE"), out.fts_crisismerge);
+  parse_int(std::getenv("KARING_FTS_MERGE_IDLE"), out.fts_merge_idle_seconds);
+  if (const char* env = std::getenv("KARING_JOURNAL_MODE"); env && *env) out.journal_mode = env;
+  if (const char* env = std::getenv("KARING_FTS_TOKENIZER"); env && *env) out.fts_tokenizer = env;
+  if (const char* env = std::getenv("KARING_FTS_PREFIX"); env && *env) out.fts_prefix = env;
 
   if (const char* env = std::getenv("KARING_UPLOAD_PATH"); env && *env) out.upload_path = env;
   if (const char* env = std::getenv("KARING_BASE_PATH"); env && *env) out.base_path = env;
@@ -79,6 +133,86 @@ server_options parse(int argc, char** argv) {
       }
       continue;
     }
+    if (arg == "--db-pool-size" && i + 1 < argc) {
+      parse_int(argv[++i], out.db_pool_size);
+      continue;
+    }
+    if (arg == "--read-threads" && i + 1 < argc) {
+      parse_int(argv[++i], out.read_threads);
+      continue;
+    }
+    if (arg == "--write-threads" && i + 1 < argc) {
+      parse_int(argv[++i], out.write_threads);
+      continue;
+    }
+    if (arg == "--file-threads" && i + 1 < argc) {
+      parse_int(argv[++i], out.file_threads);
+      continue;
+    }
+    if (arg == "--executor-queue" && i + 1 < argc) {
+      parse_int(argv[++i], out.executor_queue);
+      continue;
+    }
+    if (arg == "--sqlite-mmap-mb" && i + 1 < argc) {
+      parse_int(argv[++i], out.sqlite_mmap_mb);
+      continue;
+    }
+    if (arg == "--sqlite-cache-mb" && i + 1 < argc) {
+      parse_int(argv[++i], out.sqlite_cache_mb);
+      continue;
+    }
+    if (arg == "--journal-mode" && i + 1 < argc) {
+      out.journal_mode = argv[++i];
+      continue;
+    }
+    if (arg == "--fts-tokenizer" && i + 1 < argc) {
+      out.fts_tokenizer = argv[++i];
+      continue;
+    }
+    if (arg == "--fts-prefix" && i + 1 < argc) {
+      out.fts_prefix = argv[++i];
+      continue;
+    }
+    if (arg == "--fts-body-kb" && i + 1 < argc) {
+      parse_int(argv[++i], out.fts_body_kb);
+      continue;
+    }
+    if (arg == "--fts-automerge" && i + 1 < argc) {
+      parse_int(argv[++i], out.fts_automerge);
+      continue;
+    }
+    if (arg == "--fts-crisismerge" && i + 1 < argc) {
+      parse_int(argv[++i], out.fts_crisismerge);
+      continue;
+    }
+    if (arg == "--fts-merge-idle" && i + 1 < argc) {
+      parse_int(argv[++i], out.fts_merge_idle_seconds);
+      continue;
+    }
+    if (arg == "--wal-autocheckpoint" && i + 1 < argc) {
+      parse_int(argv[++i], out.wal_autocheckpoint);
+      continue;
+    }
+    if (arg == "--write-batch-ms" && i + 1 < argc) {
+      parse_int(argv[++i], out.write_batch_ms);
+      continue;
+    }
+    if (arg == "--write-batch-size" && i + 1 < argc) {
+      parse_int(argv[++i], out.write_batch_size);
+      continue;
+    }
+    if (arg == "--live-cache-entries" && i + 1 < argc) {
+      parse_int(argv[++i], out.live_cache_entries);
+      continue;
+    }
+    if (arg == "--compress-min-bytes" && i + 1 < argc) {
+      parse_int(argv[++i], out.compress_min_bytes);
+      continue;
+    }
+    if (arg == "--store-gzip") {
+      out.store_gzip = true;
+      continue;
+    }
     if (arg == "--upload-path" && i + 1 < argc) {
       out.upload_path = argv[++i];
       continue;
@@ -102,6 +236,18 @@ server_options parse(int argc, char** argv) {
     out.action_kind = action::error;
     out.error = "--check-db and --init-db cannot be used together";
   }
+  if (out.action_kind == action::run && out.journal_mode != "wal" && out.journal_mode != "delete") {
+    out.action_kind = action::error;
+    out.error = "--journal-mode must be wal or delete";
+  }
+  if (out.action_kind == action::run && out.fts_tokenizer != "unicode61" && out.fts_tokenizer != "trigram") {
+    out.action_kind = action::error;
+    out.error = "--fts-tokenizer must be unicode61 or trigram";
+  }
+  if (out.action_kind == action::run && !normalize_fts_prefix(out.fts_prefix)) {
+    out.action_kind = action::error;
+    out.error = "--fts-prefix must list lengths from 1 to " + std::to_string(karing::limits::kMaxFtsPrefixLength) + ", or 0";
+  }
 
   return out;
 }
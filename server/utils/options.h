@@ -28,6 +28,33 @@ struct server_options {
   int limit{100};
   int max_file_bytes{karing::limits::kDefaultMaxFileMb};
   int max_text_bytes{karing::limits::kDefaultMaxTextMb};
+  int db_pool_size{karing::limits::kDefaultDbPoolSize};
+  int read_threads{karing::limits::kDefaultReadThreads};
+  int write_threads{karing::limits::kDefaultWriteThreads};
+  int file_threads{karing::limits::kDefaultFileThreads};
+  int executor_queue{karing::limits::kDefaultExecutorQueue};
+  int sqlite_mmap_mb{karing::limits::kDefaultSqliteMmapMb};
+  int sqlite_cache_mb{karing::limits::kDefaultSqliteCacheMb};
+  std::string journal_mode{"wal"};
+  // "trigram" also builds entries_fts_tri, which mode=substring searches read.
+  std::string fts_tokenizer{"unicode61"};
+  // Prefix index lengths for entries_fts, space separated; "0" disables.
+  std::string fts_prefix{"2 3"};
+  // Leading KiB of uploaded text files indexed for body search; 0 disables.
+  int fts_body_kb{karing::limits::kDefaultFtsBodyKb};
+  int fts_automerge{karing::limits::kDefaultFtsAutomerge};
+  int fts_crisismerge{karing::limits::kDefaultFtsCrisismerge};
+  // Seconds without writes before FTS segments are merged; 0 disables idle merging.
+  int fts_merge_idle_seconds{karing::limits::kDefaultFtsMergeIdleSeconds};
+  int wal_autocheckpoint{karing::limits::kDefaultWalAutocheckpoint};
+  int write_batch_ms{karing::limits::kDefaultWriteBatchMs};
+  int write_batch_size{karing::limits::kDefaultWriteBatchSize};
+  // Live-search results cached in memory; 0 disables the cache.
+  int live_cache_entries{karing::limits::kDefaultLiveCacheEntries};
+  // Smallest text or JSON response sent with gzip/br; 0 disables compression.
+  int compress_min_bytes{karing::limits::kDefaultCompressMinBytes};
+  // Keep text-like uploads gzip-compressed on disk.
+  bool store_gzip{false};
 };
 
 server_options parse(int argc, char** argv);
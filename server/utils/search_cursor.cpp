@@ -0,0 +1,105 @@
+#include "search_cursor.h"
+
+#include <array>
+#include <vector>
+
+namespace karing::search {
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+std::string base64url_encode(const std::string& in) {
+  std::string out;
+  out.reserve((in.size() + 2) / 3 * 4);
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (unsigned char c : in) {
+    buffer = (buffer << 8) | c;
+    bits += 8;
+    while (bits >= 6) {
+      bits -= 6;
+      out.push_back(kAlphabet[(buffer >> bits) & 0x3F]);
+    }
+  }
+  if (bits > 0) out.push_back(kAlphabet[(buffer << (6 - bits)) & 0x3F]);
+  return out;
+}
+
+std::optional<std::string> base64url_decode(const std::string& in) {
+  std::array<int, 256> table{};
+  table.fill(-1);
+  for (int i = 0; i < 64; ++i) table[static_cast<unsigned char>(kAlphabet[i])] = i;
+  std::string out;
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (unsigned char c : in) {
+    if (c == '=') break;
+    const int value = table[c];
+    if (value < 0) return std::nullopt;
+    buffer = (buffer << 6) | static_cast<uint32_t>(value);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+    }
+  }
+  return out;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+  std::vector<std::string> parts;
+  std::string current;
+  for (char c : s) {
+    if (c == sep) {
+      parts.push_back(current);
+      current.clear();
+    } else {
+      current.push_back(c);
+    }
+  }
+  parts.push_back(current);
+  return parts;
+}
+
+std::optional<long long> parse_number(const std::string& s) {
+  if (s.empty() || s.size() > 20) return std::nullopt;
+  size_t pos = 0;
+  try {
+    const long long value = std::stoll(s, &pos);
+    if (pos != s.size()) return std::nullopt;
+    return value;
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+}  // namespace
+
+std::string encode_cursor(const Cursor& cursor) {
+  const std::string value = cursor.value.has_value() ? std::to_string(*cursor.value) : "n";
+  return base64url_encode("v1." + cursor.sort + "." + cursor.order + "." + value + "." + std::to_string(cursor.id));
+}
+
+std::optional<Cursor> decode_cursor(const std::string& token) {
+  if (token.empty() || token.size() > 256) return std::nullopt;
+  const auto raw = base64url_decode(token);
+  if (!raw) return std::nullopt;
+  const auto parts = split(*raw, '.');
+  if (parts.size() != 5 || parts[0] != "v1" || parts[1].empty() || parts[2].empty()) return std::nullopt;
+
+  Cursor cursor;
+  cursor.sort = parts[1];
+  cursor.order = parts[2];
+  if (parts[3] != "n") {
+    const auto value = parse_number(parts[3]);
+    if (!value) return std::nullopt;
+    cursor.value = *value;
+  }
+  const auto id = parse_number(parts[4]);
+  if (!id || *id < 1 || *id > INT32_MAX) return std::nullopt;
+  cursor.id = static_cast<int>(*id);
+  return cursor;
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace karing::search {
+
+// Position after the last row of a page: the sort column value (absent for
+// NULL updated_at) and id, tied to the sort and order it was issued for.
+struct Cursor {
+  std::string sort;
+  std::string order;
+  std::optional<int64_t> value;
+  int id{0};
+};
+
+// Opaque base64url token for `meta.next_cursor` / `after=`.
+std::string encode_cursor(const Cursor& cursor);
+std::optional<Cursor> decode_cursor(const std::string& token);
+
+}
@@ -22,6 +22,20 @@ static std::string quote_term(const std::string& t) {
   return out;
 }
 
+static size_t utf8_length(const std::string& s) {
+  size_t n = 0;
+  for (unsigned char c : s) {
+    if ((c & 0xC0) != 0x80) ++n;
+  }
+  return n;
+}
+
+static bool too_short_for_trigram(const std::string& term) {
+  std::string bare = term;
+  if (!bare.empty() && bare.back() == '*') bare.pop_back();
+  return utf8_length(bare) < 3;
+}
+
 static std::vector<std::string> split_terms(const std::string& raw) {
   std::vector<std::string> terms;
   std::string current;
@@ -39,7 +53,7 @@ static std::vector<std::string> split_terms(const std::string& raw) {
   return terms;
 }
 
-QueryBuild build_fts_query(const std::string& raw) {
+QueryBuild build_fts_query(const std::string& raw, match_mode mode) {
   QueryBuild qb{};
   std::string s = trim(raw);
   if (s.empty()) { qb.err = "empty"; return qb; }
@@ -76,6 +90,14 @@ QueryBuild build_fts_query(const std::string& raw) {
   }
   if (inQuote) { qb.err = "unclosed quote"; return qb; }
   if (!cur.empty()) parts.push_back(quote_term(cur));
+  if (mode == match_mode::substring) {
+    for (const auto& p : parts) {
+      if (p != "OR" && too_short_for_trigram(p.substr(1, p.size() - 2))) {
+        qb.err = "substring terms need at least 3 characters";
+        return qb;
+      }
+    }
+  }
 
   // Build final query: insert AND between adjacent terms not separated by OR
   std::string out;
@@ -94,7 +116,7 @@ QueryBuild build_fts_query(const std::string& raw) {
   return qb;
 }
 
-QueryBuild build_live_fts_query(const std::string& raw) {
+QueryBuild build_live_fts_query(const std::string& raw, match_mode mode) {
   QueryBuild qb{};
   std::string s = trim(raw);
   if (s.empty()) {
@@ -111,9 +133,14 @@ QueryBuild build_live_fts_query(const std::string& raw) {
 
   std::string out;
   for (size_t i = 0; i < terms.size(); ++i) {
+    if (mode == match_mode::substring && too_short_for_trigram(terms[i])) {
+      qb.err = "substring terms need at least 3 characters";
+      return qb;
+    }
     if (i > 0) out.append(" AND ");
     out.append(quote_term(terms[i]));
-    out.push_back('*');
+    // Trigram phrases already match inside words.
+    if (mode == match_mode::word) out.push_back('*');
   }
   qb.fts = std::move(out);
   return qb;
@@ -4,6 +4,11 @@
 
 namespace karing::search {
 
+enum class match_mode {
+  word,       // entries_fts, unicode61 tokens
+  substring,  // entries_fts_tri, trigram tokens
+};
+
 struct QueryBuild {
   std::string fts;                 // FTS5 MATCH string
   std::optional<std::string> err;  // error message if invalid
@@ -17,7 +22,9 @@ struct QueryBuild {
 // - Prefix: trailing '*' on a term (e.g., foo*)
 // - Any term is quoted if it contains non-word characters
 // - Very long inputs are truncated to a sensible length
-QueryBuild build_fts_query(const std::string& raw);
-QueryBuild build_live_fts_query(const std::string& raw);
+// In substring mode every term matches anywhere in a word and needs at least
+// three characters, the shortest string the trigram index can look up.
+QueryBuild build_fts_query(const std::string& raw, match_mode mode = match_mode::word);
+QueryBuild build_live_fts_query(const std::string& raw, match_mode mode = match_mode::word);
 
 }
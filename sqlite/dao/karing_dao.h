@@ -1,5 +1,9 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 #include <optional>
 
@@ -9,6 +13,8 @@ enum class SortField {
   id,
   stored_at,
   updated_at,
+  // bm25 relevance; FTS searches only.
+  rank,
 };
 
 struct KaringRecord {
@@ -19,6 +25,24 @@ struct KaringRecord {
   std::string mime;
   int64_t created_at{};
   std::optional<int64_t> updated_at;
+  // Stored bytes of the text body or file.
+  int64_t size_bytes{};
+  // Per-slot write counter; never repeats for an id, unlike the second-resolution timestamps.
+  int64_t revision{};
+  // Relevance (negated bm25, higher is better); set by SortField::rank searches.
+  std::optional<double> score;
+  // FTS snippet of the best-matching column (text, filename or indexed file
+  // body) and its matched byte ranges (offset, length); content is left empty when set.
+  std::optional<std::string> snippet;
+  std::vector<std::pair<int, int>> highlights;
+};
+
+// Payload read for each record of a list, search or get_by_id; ids, kinds,
+// filenames, mime types, sizes and timestamps are always read.
+struct Projection {
+  // content_text, or only its first preview_chars characters when > 0.
+  bool content{true};
+  int preview_chars{0};
 };
 
 class KaringDao {
@@ -43,8 +67,12 @@ class KaringDao {
 
   // Fetch single by id.
   std::optional<KaringRecord> get_by_id(int id);
+  std::optional<KaringRecord> get_by_id(int id, const Projection& projection);
   // Fetch file blob by id (active + is_file=1).
   bool get_file_blob(int id, std::string& out_mime, std::string& out_filename, std::string& out_data);
+  // Where the file of an upload is stored, without reading it; the record has
+  // its mime type and filename defaulted as get_file_blob does.
+  bool get_file_location(int id, KaringRecord& out_record, std::string& out_path);
 
   // List latest active up to limit.
   std::vector<KaringRecord> list_latest(int limit, SortField sort, bool desc);
@@ -56,17 +84,44 @@ class KaringDao {
   // Counts for search result sets
   bool count_search_fts(const std::string& fts_query, long long& out);
 
+  // Keyset position: rows strictly after (sort value, id) in the requested order.
+  struct PageCursor {
+    std::optional<int64_t> value;  // empty when the sort column is NULL
+    int id{0};
+  };
+
   struct Filters {
     bool include_inactive{false};
     std::optional<int> is_file; // 0 or 1
     std::optional<std::string> mime;
+    // Matches mime types starting with this, e.g. "image/".
+    std::optional<std::string> mime_prefix;
     std::optional<std::string> filename;
     SortField sort{SortField::stored_at};
     bool order_desc{true};
+    // Ignored by count_filtered so totals cover every page.
+    std::optional<PageCursor> after;
+    // FTS only: search the trigram index entries_fts_tri instead of entries_fts.
+    bool substring{false};
+    // FTS only: return a snippet() of the match instead of content_text.
+    bool snippet{false};
+    // Payload read per row; an FTS snippet replaces it.
+    Projection projection;
+    // FTS only: the query stops and fails once this is set.
+    const std::atomic<bool>* cancel{nullptr};
   };
 
   std::vector<KaringRecord> list_filtered(int limit, const Filters& f);
   long long count_filtered(const Filters& f);
+  // FTS search with the filters applied in SQL; uses f.sort and f.order_desc.
+  // SortField::rank keeps only the best `limit` matches; f.after is not supported.
+  bool try_search_fts(const std::string& fts_query, int limit, const Filters& f, std::vector<KaringRecord>& out);
+  // content_text, original_filename and body_text of each active id, joined by '\n', in order.
+  // False if a row is gone or the texts together pass max_bytes.
+  bool load_search_text(const std::vector<int>& ids, size_t max_bytes, std::vector<std::string>& out);
+
+  // Bumped after every committed write to this database.
+  uint64_t write_generation() const;
 
   // Replace (PUT) operations
   bool update_text(int id, const std::string& content);
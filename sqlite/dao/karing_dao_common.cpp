@@ -9,12 +9,13 @@ KaringDao::KaringDao(std::string db_path, std::string upload_path)
 
 namespace detail {
 
-Db::Db(const std::string& path) {
-  sqlite3_open_v2(path.c_str(), &handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+Db::Db(const std::string& path, mode access) : pool_(&db::connection_pool::for_path(path)) {
+  conn_ = pool_->acquire(access == mode::read ? db::connection_pool::role::reader : db::connection_pool::role::writer);
+  if (conn_) handle = conn_->handle;
 }
 
 Db::~Db() {
-  if (handle) sqlite3_close(handle);
+  if (conn_) pool_->release(conn_);
 }
 
 Db::operator sqlite3*() {
@@ -25,6 +26,47 @@ bool Db::ok() const {
   return handle != nullptr;
 }
 
+sqlite3_stmt* Db::cached(const std::string& sql) {
+  return conn_ ? pool_->statement(*conn_, sql) : nullptr;
+}
+
+bool Db::statements_primed() const {
+  return conn_ && conn_->statements_primed;
+}
+
+void Db::mark_statements_primed() {
+  if (conn_) conn_->statements_primed = true;
+}
+
+Stmt::Stmt(Db& db, const std::string& sql) {
+  handle = db.cached(sql);
+  if (handle && !sqlite3_stmt_busy(handle)) return;
+  handle = nullptr;
+  if (db.ok() && sqlite3_prepare_v2(db, sql.c_str(), -1, &handle, nullptr) != SQLITE_OK) {
+    sqlite3_finalize(handle);
+    handle = nullptr;
+  }
+  owned_ = handle != nullptr;
+}
+
+Stmt::~Stmt() {
+  if (!handle) return;
+  if (owned_) {
+    sqlite3_finalize(handle);
+    return;
+  }
+  sqlite3_reset(handle);
+  sqlite3_clear_bindings(handle);
+}
+
+Stmt::operator sqlite3_stmt*() {
+  return handle;
+}
+
+bool Stmt::ok() const {
+  return handle != nullptr;
+}
+
 int64_t now_epoch() {
   using namespace std::chrono;
   return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
@@ -38,6 +80,9 @@ const char* sort_column(SortField sort) {
       return "stored_at";
     case SortField::updated_at:
       return "updated_at";
+    case SortField::rank:
+      // Relevance needs an FTS match; plain listings fall back to id.
+      return "id";
   }
   return "stored_at";
 }
@@ -80,60 +125,43 @@ bool exec_simple(sqlite3* db, const char* sql) {
   return rc == SQLITE_OK;
 }
 
-bool read_entry_file_path(sqlite3* db, int id, std::string& file_path) {
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db, "SELECT file_path FROM entries WHERE id=?;", -1, &stmt, nullptr) != SQLITE_OK) return false;
+bool read_entry_file_path(Db& db, int id, std::string& file_path) {
+  Stmt stmt(db, "SELECT file_path FROM entries WHERE id=?;");
+  if (!stmt.ok()) return false;
   sqlite3_bind_int(stmt, 1, id);
-  bool ok = false;
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    if (const unsigned char* t = sqlite3_column_text(stmt, 0)) file_path = reinterpret_cast<const char*>(t);
-    ok = true;
-  }
-  sqlite3_finalize(stmt);
-  return ok;
+  if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+  if (const unsigned char* t = sqlite3_column_text(stmt, 0)) file_path = reinterpret_cast<const char*>(t);
+  return true;
 }
 
-bool fetch_slot_state(sqlite3* db, int& id, int& max_items) {
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db, "SELECT next_id, max_items FROM store_state WHERE singleton_id=1;", -1, &stmt, nullptr) != SQLITE_OK) return false;
-  bool ok = false;
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    id = sqlite3_column_int(stmt, 0);
-    max_items = sqlite3_column_int(stmt, 1);
-    ok = true;
-  }
-  sqlite3_finalize(stmt);
-  return ok;
+bool fetch_slot_state(Db& db, int& id, int& max_items) {
+  Stmt stmt(db, "SELECT next_id, max_items FROM store_state WHERE singleton_id=1;");
+  if (!stmt.ok() || sqlite3_step(stmt) != SQLITE_ROW) return false;
+  id = sqlite3_column_int(stmt, 0);
+  max_items = sqlite3_column_int(stmt, 1);
+  return true;
 }
 
-std::optional<int> previous_slot_id(sqlite3* db) {
+std::optional<int> previous_slot_id(Db& db) {
   int next_id = 0;
   int max_items = 0;
   if (!fetch_slot_state(db, next_id, max_items) || max_items < 1) return std::nullopt;
   return next_id == 1 ? max_items : next_id - 1;
 }
 
-bool advance_next_id(sqlite3* db, int max_items) {
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db,
-                         "UPDATE store_state SET next_id = CASE WHEN next_id >= max_items THEN 1 ELSE next_id + 1 END, "
-                         "updated_at = strftime('%s','now') WHERE singleton_id=1;",
-                         -1,
-                         &stmt,
-                         nullptr) != SQLITE_OK) {
-    return false;
-  }
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-  sqlite3_finalize(stmt);
-  return ok;
+bool write_next_id(Db& db, int next_id) {
+  Stmt stmt(db, "UPDATE store_state SET next_id=?, updated_at=strftime('%s','now') WHERE singleton_id=1;");
+  if (!stmt.ok()) return false;
+  sqlite3_bind_int(stmt, 1, next_id);
+  return sqlite3_step(stmt) == SQLITE_DONE;
 }
 
-bool load_entry(sqlite3* db, int id, KaringRecord& record, std::string* file_path, bool require_used) {
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "SELECT id, used, media_kind, content_text, original_filename, mime_type, stored_at, updated_at, file_path "
-      "FROM entries WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+bool load_entry(Db& db, int id, KaringRecord& record, std::string* file_path, bool require_used) {
+  Stmt stmt(db,
+            "SELECT id, used, media_kind, content_text, original_filename, mime_type, stored_at, updated_at, file_path, "
+            "size_bytes, revision "
+            "FROM entries WHERE id=?;");
+  if (!stmt.ok()) return false;
   sqlite3_bind_int(stmt, 1, id);
   bool ok = false;
   if (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -151,10 +179,11 @@ bool load_entry(sqlite3* db, int id, KaringRecord& record, std::string* file_pat
       record.created_at = sqlite3_column_type(stmt, 6) != SQLITE_NULL ? sqlite3_column_int64(stmt, 6) : 0;
       if (sqlite3_column_type(stmt, 7) != SQLITE_NULL) record.updated_at = sqlite3_column_int64(stmt, 7);
       if (file_path && sqlite3_column_type(stmt, 8) != SQLITE_NULL) *file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
+      record.size_bytes = sqlite3_column_int64(stmt, 9);
+      record.revision = sqlite3_column_int64(stmt, 10);
       ok = true;
     }
   }
-  sqlite3_finalize(stmt);
   return ok;
 }
 
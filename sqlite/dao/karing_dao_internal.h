@@ -7,16 +7,49 @@
 
 #include <sqlite3.h>
 
+#include "db/connection_pool.h"
 #include "karing_dao.h"
 
 namespace karing::dao::detail {
 
+// Borrowed connection from the process-wide pool for `path`; returned on scope exit.
 struct Db {
+  enum class mode {
+    read,
+    write,
+  };
+
   sqlite3* handle{nullptr};
-  explicit Db(const std::string& path);
+  explicit Db(const std::string& path, mode access = mode::write);
   ~Db();
+  Db(const Db&) = delete;
+  Db& operator=(const Db&) = delete;
   operator sqlite3*();
   bool ok() const;
+
+  // Statement cached on the leased connection, or nullptr if it cannot be prepared.
+  sqlite3_stmt* cached(const std::string& sql);
+  bool statements_primed() const;
+  void mark_statements_primed();
+
+ private:
+  db::connection_pool* pool_{nullptr};
+  db::pooled_connection* conn_{nullptr};
+};
+
+// Prepared statement borrowed from the lease's cache; reset and unbound on scope exit.
+// Uses a private statement instead when the cached one is still stepping.
+struct Stmt {
+  sqlite3_stmt* handle{nullptr};
+  Stmt(Db& db, const std::string& sql);
+  ~Stmt();
+  Stmt(const Stmt&) = delete;
+  Stmt& operator=(const Stmt&) = delete;
+  operator sqlite3_stmt*();
+  bool ok() const;
+
+ private:
+  bool owned_{false};
 };
 
 int64_t now_epoch();
@@ -26,10 +59,10 @@ std::string order_by_clause(SortField sort, bool desc, const char* table_alias =
 std::string media_kind_for_mime(const std::string& mime);
 
 bool exec_simple(sqlite3* db, const char* sql);
-bool read_entry_file_path(sqlite3* db, int id, std::string& file_path);
-bool fetch_slot_state(sqlite3* db, int& id, int& max_items);
-std::optional<int> previous_slot_id(sqlite3* db);
-bool advance_next_id(sqlite3* db, int max_items);
-bool load_entry(sqlite3* db, int id, KaringRecord& record, std::string* file_path = nullptr, bool require_used = true);
+bool read_entry_file_path(Db& db, int id, std::string& file_path);
+bool fetch_slot_state(Db& db, int& id, int& max_items);
+std::optional<int> previous_slot_id(Db& db);
+bool write_next_id(Db& db, int next_id);
+bool load_entry(Db& db, int id, KaringRecord& record, std::string* file_path = nullptr, bool require_used = true);
 
 }  // namespace karing::dao::detail
@@ -15,6 +15,11 @@ std::optional<KaringRecord> KaringDao::get_by_id(int id) {
   return repo.get_by_id(id);
 }
 
+std::optional<KaringRecord> KaringDao::get_by_id(int id, const Projection& projection) {
+  repository::entry_repository repo(db_path_);
+  return repo.get_by_id(id, projection);
+}
+
 bool KaringDao::get_file_blob(int id, std::string& out_mime, std::string& out_filename, std::string& out_data) {
   repository::entry_repository repo(db_path_);
   KaringRecord record{};
@@ -27,6 +32,15 @@ bool KaringDao::get_file_blob(int id, std::string& out_mime, std::string& out_fi
   return true;
 }
 
+bool KaringDao::get_file_location(int id, KaringRecord& out_record, std::string& out_path) {
+  repository::entry_repository repo(db_path_);
+  if (!repo.get_file_record(id, out_record, out_path) || out_path.empty()) return false;
+
+  if (out_record.mime.empty()) out_record.mime = "application/octet-stream";
+  if (out_record.filename.empty()) out_record.filename = "download";
+  return true;
+}
+
 std::vector<KaringRecord> KaringDao::list_latest(int limit, SortField sort, bool desc) {
   repository::entry_repository repo(db_path_);
   return repo.list_latest(limit, sort, desc);
@@ -57,4 +71,14 @@ long long KaringDao::count_filtered(const Filters& f) {
   return repo.count_filtered(f);
 }
 
+bool KaringDao::try_search_fts(const std::string& fts_query, int limit, const Filters& f, std::vector<KaringRecord>& out) {
+  repository::entry_repository repo(db_path_);
+  return repo.search_fts(fts_query, limit, f, out);
+}
+
+bool KaringDao::load_search_text(const std::vector<int>& ids, size_t max_bytes, std::vector<std::string>& out) {
+  repository::entry_repository repo(db_path_);
+  return repo.load_search_text(ids, max_bytes, out);
+}
+
 }  // namespace karing::dao
@@ -54,4 +54,8 @@ std::optional<std::pair<std::vector<KaringRecord>, int>> KaringDao::resequence_e
   return store.resequence_entries();
 }
 
+uint64_t KaringDao::write_generation() const {
+  return store::entry_store::write_generation(db_path_);
+}
+
 }  // namespace karing::dao
@@ -0,0 +1,235 @@
+#include "db/connection_pool.h"
+
+#include <algorithm>
+#include <map>
+
+#include <sqlite3.h>
+
+namespace karing::db {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+pool_options& configured_options() {
+  static pool_options options;
+  return options;
+}
+
+std::map<std::string, std::unique_ptr<connection_pool>>& registry() {
+  static std::map<std::string, std::unique_ptr<connection_pool>> pools;
+  return pools;
+}
+
+bool open_handle(const std::string& db_path, const pool_options& options, pooled_connection& conn) {
+  sqlite3* handle = nullptr;
+  const int flags = conn.writer ? SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE : SQLITE_OPEN_READONLY;
+  if (sqlite3_open_v2(db_path.c_str(), &handle, flags, nullptr) != SQLITE_OK) {
+    if (handle) sqlite3_close(handle);
+    return false;
+  }
+  sqlite3_busy_timeout(handle, options.busy_timeout_ms);
+  if (!conn.writer) {
+    const std::string pragmas = "PRAGMA mmap_size = " + std::to_string(std::max(0LL, options.reader_mmap_bytes)) +
+                                "; PRAGMA cache_size = -" + std::to_string(std::max(0, options.reader_cache_kib)) +
+                                "; PRAGMA temp_store = MEMORY;";
+    sqlite3_exec(handle, pragmas.c_str(), nullptr, nullptr, nullptr);
+  } else if (options.wal) {
+    const std::string pragmas = "PRAGMA synchronous = NORMAL; PRAGMA wal_autocheckpoint = " +
+                                std::to_string(std::max(0, options.wal_autocheckpoint)) + ";";
+    sqlite3_exec(handle, pragmas.c_str(), nullptr, nullptr, nullptr);
+  }
+  conn.handle = handle;
+  conn.last_used = std::chrono::steady_clock::now();
+  return true;
+}
+
+}  // namespace
+
+connection_pool::connection_pool(std::string db_path)
+    : db_path_(std::move(db_path)), options_(configured_options()) {
+  options_.readers = std::max(1, options_.readers);
+  stats_.readers = options_.readers;
+}
+
+connection_pool::~connection_pool() {
+  for (auto& conn : readers_) close_connection(conn.get());
+  if (writer_) close_connection(writer_.get());
+}
+
+void connection_pool::configure(const pool_options& options) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  configured_options() = options;
+}
+
+connection_pool& connection_pool::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& pools = registry();
+  auto it = pools.find(db_path);
+  if (it == pools.end()) it = pools.emplace(db_path, std::make_unique<connection_pool>(db_path)).first;
+  return *it->second;
+}
+
+pooled_connection* connection_pool::acquire(role access) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.acquire_timeout_ms);
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (access == role::writer) {
+    if (writer_busy_ && writer_owner_ == std::this_thread::get_id()) {
+      ++writer_depth_;
+      ++stats_.acquired;
+      return writer_.get();
+    }
+    if (writer_busy_) {
+      ++stats_.waits;
+      if (!available_.wait_until(lock, deadline, [&] { return !writer_busy_; })) {
+        ++stats_.timeouts;
+        return nullptr;
+      }
+    }
+    if (!writer_) {
+      auto conn = std::make_unique<pooled_connection>();
+      conn->writer = true;
+      if (!open_handle(db_path_, options_, *conn)) return nullptr;
+      ++stats_.opened;
+      writer_ = std::move(conn);
+    }
+    writer_busy_ = true;
+    writer_owner_ = std::this_thread::get_id();
+    writer_depth_ = 1;
+    ++stats_.acquired;
+    pooled_connection* conn = writer_.get();
+    lock.unlock();
+    if (!check_health(*conn)) {
+      release(conn);
+      return nullptr;
+    }
+    return conn;
+  }
+
+  const auto can_take = [&] {
+    return !idle_readers_.empty() || static_cast<int>(readers_.size()) < options_.readers;
+  };
+  if (!can_take()) {
+    ++stats_.waits;
+    if (!available_.wait_until(lock, deadline, can_take)) {
+      ++stats_.timeouts;
+      return nullptr;
+    }
+  }
+
+  pooled_connection* conn = nullptr;
+  if (!idle_readers_.empty()) {
+    conn = idle_readers_.back();
+    idle_readers_.pop_back();
+  } else {
+    auto fresh = std::make_unique<pooled_connection>();
+    if (!open_handle(db_path_, options_, *fresh)) return nullptr;
+    ++stats_.opened;
+    conn = fresh.get();
+    readers_.push_back(std::move(fresh));
+  }
+  ++stats_.acquired;
+  lock.unlock();
+
+  if (!check_health(*conn)) {
+    std::lock_guard<std::mutex> relock(mutex_);
+    readers_.erase(std::remove_if(readers_.begin(), readers_.end(), [&](const auto& item) { return item.get() == conn; }),
+                   readers_.end());
+    available_.notify_all();
+    return nullptr;
+  }
+  return conn;
+}
+
+void connection_pool::release(pooled_connection* conn) {
+  if (!conn) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (conn->writer && --writer_depth_ > 0) return;
+
+  // A lease must never leave a statement or transaction open for the next borrower.
+  for (auto& [sql, stmt] : conn->statements) {
+    if (sqlite3_stmt_busy(stmt)) sqlite3_reset(stmt);
+  }
+  if (conn->handle && !sqlite3_get_autocommit(conn->handle)) {
+    sqlite3_exec(conn->handle, "ROLLBACK;", nullptr, nullptr, nullptr);
+  }
+  conn->last_used = std::chrono::steady_clock::now();
+
+  if (conn->writer) {
+    writer_busy_ = false;
+    writer_owner_ = {};
+    writer_depth_ = 0;
+  } else {
+    idle_readers_.push_back(conn);
+  }
+  available_.notify_all();
+}
+
+sqlite3_stmt* connection_pool::statement(pooled_connection& conn, const std::string& sql) {
+  if (!conn.handle) return nullptr;
+  const auto it = conn.statements.find(sql);
+  if (it != conn.statements.end()) {
+    ++statement_hits_;
+    return it->second;
+  }
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v3(conn.handle, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+    if (stmt) sqlite3_finalize(stmt);
+    return nullptr;
+  }
+  ++statements_prepared_;
+  conn.statements.emplace(sql, stmt);
+  return stmt;
+}
+
+pool_stats connection_pool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pool_stats out = stats_;
+  out.statements_prepared = statements_prepared_.load();
+  out.statement_hits = statement_hits_.load();
+  out.open = static_cast<int>(readers_.size()) + (writer_ ? 1 : 0);
+  out.idle = static_cast<int>(idle_readers_.size()) + (writer_ && !writer_busy_ ? 1 : 0);
+  out.in_use = out.open - out.idle;
+  return out;
+}
+
+bool connection_pool::check_health(pooled_connection& conn) {
+  if (conn.handle) {
+    const auto idle_for = std::chrono::steady_clock::now() - conn.last_used;
+    if (idle_for < std::chrono::seconds(options_.health_check_seconds)) return true;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.health_checks;
+    }
+    if (sqlite3_exec(conn.handle, "SELECT 1;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+      conn.last_used = std::chrono::steady_clock::now();
+      return true;
+    }
+
+    close_connection(&conn);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.discarded;
+  }
+
+  // Reopen in place so the slot stays usable after a transient failure.
+  if (!open_handle(db_path_, options_, conn)) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.opened;
+  return true;
+}
+
+void connection_pool::close_connection(pooled_connection* conn) {
+  if (!conn || !conn->handle) return;
+  for (auto& [sql, stmt] : conn->statements) sqlite3_finalize(stmt);
+  conn->statements.clear();
+  conn->statements_primed = false;
+  sqlite3_close(conn->handle);
+  conn->handle = nullptr;
+}
+
+}  // namespace karing::db
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace karing::db {
+
+struct pool_options {
+  int readers{4};
+  int acquire_timeout_ms{5000};
+  int busy_timeout_ms{5000};
+  int health_check_seconds{30};
+  // Reader tuning; readers are opened read-only.
+  long long reader_mmap_bytes{256LL * 1024 * 1024};
+  int reader_cache_kib{16 * 1024};
+  bool wal{false};
+  // Pages before a committing connection checkpoints on its own; 0 disables.
+  int wal_autocheckpoint{1000};
+};
+
+struct pool_stats {
+  int readers{0};
+  int open{0};
+  int idle{0};
+  int in_use{0};
+  long long acquired{0};
+  long long opened{0};
+  long long waits{0};
+  long long timeouts{0};
+  long long health_checks{0};
+  long long discarded{0};
+  long long statements_prepared{0};
+  long long statement_hits{0};
+};
+
+struct pooled_connection {
+  sqlite3* handle{nullptr};
+  bool writer{false};
+  bool statements_primed{false};
+  std::chrono::steady_clock::time_point last_used{};
+  // Prepared statements keyed by SQL text; owned by this handle.
+  std::unordered_map<std::string, sqlite3_stmt*> statements;
+};
+
+// Long-lived SQLite connections for one database file. Readers are shared up
+// to pool_options::readers; the single writer is re-entrant on its owning
+// thread so nested store calls do not deadlock.
+class connection_pool {
+ public:
+  enum class role {
+    reader,
+    writer,
+  };
+
+  explicit connection_pool(std::string db_path);
+  ~connection_pool();
+
+  connection_pool(const connection_pool&) = delete;
+  connection_pool& operator=(const connection_pool&) = delete;
+
+  // Applies to pools created after the call; set once at startup.
+  static void configure(const pool_options& options);
+  static connection_pool& for_path(const std::string& db_path);
+
+  // Returns nullptr if the connection cannot be opened or the wait times out.
+  pooled_connection* acquire(role access);
+  void release(pooled_connection* conn);
+
+  // Cached statement for `sql` on a leased connection, reset and unbound.
+  // Returns nullptr if the statement cannot be prepared.
+  sqlite3_stmt* statement(pooled_connection& conn, const std::string& sql);
+
+  pool_stats stats() const;
+
+ private:
+  bool check_health(pooled_connection& conn);
+  void close_connection(pooled_connection* conn);
+
+  std::string db_path_;
+  pool_options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::vector<std::unique_ptr<pooled_connection>> readers_;
+  std::vector<pooled_connection*> idle_readers_;
+  std::unique_ptr<pooled_connection> writer_;
+  bool writer_busy_{false};
+  std::thread::id writer_owner_{};
+  int writer_depth_{0};
+  pool_stats stats_;
+  std::atomic<long long> statements_prepared_{0};
+  std::atomic<long long> statement_hits_{0};
+};
+
+}  // namespace karing::db
@@ -1,9 +1,15 @@
 // SQLite schema init and resize using raw C API.
 #include "db_init_internal.h"
 
+#include "db/slot_cursor.h"
+
 namespace karing::db {
 
-init_result init_sqlite_schema_file(const std::string& db_path_str, int max_items, bool force) {
+init_result init_sqlite_schema_file(const std::string& db_path_str,
+                                    int max_items,
+                                    bool force,
+                                    journal_mode mode,
+                                    const fts_options& fts) {
   init_result result;
   result.current_max_items = max_items;
 
@@ -34,7 +40,8 @@ init_result init_sqlite_schema_file(const std::string& db_path_str, int max_item
     return finish(false);
   }
 
-  if (!detail::exec_stmt(db, "PRAGMA journal_mode = DELETE;", error) ||
+  const char* journal_sql = mode == journal_mode::wal ? "PRAGMA journal_mode = WAL;" : "PRAGMA journal_mode = DELETE;";
+  if (!detail::exec_stmt(db, journal_sql, error) ||
       !detail::exec_stmt(db, "PRAGMA synchronous = NORMAL;", error) ||
       !detail::exec_stmt(db, "PRAGMA foreign_keys = ON;", error) ||
       !detail::exec_stmt(db, "BEGIN IMMEDIATE;", error)) {
@@ -65,7 +72,7 @@ init_result init_sqlite_schema_file(const std::string& db_path_str, int max_item
     return finish(false);
   }
 
-  if (!detail::finalize_schema(db, result.current_max_items, reset_next_id, error) ||
+  if (!detail::finalize_schema(db, result.current_max_items, reset_next_id, fts, error) ||
       !detail::exec_stmt(db, "COMMIT;", error)) {
     result.error = error;
     detail::exec_stmt(db, "ROLLBACK;", error);
@@ -73,6 +80,7 @@ init_result init_sqlite_schema_file(const std::string& db_path_str, int max_item
   }
 
   detail::remove_files(files_to_remove);
+  slot_cursor::for_path(db_path_str).invalidate();
   return finish(true);
 }
 
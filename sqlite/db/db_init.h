@@ -3,6 +3,27 @@
 
 namespace karing::db {
 
+enum class journal_mode {
+  rollback,
+  wal,
+};
+
+enum class fts_tokenizer {
+  unicode61,
+  // Also keeps the trigram index entries_fts_tri for substring search.
+  trigram,
+};
+
+struct fts_options {
+  fts_tokenizer tokenizer{fts_tokenizer::unicode61};
+  // Prefix lengths indexed on entries_fts for live "term"* queries, e.g. "2 3";
+  // empty disables the prefix index.
+  std::string prefix{"2 3"};
+  // FTS5 'automerge' and 'crisismerge' settings applied to every FTS table.
+  int automerge{4};
+  int crisismerge{16};
+};
+
 struct init_result {
   bool ok{false};
   bool created{false};
@@ -13,6 +34,12 @@ struct init_result {
 };
 
 // Create or resize the SQLite schema to match the requested max_items.
-init_result init_sqlite_schema_file(const std::string& db_path, int max_items, bool force);
+// The journal mode is persisted in the database file for later connections;
+// the FTS tables are rebuilt on every call with the given fts options.
+init_result init_sqlite_schema_file(const std::string& db_path,
+                                    int max_items,
+                                    bool force,
+                                    journal_mode mode = journal_mode::rollback,
+                                    const fts_options& fts = {});
 
 }
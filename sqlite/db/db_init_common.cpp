@@ -31,6 +31,19 @@ bool has_table(sqlite3* db, const char* table_name, std::string& error) {
   return exists;
 }
 
+bool has_column(sqlite3* db, const char* table_name, const char* column_name, std::string& error) {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info(?) WHERE name=? LIMIT 1;", -1, &stmt, nullptr) != SQLITE_OK) {
+    error = sqlite3_errmsg(db);
+    return false;
+  }
+  sqlite3_bind_text(stmt, 1, table_name, -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, column_name, -1, SQLITE_TRANSIENT);
+  const bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
+  sqlite3_finalize(stmt);
+  return exists;
+}
+
 bool seed_metadata(sqlite3* db, std::string& error) {
   sqlite3_stmt* stmt = nullptr;
   const char* sql =
@@ -141,16 +154,52 @@ bool drop_fts_objects(sqlite3* db, std::string& error) {
   return exec_stmt(db, "DROP TRIGGER IF EXISTS entries_ai;", error) &&
          exec_stmt(db, "DROP TRIGGER IF EXISTS entries_au;", error) &&
          exec_stmt(db, "DROP TRIGGER IF EXISTS entries_ad;", error) &&
-         exec_stmt(db, "DROP TABLE IF EXISTS entries_fts;", error);
+         exec_stmt(db, "DROP TABLE IF EXISTS entries_fts;", error) &&
+         exec_stmt(db, "DROP TRIGGER IF EXISTS entries_tri_ai;", error) &&
+         exec_stmt(db, "DROP TRIGGER IF EXISTS entries_tri_au;", error) &&
+         exec_stmt(db, "DROP TRIGGER IF EXISTS entries_tri_ad;", error) &&
+         exec_stmt(db, "DROP TABLE IF EXISTS entries_fts_tri;", error);
 }
 
-bool rebuild_fts(sqlite3* db, std::string& error) {
-  return exec_sql(db, schema_sql::kSchemaFtsSql, error) &&
-         exec_stmt(db, "INSERT INTO entries_fts(entries_fts) VALUES('rebuild');", error);
+bool configure_fts_merges(sqlite3* db, const char* table, const fts_options& fts, std::string& error) {
+  const std::string insert = std::string("INSERT INTO ") + table + "(" + table + ", rank) VALUES";
+  return exec_sql(db, insert + "('automerge', " + std::to_string(fts.automerge) + ");", error) &&
+         exec_sql(db, insert + "('crisismerge', " + std::to_string(fts.crisismerge) + ");", error);
+}
+
+bool rebuild_fts(sqlite3* db, const fts_options& fts, std::string& error) {
+  std::string fts_sql = schema_sql::kSchemaFtsSql;
+  const std::string placeholder = "{{prefix}}";
+  for (auto at = fts_sql.find(placeholder); at != std::string::npos; at = fts_sql.find(placeholder, at)) {
+    fts_sql.replace(at, placeholder.size(), fts.prefix);
+  }
+  if (!exec_sql(db, fts_sql, error) ||
+      !configure_fts_merges(db, "entries_fts", fts, error) ||
+      !exec_stmt(db, "INSERT INTO entries_fts(entries_fts) VALUES('rebuild');", error)) {
+    return false;
+  }
+  if (fts.tokenizer != fts_tokenizer::trigram) return true;
+  return exec_sql(db, schema_sql::kSchemaFtsTrigramSql, error) &&
+         configure_fts_merges(db, "entries_fts_tri", fts, error) &&
+         exec_stmt(db,
+                   "INSERT INTO entries_fts_tri(rowid, content_text, original_filename, body_text) "
+                   "SELECT id, content_text, original_filename, body_text FROM entries WHERE used=1;",
+                   error);
 }
 
 bool prepare_schema(sqlite3* db, int max_items, init_result& result, std::string& error) {
   if (!exec_sql(db, schema_sql::kSchemaBaseSql, error)) return false;
+  // Databases created before file bodies were indexed lack the column; the
+  // backfill fills it in for existing uploads.
+  if (!has_column(db, "entries", "body_text", error)) {
+    if (!error.empty() || !exec_stmt(db, "ALTER TABLE entries ADD COLUMN body_text TEXT;", error)) return false;
+  }
+  if (!has_column(db, "entries", "revision", error)) {
+    if (!error.empty() ||
+        !exec_stmt(db, "ALTER TABLE entries ADD COLUMN revision INTEGER NOT NULL DEFAULT 0;", error)) {
+      return false;
+    }
+  }
 
   bool created_state = false;
   if (!ensure_store_state(db, max_items, created_state, result.previous_max_items, error)) return false;
@@ -159,10 +208,10 @@ bool prepare_schema(sqlite3* db, int max_items, init_result& result, std::string
   return ensure_slots(db, 1, current_max_items, error);
 }
 
-bool finalize_schema(sqlite3* db, int current_max_items, bool reset_next_id, std::string& error) {
+bool finalize_schema(sqlite3* db, int current_max_items, bool reset_next_id, const fts_options& fts, std::string& error) {
   return update_store_state(db, current_max_items, reset_next_id, error) &&
          drop_fts_objects(db, error) &&
-         rebuild_fts(db, error) &&
+         rebuild_fts(db, fts, error) &&
          seed_metadata(db, error);
 }
 
@@ -2,6 +2,8 @@
 
 #include <sqlite3.h>
 
+#include "db/connection_pool.h"
+
 namespace karing::db::inspect {
 
 namespace {
@@ -122,39 +124,34 @@ schema_check_result check_schema(const std::string& db_path) {
 }
 
 std::optional<health_info> read_health_info(const std::string& db_path) {
-  sqlite3* db = nullptr;
-  if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
-    if (db) sqlite3_close(db);
-    return std::nullopt;
-  }
+  auto& pool = connection_pool::for_path(db_path);
+  pooled_connection* conn = pool.acquire(connection_pool::role::reader);
+  if (!conn) return std::nullopt;
 
   health_info out;
 
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db,
-                         "SELECT max_items, next_id FROM store_state WHERE singleton_id=1;",
-                         -1,
-                         &stmt,
-                         nullptr) != SQLITE_OK) {
-    sqlite3_close(db);
+  sqlite3_stmt* stmt = pool.statement(*conn, "SELECT max_items, next_id FROM store_state WHERE singleton_id=1;");
+  if (!stmt) {
+    pool.release(conn);
     return std::nullopt;
   }
   if (sqlite3_step(stmt) == SQLITE_ROW) {
     out.max_items = sqlite3_column_int(stmt, 0);
     out.next_id = sqlite3_column_int(stmt, 1);
   }
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
 
-  if (sqlite3_prepare_v2(db, "SELECT COUNT(1) FROM entries WHERE used=1;", -1, &stmt, nullptr) != SQLITE_OK) {
-    sqlite3_close(db);
+  stmt = pool.statement(*conn, "SELECT COUNT(1) FROM entries WHERE used=1;");
+  if (!stmt) {
+    pool.release(conn);
     return std::nullopt;
   }
   if (sqlite3_step(stmt) == SQLITE_ROW) {
     out.active_items = sqlite3_column_int(stmt, 0);
   }
-  sqlite3_finalize(stmt);
+  sqlite3_reset(stmt);
 
-  sqlite3_close(db);
+  pool.release(conn);
   return out;
 }
 
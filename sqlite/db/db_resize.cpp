@@ -13,7 +13,7 @@ bool load_active_entries(sqlite3* db, std::vector<active_entry>& entries, std::s
   sqlite3_stmt* stmt = nullptr;
   const char* sql =
       "SELECT source_kind, media_kind, content_text, file_path, original_filename, mime_type, "
-      "size_bytes, stored_at, updated_at "
+      "size_bytes, stored_at, updated_at, body_text "
       "FROM entries WHERE used = 1 ORDER BY stored_at ASC, id ASC;";
   if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
     error = sqlite3_errmsg(db);
@@ -38,6 +38,8 @@ bool load_active_entries(sqlite3* db, std::vector<active_entry>& entries, std::s
     entry.size_bytes = sqlite3_column_int(stmt, 6);
     entry.stored_at = sqlite3_column_int64(stmt, 7);
     entry.updated_at = sqlite3_column_int64(stmt, 8);
+    entry.has_body_text = sqlite3_column_type(stmt, 9) != SQLITE_NULL;
+    entry.body_text = column_text(stmt, 9);
     entries.push_back(std::move(entry));
   }
 
@@ -51,11 +53,27 @@ bool load_active_entries(sqlite3* db, std::vector<active_entry>& entries, std::s
   return true;
 }
 
-bool repopulate_active_entries(sqlite3* db, const std::vector<active_entry>& entries, std::string& error) {
+bool max_revision(sqlite3* db, long long& out, std::string& error) {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db, "SELECT COALESCE(MAX(revision), 0) FROM entries;", -1, &stmt, nullptr) != SQLITE_OK) {
+    error = sqlite3_errmsg(db);
+    return false;
+  }
+  const bool ok = sqlite3_step(stmt) == SQLITE_ROW;
+  if (ok) out = sqlite3_column_int64(stmt, 0);
+  else error = sqlite3_errmsg(db);
+  sqlite3_finalize(stmt);
+  return ok;
+}
+
+bool repopulate_active_entries(sqlite3* db,
+                               const std::vector<active_entry>& entries,
+                               long long revision,
+                               std::string& error) {
   sqlite3_stmt* stmt = nullptr;
   const char* sql =
       "UPDATE entries SET used=1, source_kind=?, media_kind=?, content_text=?, file_path=?, "
-      "original_filename=?, mime_type=?, size_bytes=?, stored_at=?, updated_at=? WHERE id=?;";
+      "original_filename=?, mime_type=?, size_bytes=?, stored_at=?, updated_at=?, body_text=?, revision=? WHERE id=?;";
   if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
     error = sqlite3_errmsg(db);
     return false;
@@ -74,7 +92,9 @@ bool repopulate_active_entries(sqlite3* db, const std::vector<active_entry>& ent
     sqlite3_bind_int(stmt, 7, entry.size_bytes);
     sqlite3_bind_int64(stmt, 8, entry.stored_at);
     sqlite3_bind_int64(stmt, 9, entry.updated_at);
-    sqlite3_bind_int(stmt, 10, static_cast<int>(i + 1));
+    if (entry.has_body_text) sqlite3_bind_text(stmt, 10, entry.body_text.c_str(), -1, SQLITE_TRANSIENT); else sqlite3_bind_null(stmt, 10);
+    sqlite3_bind_int64(stmt, 11, revision);
+    sqlite3_bind_int(stmt, 12, static_cast<int>(i + 1));
     if (sqlite3_step(stmt) != SQLITE_DONE) {
       error = sqlite3_errmsg(db);
       sqlite3_finalize(stmt);
@@ -126,17 +146,22 @@ bool shrink_slots(sqlite3* db, int new_max_items, bool force, std::vector<std::s
     kept_entries.reserve(active_entries.size() - keep_start);
     for (size_t i = keep_start; i < active_entries.size(); ++i) kept_entries.push_back(std::move(active_entries[i]));
 
+    // Entries move to new ids; a revision above any old one keeps their tags new.
+    long long revision = 0;
+    if (!max_revision(db, revision, error)) return false;
     if (!exec_stmt(db, "DELETE FROM entries;", error)) return false;
     if (!ensure_slots(db, 1, new_max_items, error)) return false;
-    return repopulate_active_entries(db, kept_entries, error);
+    return repopulate_active_entries(db, kept_entries, revision + 1, error);
   }
 
   if (force) {
     std::vector<active_entry> active_entries;
     if (!load_active_entries(db, active_entries, error)) return false;
+    long long revision = 0;
+    if (!max_revision(db, revision, error)) return false;
     if (!exec_stmt(db, "DELETE FROM entries;", error)) return false;
     if (!ensure_slots(db, 1, new_max_items, error)) return false;
-    return repopulate_active_entries(db, active_entries, error);
+    return repopulate_active_entries(db, active_entries, revision + 1, error);
   }
 
   if (sqlite3_prepare_v2(db, "DELETE FROM entries WHERE id > ?;", -1, &stmt, nullptr) != SQLITE_OK) {
@@ -0,0 +1,113 @@
+#include "db/slot_cursor.h"
+
+#include <map>
+#include <memory>
+
+#include <sqlite3.h>
+
+#include "db/connection_pool.h"
+
+namespace karing::db {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::unique_ptr<slot_cursor>>& registry() {
+  static std::map<std::string, std::unique_ptr<slot_cursor>> cursors;
+  return cursors;
+}
+
+}  // namespace
+
+slot_cursor::slot_cursor(std::string db_path) : db_path_(std::move(db_path)) {}
+
+slot_cursor& slot_cursor::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& cursors = registry();
+  auto it = cursors.find(db_path);
+  if (it == cursors.end()) it = cursors.emplace(db_path, std::make_unique<slot_cursor>(db_path)).first;
+  return *it->second;
+}
+
+slot_reservation slot_cursor::reserve() {
+  if (!seeded_.load(std::memory_order_acquire) && !seed()) return {};
+
+  // Read the generation first: a concurrent reset moves it past this value,
+  // which marks the reservation stale rather than handing out a wrong slot.
+  slot_reservation out;
+  out.generation = generation_.load(std::memory_order_acquire);
+  out.ticket = ticket_.fetch_add(1, std::memory_order_relaxed);
+  const int max_items = max_items_.load(std::memory_order_relaxed);
+  if (max_items < 1) return {};
+  out.slot = static_cast<int>(out.ticket % static_cast<uint64_t>(max_items)) + 1;
+  out.next_slot = static_cast<int>((out.ticket + 1) % static_cast<uint64_t>(max_items)) + 1;
+  return out;
+}
+
+bool slot_cursor::current(const slot_reservation& reservation) const {
+  return reservation.ok() && reservation.generation == generation_.load(std::memory_order_acquire);
+}
+
+bool slot_cursor::claim_persist(const slot_reservation& reservation, uint64_t& previous) {
+  previous = persisted_.load(std::memory_order_relaxed);
+  if (reservation.ticket + 1 <= previous) return false;
+  persisted_.store(reservation.ticket + 1, std::memory_order_relaxed);
+  return true;
+}
+
+void slot_cursor::restore_persist(const slot_reservation& reservation, uint64_t previous) {
+  // A reseed already replaced the value with what store_state holds.
+  if (!current(reservation)) return;
+  persisted_.store(previous, std::memory_order_relaxed);
+}
+
+void slot_cursor::reset(int next_id, int max_items) {
+  std::lock_guard<std::mutex> lock(seed_mutex_);
+  store(next_id, max_items);
+}
+
+void slot_cursor::store(int next_id, int max_items) {
+  // Odd while the ring is being rewritten so no reservation can match it.
+  generation_.fetch_add(1, std::memory_order_acq_rel);
+  const uint64_t ticket = next_id > 0 ? static_cast<uint64_t>(next_id - 1) : 0;
+  ticket_.store(ticket, std::memory_order_relaxed);
+  max_items_.store(max_items, std::memory_order_relaxed);
+  persisted_.store(ticket, std::memory_order_relaxed);
+  generation_.fetch_add(1, std::memory_order_acq_rel);
+  seeded_.store(max_items > 0, std::memory_order_release);
+}
+
+void slot_cursor::invalidate() {
+  std::lock_guard<std::mutex> lock(seed_mutex_);
+  seeded_.store(false, std::memory_order_release);
+  generation_.fetch_add(2, std::memory_order_acq_rel);
+}
+
+bool slot_cursor::seed() {
+  std::lock_guard<std::mutex> lock(seed_mutex_);
+  if (seeded_.load(std::memory_order_acquire)) return true;
+
+  auto& pool = connection_pool::for_path(db_path_);
+  pooled_connection* conn = pool.acquire(connection_pool::role::reader);
+  if (!conn) return false;
+  int next_id = 0;
+  int max_items = 0;
+  sqlite3_stmt* stmt = pool.statement(*conn, "SELECT next_id, max_items FROM store_state WHERE singleton_id=1;");
+  const bool ok = stmt && sqlite3_step(stmt) == SQLITE_ROW;
+  if (ok) {
+    next_id = sqlite3_column_int(stmt, 0);
+    max_items = sqlite3_column_int(stmt, 1);
+  }
+  if (stmt) sqlite3_reset(stmt);
+  pool.release(conn);
+  if (!ok || max_items < 1) return false;
+
+  store(next_id, max_items);
+  return true;
+}
+
+}  // namespace karing::db
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace karing::db {
+
+struct slot_reservation {
+  int slot{0};
+  int next_slot{0};
+  uint64_t ticket{0};
+  uint64_t generation{0};
+
+  bool ok() const { return slot > 0; }
+};
+
+// In-memory ring cursor for one database, seeded from store_state. Reserving
+// a slot is a single fetch-and-add; store_state.next_id is written back by the
+// insert that commits the furthest reservation.
+class slot_cursor {
+ public:
+  explicit slot_cursor(std::string db_path);
+
+  slot_cursor(const slot_cursor&) = delete;
+  slot_cursor& operator=(const slot_cursor&) = delete;
+
+  static slot_cursor& for_path(const std::string& db_path);
+
+  // Returns a reservation with slot 0 if store_state cannot be read.
+  slot_reservation reserve();
+  // False once the ring was reseeded after `reservation` was taken.
+  bool current(const slot_reservation& reservation) const;
+  // Writer thread only: true if committing `reservation` should persist
+  // next_slot; `previous` is what restore_persist needs if that write is undone.
+  bool claim_persist(const slot_reservation& reservation, uint64_t& previous);
+  // Writer thread only: takes back a claim whose transaction rolled back.
+  void restore_persist(const slot_reservation& reservation, uint64_t previous);
+
+  // Repositions the ring after store_state was rewritten in the open transaction.
+  void reset(int next_id, int max_items);
+  // Forces a reseed from store_state on the next reservation.
+  void invalidate();
+
+ private:
+  bool seed();
+  void store(int next_id, int max_items);
+
+  std::string db_path_;
+  std::mutex seed_mutex_;
+  std::atomic<bool> seeded_{false};
+  std::atomic<uint64_t> generation_{0};
+  std::atomic<uint64_t> ticket_{0};
+  std::atomic<int> max_items_{0};
+  std::atomic<uint64_t> persisted_{0};
+};
+
+}  // namespace karing::db
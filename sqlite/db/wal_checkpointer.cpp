@@ -0,0 +1,150 @@
+#include "db/wal_checkpointer.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <system_error>
+
+#include <sqlite3.h>
+
+namespace karing::db {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::unique_ptr<wal_checkpointer>>& registry() {
+  static std::map<std::string, std::unique_ptr<wal_checkpointer>> checkpointers;
+  return checkpointers;
+}
+
+int64_t now_epoch() {
+  using namespace std::chrono;
+  return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+wal_checkpointer::wal_checkpointer(std::string db_path) : db_path_(std::move(db_path)) {}
+
+wal_checkpointer::~wal_checkpointer() {
+  stop();
+}
+
+wal_checkpointer& wal_checkpointer::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& checkpointers = registry();
+  auto it = checkpointers.find(db_path);
+  if (it == checkpointers.end()) it = checkpointers.emplace(db_path, std::make_unique<wal_checkpointer>(db_path)).first;
+  return *it->second;
+}
+
+bool wal_checkpointer::start(const checkpoint_options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (worker_.joinable()) return true;
+  options_ = options;
+  options_.interval_ms = std::max(10, options_.interval_ms);
+  stopping_ = false;
+  stats_.running = true;
+  last_seen_frames_ = -1;
+  last_activity_ = std::chrono::steady_clock::now();
+  worker_ = std::thread([this] { run(); });
+  return true;
+}
+
+void wal_checkpointer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    stats_.running = false;
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  if (db_) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+  }
+}
+
+bool wal_checkpointer::ensure_open() {
+  if (db_) return true;
+  if (sqlite3_open_v2(db_path_.c_str(), &db_, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+    if (db_) sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+  // Never wait on readers or the writer; a busy pass is simply retried next tick.
+  sqlite3_busy_timeout(db_, 0);
+  // A fresh connection only attaches to the WAL after its first read; until
+  // then checkpoints report no frames.
+  sqlite3_exec(db_, "PRAGMA schema_version;", nullptr, nullptr, nullptr);
+  return true;
+}
+
+bool wal_checkpointer::checkpoint(bool truncate) {
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  if (!ensure_open()) return false;
+
+  int log_frames = 0;
+  int checkpointed = 0;
+  const int rc = sqlite3_wal_checkpoint_v2(db_,
+                                           nullptr,
+                                           truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE,
+                                           &log_frames,
+                                           &checkpointed);
+  std::error_code ec;
+  const auto wal_bytes = std::filesystem::file_size(db_path_ + "-wal", ec);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.wal_bytes = ec ? 0 : static_cast<long long>(wal_bytes);
+  if (rc == SQLITE_BUSY) {
+    ++stats_.busy;
+    return false;
+  }
+  if (rc != SQLITE_OK) return false;
+  stats_.wal_frames = std::max(0, log_frames);
+  stats_.checkpointed_frames = std::max(0, checkpointed);
+  stats_.last_checkpoint_at = now_epoch();
+  if (truncate) {
+    ++stats_.truncate_runs;
+  } else {
+    ++stats_.passive_runs;
+  }
+  return true;
+}
+
+checkpoint_stats wal_checkpointer::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void wal_checkpointer::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms), [&] { return stopping_; });
+    if (stopping_) break;
+    lock.unlock();
+
+    const bool ok = checkpoint(false);
+    const auto current = stats();
+    const auto now = std::chrono::steady_clock::now();
+    if (current.wal_frames != last_seen_frames_) {
+      last_seen_frames_ = current.wal_frames;
+      last_activity_ = now;
+    }
+    const bool fully_applied = current.wal_frames > 0 && current.checkpointed_frames == current.wal_frames;
+    if (ok && fully_applied && now - last_activity_ >= std::chrono::seconds(options_.truncate_idle_seconds)) {
+      if (checkpoint(true)) last_seen_frames_ = 0;
+    }
+
+    lock.lock();
+  }
+}
+
+}  // namespace karing::db
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct sqlite3;
+
+namespace karing::db {
+
+struct checkpoint_options {
+  int interval_ms{1000};
+  int truncate_idle_seconds{30};
+};
+
+struct checkpoint_stats {
+  bool running{false};
+  long long wal_bytes{0};
+  int wal_frames{0};
+  int checkpointed_frames{0};
+  long long passive_runs{0};
+  long long truncate_runs{0};
+  long long busy{0};
+  int64_t last_checkpoint_at{0};
+};
+
+// Background PASSIVE checkpoints for one WAL database so the log does not
+// grow between writer auto-checkpoints, plus a TRUNCATE once writes go idle.
+class wal_checkpointer {
+ public:
+  explicit wal_checkpointer(std::string db_path);
+  ~wal_checkpointer();
+
+  wal_checkpointer(const wal_checkpointer&) = delete;
+  wal_checkpointer& operator=(const wal_checkpointer&) = delete;
+
+  static wal_checkpointer& for_path(const std::string& db_path);
+
+  bool start(const checkpoint_options& options);
+  void stop();
+
+  // One checkpoint pass on the caller's thread; returns false on error or busy.
+  bool checkpoint(bool truncate);
+
+  checkpoint_stats stats() const;
+
+ private:
+  void run();
+  bool ensure_open();
+
+  std::string db_path_;
+  checkpoint_options options_;
+  sqlite3* db_{nullptr};
+
+  std::mutex run_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread worker_;
+  bool stopping_{false};
+  checkpoint_stats stats_;
+  int last_seen_frames_{-1};
+  std::chrono::steady_clock::time_point last_activity_{};
+};
+
+}  // namespace karing::db
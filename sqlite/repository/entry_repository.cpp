@@ -1,63 +1,316 @@
 #include "repository/entry_repository.h"
 
+#include <cstring>
+#include <string_view>
+
 #include "dao/karing_dao_internal.h"
 
 namespace karing::repository {
 
+namespace {
+
+// SQL for the payload column of a row; NULL leaves content_text unread.
+std::string content_column(const karing::dao::Projection& projection, const std::string& prefix = "") {
+  if (!projection.content) return "NULL";
+  if (projection.preview_chars > 0) {
+    return "substr(" + prefix + "content_text, 1, " + std::to_string(projection.preview_chars) + ")";
+  }
+  return prefix + "content_text";
+}
+
+std::string list_latest_sql(karing::dao::SortField sort, bool desc) {
+  return "SELECT id, media_kind, content_text, original_filename, mime_type, stored_at, updated_at, size_bytes, revision "
+         "FROM entries WHERE used=1" +
+         dao::detail::order_by_clause(sort, desc) +
+         " LIMIT ?;";
+}
+
+// Predicates for the optional filters; bind_filters() binds them in the same order.
+std::string filter_clause(const karing::dao::KaringDao::Filters& filters, const std::string& prefix = "") {
+  std::string sql;
+  if (filters.is_file.has_value()) {
+    sql += (*filters.is_file == 1) ? " AND " + prefix + "media_kind != 'text'" : " AND " + prefix + "media_kind = 'text'";
+  }
+  if (filters.mime.has_value()) sql += " AND " + prefix + "mime_type = ?";
+  if (filters.mime_prefix.has_value()) sql += " AND " + prefix + "mime_type >= ? AND " + prefix + "mime_type < ?";
+  if (filters.filename.has_value()) sql += " AND " + prefix + "original_filename = ?";
+  return sql;
+}
+
+// Smallest string greater than every string starting with `prefix`, so the
+// prefix match stays a range scan on idx_entries_mime.
+std::string prefix_upper_bound(std::string prefix) {
+  while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF) prefix.pop_back();
+  if (!prefix.empty()) prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+  return prefix;
+}
+
+int bind_filters(sqlite3_stmt* stmt, int idx, const karing::dao::KaringDao::Filters& filters) {
+  if (filters.mime.has_value()) sqlite3_bind_text(stmt, idx++, filters.mime->c_str(), -1, SQLITE_TRANSIENT);
+  if (filters.mime_prefix.has_value()) {
+    sqlite3_bind_text(stmt, idx++, filters.mime_prefix->c_str(), -1, SQLITE_TRANSIENT);
+    const std::string upper = prefix_upper_bound(*filters.mime_prefix);
+    // An empty blob sorts after every text value, i.e. no upper bound.
+    if (upper.empty()) {
+      sqlite3_bind_zeroblob(stmt, idx++, 0);
+    } else {
+      sqlite3_bind_text(stmt, idx++, upper.c_str(), -1, SQLITE_TRANSIENT);
+    }
+  }
+  if (filters.filename.has_value()) sqlite3_bind_text(stmt, idx++, filters.filename->c_str(), -1, SQLITE_TRANSIENT);
+  return idx;
+}
+
+// Keyset predicate for filters.after; NULL sort values order lowest, as in ORDER BY.
+std::string after_clause(const karing::dao::KaringDao::Filters& filters, const std::string& prefix = "") {
+  if (!filters.after.has_value() || filters.sort == karing::dao::SortField::rank) return "";
+  const std::string id = prefix + "id";
+  const char* op = filters.order_desc ? " < " : " > ";
+  if (filters.sort == karing::dao::SortField::id) return " AND " + id + op + "?";
+  const std::string column = prefix + dao::detail::sort_column(filters.sort);
+  if (filters.after->value.has_value()) {
+    return filters.order_desc ? " AND ((" + column + ", " + id + ") < (?, ?) OR " + column + " IS NULL)"
+                              : " AND (" + column + ", " + id + ") > (?, ?)";
+  }
+  return filters.order_desc ? " AND " + column + " IS NULL AND " + id + " < ?"
+                            : " AND (" + column + " IS NOT NULL OR " + id + " > ?)";
+}
+
+int bind_after(sqlite3_stmt* stmt, int idx, const karing::dao::KaringDao::Filters& filters) {
+  if (!filters.after.has_value() || filters.sort == karing::dao::SortField::rank) return idx;
+  if (filters.sort != karing::dao::SortField::id && filters.after->value.has_value()) {
+    sqlite3_bind_int64(stmt, idx++, *filters.after->value);
+  }
+  sqlite3_bind_int(stmt, idx++, filters.after->id);
+  return idx;
+}
+
+// Markers snippet() puts around matched tokens; take_snippet() turns them into
+// offsets. Stored text may hold these bytes too, so the same fragment is also
+// read without markers to tell the two apart.
+constexpr char kMatchOpen = '\x02';
+constexpr char kMatchClose = '\x03';
+constexpr int kSnippetTokens = 16;
+
+// Which FTS index a search reads and the SQL for the body column of each hit;
+// `body_from_fts` when the body must be evaluated against the FTS cursor, and
+// then `plain` is the unmarked snippet read as a trailing "plain" column.
+struct fts_select {
+  std::string table{"entries_fts"};
+  std::string body{"e.content_text"};
+  std::string plain;
+  bool body_from_fts{false};
+};
+
+fts_select select_for(const karing::dao::KaringDao::Filters& filters) {
+  fts_select select;
+  if (filters.substring) select.table = "entries_fts_tri";
+  if (filters.snippet) {
+    // Column -1 lets FTS5 cut the fragment from whichever column matched best.
+    const auto snippet = [&](const std::string& open, const std::string& close) {
+      return "snippet(" + select.table + ", -1, " + open + ", " + close + ", '...', " + std::to_string(kSnippetTokens) + ")";
+    };
+    select.body = snippet("char(2)", "char(3)");
+    select.plain = snippet("''", "''");
+    select.body_from_fts = true;
+  } else {
+    select.body = content_column(filters.projection, "e.");
+  }
+  return select;
+}
+
+// bm25 with column weights for content_text, original_filename and body_text;
+// a filename hit is short and deliberate, so it counts for more than a body hit.
+std::string rank_score(const std::string& table) {
+  return "-bm25(" + table + ", 1.0, 2.0, 1.0)";
+}
+
+std::string plain_column(const fts_select& select) {
+  return select.body_from_fts ? ", " + select.plain + " AS plain" : std::string();
+}
+
+// Top-k by relevance. Without filters the LIMIT applies inside the FTS scan, so
+// only the best `limit` rowids are joined back to entries.
+std::string rank_fts_sql(bool desc, const std::string& filters, const fts_select& select) {
+  const std::string order = desc ? " DESC" : " ASC";
+  if (filters.empty()) {
+    return "SELECT e.id, e.media_kind, " + (select.body_from_fts ? std::string("r.body") : select.body) +
+           ", e.original_filename, e.mime_type, e.stored_at, e.updated_at, e.size_bytes, e.revision, r.score AS score" +
+           (select.body_from_fts ? std::string(", r.plain AS plain") : std::string()) +
+           " FROM (SELECT rowid, " + rank_score(select.table) + " AS score" +
+           (select.body_from_fts ? ", " + select.body + " AS body, " + select.plain + " AS plain" : std::string()) +
+           " FROM " + select.table + " WHERE " + select.table + " MATCH ? ORDER BY score" + order +
+           " LIMIT ?) r JOIN entries e ON e.id = r.rowid "
+           "WHERE e.used=1 ORDER BY r.score" + order + ", e.id" + order + ";";
+  }
+  return "SELECT e.id, e.media_kind, " + select.body +
+         ", e.original_filename, e.mime_type, e.stored_at, e.updated_at, e.size_bytes, e.revision, " + rank_score(select.table) +
+         " AS score" + plain_column(select) +
+         " FROM entries e JOIN " + select.table + " f ON f.rowid = e.id "
+         "WHERE e.used=1 AND " + select.table + " MATCH ?" +
+         filters + " ORDER BY score" + order + ", e.id" + order + " LIMIT ?;";
+}
+
+std::string search_fts_sql(karing::dao::SortField sort,
+                           bool desc,
+                           const std::string& filters = "",
+                           const fts_select& select = {}) {
+  if (sort == karing::dao::SortField::rank) return rank_fts_sql(desc, filters, select);
+  return "SELECT e.id, e.media_kind, " + select.body +
+         ", e.original_filename, e.mime_type, e.stored_at, e.updated_at, e.size_bytes, e.revision" +
+         plain_column(select) +
+         " FROM entries e JOIN " + select.table + " f ON f.rowid = e.id "
+         "WHERE e.used=1 AND " + select.table + " MATCH ?" +
+         filters + " " +
+         dao::detail::order_by_clause(sort, desc, "e") +
+         " LIMIT ?;";
+}
+
+void read_record_row(sqlite3_stmt* stmt, dao::KaringRecord& r) {
+  r.id = sqlite3_column_int(stmt, 0);
+  std::string media = sqlite3_column_type(stmt, 1) != SQLITE_NULL ? reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)) : "text";
+  r.is_file = media != "text";
+  if (const unsigned char* t = sqlite3_column_text(stmt, 2)) r.content = reinterpret_cast<const char*>(t);
+  if (const unsigned char* t = sqlite3_column_text(stmt, 3)) r.filename = reinterpret_cast<const char*>(t);
+  if (const unsigned char* t = sqlite3_column_text(stmt, 4)) r.mime = reinterpret_cast<const char*>(t);
+  r.created_at = sqlite3_column_type(stmt, 5) != SQLITE_NULL ? sqlite3_column_int64(stmt, 5) : 0;
+  if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) r.updated_at = sqlite3_column_int64(stmt, 6);
+  r.size_bytes = sqlite3_column_int64(stmt, 7);
+  r.revision = sqlite3_column_int64(stmt, 8);
+  if (sqlite3_column_count(stmt) > 9 && std::strcmp(sqlite3_column_name(stmt, 9), "score") == 0) {
+    r.score = sqlite3_column_double(stmt, 9);
+  }
+}
+
+// Moves a marked-up snippet from content into snippet/highlights. `plain` is
+// the same fragment without markers: a marker byte is content while it lines
+// up with `plain`, except that a match closes as soon as it can, since a close
+// marker directly follows the matched token. Anything that does not line up
+// keeps the plain text without highlights.
+void take_snippet(dao::KaringRecord& r, std::string_view plain) {
+  if (r.content.empty()) return;
+  const std::string& marked = r.content;
+  std::vector<std::pair<int, int>> highlights;
+  size_t at = 0;
+  bool open = false;
+  int start = 0;
+  bool aligned = marked.size() >= plain.size();
+  for (size_t i = 0; aligned && i < marked.size(); ++i) {
+    const char c = marked[i];
+    const bool markers_left = marked.size() - i > plain.size() - at;
+    const bool is_marker = markers_left && c == (open ? kMatchClose : kMatchOpen) &&
+                           (open || at == plain.size() || plain[at] != c);
+    if (is_marker && !open) {
+      start = static_cast<int>(at);
+      open = true;
+    } else if (is_marker) {
+      highlights.emplace_back(start, static_cast<int>(at) - start);
+      open = false;
+    } else if (at < plain.size() && plain[at] == c) {
+      ++at;
+    } else {
+      aligned = false;
+    }
+  }
+  if (aligned && !open && at == plain.size()) r.highlights = std::move(highlights);
+  r.snippet = std::string(plain);
+  r.content.clear();
+}
+
+// Compiles every sort/order variant once per connection so the first request
+// for a given ordering does not pay for it.
+void prime_sorted_statements(dao::detail::Db& db) {
+  if (db.statements_primed()) return;
+  for (const auto sort : {karing::dao::SortField::id, karing::dao::SortField::stored_at, karing::dao::SortField::updated_at}) {
+    for (const bool desc : {true, false}) {
+      db.cached(list_latest_sql(sort, desc));
+      db.cached(search_fts_sql(sort, desc));
+    }
+  }
+  for (const bool desc : {true, false}) db.cached(search_fts_sql(karing::dao::SortField::rank, desc));
+  db.mark_statements_primed();
+}
+
+// VM instructions between checks of the cancel flag.
+constexpr int kCancelCheckOps = 1000;
+
+int cancel_requested(void* flag) {
+  return static_cast<const std::atomic<bool>*>(flag)->load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+// Interrupts statements on a leased connection once `flag` is set; the
+// handler is removed again before the lease goes back to the pool.
+struct cancel_guard {
+  sqlite3* handle;
+  const std::atomic<bool>* flag;
+
+  cancel_guard(sqlite3* db, const std::atomic<bool>* cancel) : handle(db), flag(cancel) {
+    if (flag) sqlite3_progress_handler(handle, kCancelCheckOps, cancel_requested, const_cast<std::atomic<bool>*>(flag));
+  }
+  ~cancel_guard() {
+    if (flag) sqlite3_progress_handler(handle, 0, nullptr, nullptr);
+  }
+  cancel_guard(const cancel_guard&) = delete;
+  cancel_guard& operator=(const cancel_guard&) = delete;
+};
+
+}  // namespace
+
 entry_repository::entry_repository(std::string db_path) : db_path_(std::move(db_path)) {}
 
 std::optional<int> entry_repository::latest_id() const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return std::nullopt;
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db, "SELECT id FROM entries WHERE used=1 ORDER BY stored_at DESC, id DESC LIMIT 1;", -1, &stmt, nullptr) != SQLITE_OK) {
-    return std::nullopt;
-  }
+  dao::detail::Stmt stmt(db, "SELECT id FROM entries WHERE used=1 ORDER BY stored_at DESC, id DESC LIMIT 1;");
+  if (!stmt.ok()) return std::nullopt;
   std::optional<int> out;
   if (sqlite3_step(stmt) == SQLITE_ROW) out = sqlite3_column_int(stmt, 0);
-  sqlite3_finalize(stmt);
   return out;
 }
 
 std::optional<karing::dao::KaringRecord> entry_repository::get_by_id(int id) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return std::nullopt;
   dao::KaringRecord record{};
   if (!dao::detail::load_entry(db, id, record)) return std::nullopt;
   return record;
 }
 
+std::optional<karing::dao::KaringRecord> entry_repository::get_by_id(int id,
+                                                                   const karing::dao::Projection& projection) const {
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+  if (!db.ok()) return std::nullopt;
+  dao::detail::Stmt stmt(db,
+                         "SELECT id, media_kind, " + content_column(projection) +
+                             ", original_filename, mime_type, stored_at, updated_at, size_bytes, revision "
+                             "FROM entries WHERE id=? AND used=1;");
+  if (!stmt.ok()) return std::nullopt;
+  sqlite3_bind_int(stmt, 1, id);
+  if (sqlite3_step(stmt) != SQLITE_ROW) return std::nullopt;
+  dao::KaringRecord record{};
+  read_record_row(stmt, record);
+  return record;
+}
+
 bool entry_repository::get_file_record(int id, karing::dao::KaringRecord& record, std::string& file_path) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return false;
   return dao::detail::load_entry(db, id, record, &file_path);
 }
 
 std::vector<karing::dao::KaringRecord> entry_repository::list_latest(int limit, karing::dao::SortField sort, bool desc) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   std::vector<dao::KaringRecord> out;
   if (!db.ok()) return out;
-  sqlite3_stmt* stmt = nullptr;
-  const std::string sql =
-      "SELECT id, media_kind, content_text, original_filename, mime_type, stored_at, updated_at "
-      "FROM entries WHERE used=1" +
-      dao::detail::order_by_clause(sort, desc) +
-      " LIMIT ?;";
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return out;
+  prime_sorted_statements(db);
+  dao::detail::Stmt stmt(db, list_latest_sql(sort, desc));
+  if (!stmt.ok()) return out;
   sqlite3_bind_int(stmt, 1, limit);
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     dao::KaringRecord r{};
-    r.id = sqlite3_column_int(stmt, 0);
-    std::string media = sqlite3_column_type(stmt, 1) != SQLITE_NULL ? reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)) : "text";
-    r.is_file = media != "text";
-    if (const unsigned char* t = sqlite3_column_text(stmt, 2)) r.content = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 3)) r.filename = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 4)) r.mime = reinterpret_cast<const char*>(t);
-    r.created_at = sqlite3_column_type(stmt, 5) != SQLITE_NULL ? sqlite3_column_int64(stmt, 5) : 0;
-    if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) r.updated_at = sqlite3_column_int64(stmt, 6);
+    read_record_row(stmt, r);
     out.push_back(std::move(r));
   }
-  sqlite3_finalize(stmt);
   return out;
 }
 
@@ -66,119 +319,149 @@ bool entry_repository::search_fts(const std::string& fts_query,
                                   karing::dao::SortField sort,
                                   bool desc,
                                   std::vector<karing::dao::KaringRecord>& out) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return false;
-  sqlite3_stmt* stmt = nullptr;
-  const std::string sql =
-      "SELECT e.id, e.media_kind, e.content_text, e.original_filename, e.mime_type, e.stored_at, e.updated_at "
-      "FROM entries e JOIN entries_fts f ON f.rowid = e.id "
-      "WHERE e.used=1 AND entries_fts MATCH ? " +
-      dao::detail::order_by_clause(sort, desc, "e") +
-      " LIMIT ?;";
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+  prime_sorted_statements(db);
+  dao::detail::Stmt stmt(db, search_fts_sql(sort, desc));
+  if (!stmt.ok()) return false;
   sqlite3_bind_text(stmt, 1, fts_query.c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_int(stmt, 2, limit);
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     dao::KaringRecord r{};
-    r.id = sqlite3_column_int(stmt, 0);
-    std::string media = sqlite3_column_type(stmt, 1) != SQLITE_NULL ? reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)) : "text";
-    r.is_file = media != "text";
-    if (const unsigned char* t = sqlite3_column_text(stmt, 2)) r.content = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 3)) r.filename = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 4)) r.mime = reinterpret_cast<const char*>(t);
-    r.created_at = sqlite3_column_type(stmt, 5) != SQLITE_NULL ? sqlite3_column_int64(stmt, 5) : 0;
-    if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) r.updated_at = sqlite3_column_int64(stmt, 6);
+    read_record_row(stmt, r);
     out.push_back(std::move(r));
   }
-  sqlite3_finalize(stmt);
+  return true;
+}
+
+bool entry_repository::search_fts(const std::string& fts_query,
+                                  int limit,
+                                  const karing::dao::KaringDao::Filters& filters,
+                                  std::vector<karing::dao::KaringRecord>& out) const {
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+  if (!db.ok()) return false;
+  prime_sorted_statements(db);
+  dao::detail::Stmt stmt(db, search_fts_sql(filters.sort, filters.order_desc,
+                                            filter_clause(filters, "e.") + after_clause(filters, "e."),
+                                            select_for(filters)));
+  if (!stmt.ok()) return false;
+  sqlite3_bind_text(stmt, 1, fts_query.c_str(), -1, SQLITE_TRANSIENT);
+  const int idx = bind_after(stmt, bind_filters(stmt, 2, filters), filters);
+  sqlite3_bind_int(stmt, idx, limit);
+  const cancel_guard guard(db, filters.cancel);
+  const auto first = out.size();
+  int rc = SQLITE_ROW;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    dao::KaringRecord r{};
+    read_record_row(stmt, r);
+    if (filters.snippet) {
+      const int column = sqlite3_column_count(stmt) - 1;
+      const auto* plain = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+      take_snippet(r, plain ? std::string_view(plain, static_cast<size_t>(sqlite3_column_bytes(stmt, column)))
+                            : std::string_view());
+    }
+    out.push_back(std::move(r));
+  }
+  if (rc == SQLITE_INTERRUPT) {
+    out.resize(first);
+    return false;
+  }
+  return true;
+}
+
+bool entry_repository::load_search_text(const std::vector<int>& ids, size_t max_bytes, std::vector<std::string>& out) const {
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+  if (!db.ok()) return false;
+  dao::detail::Stmt stmt(db,
+                         "SELECT coalesce(content_text, ''), coalesce(original_filename, ''), coalesce(body_text, '') "
+                         "FROM entries WHERE id=? AND used=1;");
+  if (!stmt.ok()) return false;
+  size_t total = 0;
+  for (const int id : ids) {
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+    const auto* content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    const auto content_bytes = static_cast<size_t>(sqlite3_column_bytes(stmt, 0));
+    const auto* filename = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    const auto filename_bytes = static_cast<size_t>(sqlite3_column_bytes(stmt, 1));
+    const auto* body = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+    const auto body_bytes = static_cast<size_t>(sqlite3_column_bytes(stmt, 2));
+    total += content_bytes + filename_bytes + body_bytes + 2;
+    if (total > max_bytes || !content || !filename || !body) return false;
+    std::string text(content, content_bytes);
+    text.push_back('\n');
+    text.append(filename, filename_bytes);
+    text.push_back('\n');
+    text.append(body, body_bytes);
+    out.push_back(std::move(text));
+  }
   return true;
 }
 
 int entry_repository::count_active() const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return 0;
-  sqlite3_stmt* stmt = nullptr;
+  dao::detail::Stmt stmt(db, "SELECT COUNT(1) FROM entries WHERE used=1;");
   int count = 0;
-  if (sqlite3_prepare_v2(db, "SELECT COUNT(1) FROM entries WHERE used=1;", -1, &stmt, nullptr) == SQLITE_OK) {
-    if (sqlite3_step(stmt) == SQLITE_ROW) count = sqlite3_column_int(stmt, 0);
-  }
-  if (stmt) sqlite3_finalize(stmt);
+  if (stmt.ok() && sqlite3_step(stmt) == SQLITE_ROW) count = sqlite3_column_int(stmt, 0);
   return count;
 }
 
 bool entry_repository::count_search_fts(const std::string& fts_query, long long& out) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return false;
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "SELECT COUNT(1) "
-      "FROM entries e JOIN entries_fts f ON f.rowid = e.id "
-      "WHERE e.used=1 AND entries_fts MATCH ?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+  dao::detail::Stmt stmt(db,
+                         "SELECT COUNT(1) "
+                         "FROM entries e JOIN entries_fts f ON f.rowid = e.id "
+                         "WHERE e.used=1 AND entries_fts MATCH ?;");
+  if (!stmt.ok()) return false;
   sqlite3_bind_text(stmt, 1, fts_query.c_str(), -1, SQLITE_TRANSIENT);
   if (sqlite3_step(stmt) == SQLITE_ROW) out = sqlite3_column_int64(stmt, 0);
-  sqlite3_finalize(stmt);
   return true;
 }
 
 std::vector<karing::dao::KaringRecord> entry_repository::list_filtered(int limit, const karing::dao::KaringDao::Filters& filters) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   std::vector<dao::KaringRecord> out;
   if (!db.ok()) return out;
 
-  std::string sql =
-      "SELECT id, media_kind, content_text, original_filename, mime_type, stored_at, updated_at "
-      "FROM entries WHERE 1=1";
+  std::string sql = "SELECT id, media_kind, " + content_column(filters.projection) +
+                    ", original_filename, mime_type, stored_at, updated_at, size_bytes, revision "
+                    "FROM entries WHERE 1=1";
   if (!filters.include_inactive) sql += " AND used=1";
-  if (filters.is_file.has_value()) sql += (*filters.is_file == 1) ? " AND media_kind != 'text'" : " AND media_kind = 'text'";
-  if (filters.mime.has_value()) sql += " AND mime_type = ?";
-  if (filters.filename.has_value()) sql += " AND original_filename = ?";
+  sql += filter_clause(filters);
+  sql += after_clause(filters);
   sql += dao::detail::order_by_clause(filters.sort, filters.order_desc);
   sql += " LIMIT ?";
 
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return out;
-  int idx = 1;
-  if (filters.mime.has_value()) sqlite3_bind_text(stmt, idx++, filters.mime->c_str(), -1, SQLITE_TRANSIENT);
-  if (filters.filename.has_value()) sqlite3_bind_text(stmt, idx++, filters.filename->c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int(stmt, idx++, limit);
+  dao::detail::Stmt stmt(db, sql);
+  if (!stmt.ok()) return out;
+  const int idx = bind_after(stmt, bind_filters(stmt, 1, filters), filters);
+  sqlite3_bind_int(stmt, idx, limit);
 
   while (sqlite3_step(stmt) == SQLITE_ROW) {
     dao::KaringRecord r{};
-    r.id = sqlite3_column_int(stmt, 0);
-    std::string media = sqlite3_column_type(stmt, 1) != SQLITE_NULL ? reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)) : "text";
-    r.is_file = media != "text";
-    if (const unsigned char* t = sqlite3_column_text(stmt, 2)) r.content = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 3)) r.filename = reinterpret_cast<const char*>(t);
-    if (const unsigned char* t = sqlite3_column_text(stmt, 4)) r.mime = reinterpret_cast<const char*>(t);
-    r.created_at = sqlite3_column_type(stmt, 5) != SQLITE_NULL ? sqlite3_column_int64(stmt, 5) : 0;
-    if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) r.updated_at = sqlite3_column_int64(stmt, 6);
+    read_record_row(stmt, r);
     out.push_back(std::move(r));
   }
-
-  sqlite3_finalize(stmt);
   return out;
 }
 
 long long entry_repository::count_filtered(const karing::dao::KaringDao::Filters& filters) const {
-  dao::detail::Db db(db_path_);
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
   if (!db.ok()) return 0;
 
   std::string sql = "SELECT COUNT(1) FROM entries WHERE 1=1";
   if (!filters.include_inactive) sql += " AND used=1";
-  if (filters.is_file.has_value()) sql += (*filters.is_file == 1) ? " AND media_kind != 'text'" : " AND media_kind = 'text'";
-  if (filters.mime.has_value()) sql += " AND mime_type = ?";
-  if (filters.filename.has_value()) sql += " AND original_filename = ?";
+  sql += filter_clause(filters);
 
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return 0;
-  int idx = 1;
-  if (filters.mime.has_value()) sqlite3_bind_text(stmt, idx++, filters.mime->c_str(), -1, SQLITE_TRANSIENT);
-  if (filters.filename.has_value()) sqlite3_bind_text(stmt, idx++, filters.filename->c_str(), -1, SQLITE_TRANSIENT);
+  dao::detail::Stmt stmt(db, sql);
+  if (!stmt.ok()) return 0;
+  bind_filters(stmt, 1, filters);
 
   long long count = 0;
   if (sqlite3_step(stmt) == SQLITE_ROW) count = sqlite3_column_int64(stmt, 0);
-  sqlite3_finalize(stmt);
   return count;
 }
 
@@ -14,6 +14,7 @@ class entry_repository {
 
   std::optional<int> latest_id() const;
   std::optional<karing::dao::KaringRecord> get_by_id(int id) const;
+  std::optional<karing::dao::KaringRecord> get_by_id(int id, const karing::dao::Projection& projection) const;
   bool get_file_record(int id, karing::dao::KaringRecord& record, std::string& file_path) const;
 
   std::vector<karing::dao::KaringRecord> list_latest(int limit, karing::dao::SortField sort, bool desc) const;
@@ -22,6 +23,11 @@ class entry_repository {
                   karing::dao::SortField sort,
                   bool desc,
                   std::vector<karing::dao::KaringRecord>& out) const;
+  bool search_fts(const std::string& fts_query,
+                  int limit,
+                  const karing::dao::KaringDao::Filters& filters,
+                  std::vector<karing::dao::KaringRecord>& out) const;
+  bool load_search_text(const std::vector<int>& ids, size_t max_bytes, std::vector<std::string>& out) const;
 
   int count_active() const;
   bool count_search_fts(const std::string& fts_query, long long& out) const;
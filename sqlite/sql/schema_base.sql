@@ -24,7 +24,11 @@ CREATE TABLE IF NOT EXISTS entries (
   mime_type TEXT,
   size_bytes INTEGER NOT NULL DEFAULT 0 CHECK (size_bytes >= 0),
   stored_at INTEGER,
-  updated_at INTEGER
+  updated_at INTEGER,
+  -- Indexed prefix of a text-like upload; NULL until indexed.
+  body_text TEXT,
+  -- Bumped by every write that changes what the row serves; part of its ETag.
+  revision INTEGER NOT NULL DEFAULT 0
 );
 
 CREATE INDEX IF NOT EXISTS idx_entries_used_updated
@@ -1,30 +1,37 @@
+-- {{prefix}} is replaced with the configured prefix index lengths by rebuild_fts().
 CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts
 USING fts5(
   content_text,
   original_filename,
+  body_text,
   content='entries',
-  content_rowid='id'
+  content_rowid='id',
+  prefix='{{prefix}}'
 );
 
 CREATE TRIGGER IF NOT EXISTS entries_ai
 AFTER INSERT ON entries
 BEGIN
-  INSERT INTO entries_fts(rowid, content_text, original_filename)
-  SELECT NEW.id, NEW.content_text, NEW.original_filename
+  INSERT INTO entries_fts(rowid, content_text, original_filename, body_text)
+  SELECT NEW.id, NEW.content_text, NEW.original_filename, NEW.body_text
   WHERE NEW.used = 1;
 END;
 
 CREATE TRIGGER IF NOT EXISTS entries_au
-AFTER UPDATE OF used, content_text, original_filename ON entries
+AFTER UPDATE OF used, content_text, original_filename, body_text ON entries
 BEGIN
-  INSERT INTO entries_fts(entries_fts, rowid) VALUES ('delete', OLD.id);
-  INSERT INTO entries_fts(rowid, content_text, original_filename)
-  SELECT NEW.id, NEW.content_text, NEW.original_filename
+  INSERT INTO entries_fts(entries_fts, rowid, content_text, original_filename, body_text)
+  SELECT 'delete', OLD.id, OLD.content_text, OLD.original_filename, OLD.body_text
+  WHERE OLD.used = 1;
+  INSERT INTO entries_fts(rowid, content_text, original_filename, body_text)
+  SELECT NEW.id, NEW.content_text, NEW.original_filename, NEW.body_text
   WHERE NEW.used = 1;
 END;
 
 CREATE TRIGGER IF NOT EXISTS entries_ad
 AFTER DELETE ON entries
 BEGIN
-  INSERT INTO entries_fts(entries_fts, rowid) VALUES ('delete', OLD.id);
+  INSERT INTO entries_fts(entries_fts, rowid, content_text, original_filename, body_text)
+  SELECT 'delete', OLD.id, OLD.content_text, OLD.original_filename, OLD.body_text
+  WHERE OLD.used = 1;
 END;
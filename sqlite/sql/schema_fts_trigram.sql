@@ -0,0 +1,36 @@
+CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts_tri
+USING fts5(
+  content_text,
+  original_filename,
+  body_text,
+  content='entries',
+  content_rowid='id',
+  tokenize='trigram'
+);
+
+CREATE TRIGGER IF NOT EXISTS entries_tri_ai
+AFTER INSERT ON entries
+BEGIN
+  INSERT INTO entries_fts_tri(rowid, content_text, original_filename, body_text)
+  SELECT NEW.id, NEW.content_text, NEW.original_filename, NEW.body_text
+  WHERE NEW.used = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS entries_tri_au
+AFTER UPDATE OF used, content_text, original_filename, body_text ON entries
+BEGIN
+  INSERT INTO entries_fts_tri(entries_fts_tri, rowid, content_text, original_filename, body_text)
+  SELECT 'delete', OLD.id, OLD.content_text, OLD.original_filename, OLD.body_text
+  WHERE OLD.used = 1;
+  INSERT INTO entries_fts_tri(rowid, content_text, original_filename, body_text)
+  SELECT NEW.id, NEW.content_text, NEW.original_filename, NEW.body_text
+  WHERE NEW.used = 1;
+END;
+
+CREATE TRIGGER IF NOT EXISTS entries_tri_ad
+AFTER DELETE ON entries
+BEGIN
+  INSERT INTO entries_fts_tri(entries_fts_tri, rowid, content_text, original_filename, body_text)
+  SELECT 'delete', OLD.id, OLD.content_text, OLD.original_filename, OLD.body_text
+  WHERE OLD.used = 1;
+END;
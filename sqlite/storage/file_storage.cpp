@@ -1,34 +1,98 @@
 #include "storage/file_storage.h"
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 
+#include "storage/gzip.h"
+
 namespace fs = std::filesystem;
 
 namespace karing::storage {
 
+namespace {
+
+constexpr const char* kGzipSuffix = ".gz";
+// Uploads are compressed once, so spend the extra CPU on the smallest file.
+constexpr int kStoreGzipLevel = 9;
+
+std::atomic<bool>& configured_gzip_text() {
+  static std::atomic<bool> gzip_text{file_storage_options{}.gzip_text};
+  return gzip_text;
+}
+
+std::string stamp() {
+  return std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+bool write_file(const std::string& path, const std::string& data) {
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  if (!ofs.is_open()) return false;
+  ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+  return ofs.good();
+}
+
+}  // namespace
+
 file_storage::file_storage(std::string root) : root_(std::move(root)) {}
 
-bool file_storage::write_for_slot(int id, const std::string& data, std::string& out_path) const {
+void file_storage::configure(const file_storage_options& options) {
+  configured_gzip_text().store(options.gzip_text, std::memory_order_relaxed);
+}
+
+bool file_storage::gzip_text() {
+  return configured_gzip_text().load(std::memory_order_relaxed);
+}
+
+bool file_storage::write_for_slot(int id, const std::string& data, std::string& out_path, bool gzip) const {
   if (root_.empty()) return false;
   std::error_code ec;
   fs::create_directories(root_, ec);
   if (ec) return false;
 
-  const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
-  out_path = (fs::path(root_) / ("entry_" + std::to_string(id) + "_" + std::to_string(stamp))).string();
-  std::ofstream ofs(out_path, std::ios::binary | std::ios::trunc);
-  if (!ofs.is_open()) return false;
-  ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
-  return ofs.good();
+  out_path = (fs::path(root_) / ("entry_" + std::to_string(id) + "_" + stamp())).string();
+  if (!gzip || !gzip_text()) return write_file(out_path, data);
+  std::string packed;
+  if (!gzip_compress(data, kStoreGzipLevel, packed)) return false;
+  out_path += kGzipSuffix;
+  return write_file(out_path, packed);
 }
 
 bool file_storage::read(const std::string& path, std::string& out_data) {
+  if (!is_gzip(path)) return read_stored(path, out_data);
+  std::string packed;
+  return read_stored(path, packed) && gzip_decompress(packed, out_data);
+}
+
+bool file_storage::read_stored(const std::string& path, std::string& out_data) {
+  std::error_code ec;
+  const auto size = fs::file_size(path, ec);
+  if (ec) return false;
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) return false;
+  out_data.resize(static_cast<size_t>(size));
+  ifs.read(out_data.data(), static_cast<std::streamsize>(size));
+  out_data.resize(static_cast<size_t>(ifs.gcount()));
+  return !ifs.bad();
+}
+
+bool file_storage::is_gzip(const std::string& path) {
+  const std::string suffix(kGzipSuffix);
+  return path.size() > suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool file_storage::read_prefix(const std::string& path, size_t max_bytes, std::string& out_data) {
+  if (is_gzip(path)) {
+    std::string packed;
+    return read_stored(path, packed) && gzip_decompress(packed, out_data, max_bytes);
+  }
   std::ifstream ifs(path, std::ios::binary);
   if (!ifs.is_open()) return false;
-  out_data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
-  return true;
+  out_data.resize(max_bytes);
+  ifs.read(out_data.data(), static_cast<std::streamsize>(max_bytes));
+  out_data.resize(static_cast<size_t>(ifs.gcount()));
+  return !ifs.bad();
 }
 
 void file_storage::remove_if_any(const std::string& path) {
@@ -1,16 +1,34 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace karing::storage {
 
+struct file_storage_options {
+  // Write uploads the caller marks compressible as gzip (".gz" paths).
+  bool gzip_text{false};
+};
+
 class file_storage {
  public:
   explicit file_storage(std::string root);
 
-  bool write_for_slot(int id, const std::string& data, std::string& out_path) const;
+  // Applies to every write after the call; set once at startup.
+  static void configure(const file_storage_options& options);
+  static bool gzip_text();
+
+  // `gzip`: store the data compressed; ignored unless gzip_text() is on.
+  bool write_for_slot(int id, const std::string& data, std::string& out_path, bool gzip = false) const;
 
+  // Plain file contents; gzip-stored files are inflated.
   static bool read(const std::string& path, std::string& out_data);
+  // At most `max_bytes` from the start of the (inflated) file.
+  static bool read_prefix(const std::string& path, size_t max_bytes, std::string& out_data);
+  // The bytes as they are on disk, i.e. the gzip stream when is_gzip(path).
+  // Downloads stream the file instead; this is for callers that need it whole.
+  static bool read_stored(const std::string& path, std::string& out_data);
+  static bool is_gzip(const std::string& path);
   static void remove_if_any(const std::string& path);
 
  private:
@@ -0,0 +1,55 @@
+#include "storage/gzip.h"
+
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace karing::storage {
+
+namespace {
+
+// windowBits 15 plus 16 selects the gzip wrapper instead of zlib's.
+constexpr int kGzipWindowBits = 15 + 16;
+constexpr size_t kChunk = 64 * 1024;
+
+}  // namespace
+
+bool gzip_compress(std::string_view data, int level, std::string& out) {
+  out.clear();
+  z_stream zs{};
+  if (deflateInit2(&zs, level, Z_DEFLATED, kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+  out.resize(deflateBound(&zs, static_cast<uLong>(data.size())));
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = static_cast<uInt>(out.size());
+  const int rc = deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  return rc == Z_STREAM_END;
+}
+
+bool gzip_decompress(std::string_view data, std::string& out, size_t max_bytes) {
+  out.clear();
+  z_stream zs{};
+  if (inflateInit2(&zs, kGzipWindowBits) != Z_OK) return false;
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+
+  int rc = Z_OK;
+  while (rc != Z_STREAM_END && (max_bytes == 0 || out.size() < max_bytes)) {
+    const size_t used = out.size();
+    size_t room = kChunk;
+    if (max_bytes > 0) room = std::min(room, max_bytes - used);
+    out.resize(used + room);
+    zs.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+    zs.avail_out = static_cast<uInt>(room);
+    rc = inflate(&zs, Z_NO_FLUSH);
+    out.resize(used + room - zs.avail_out);
+    if (rc != Z_OK && rc != Z_STREAM_END) break;
+  }
+  inflateEnd(&zs);
+  return rc == Z_STREAM_END || (rc == Z_OK && max_bytes > 0 && out.size() >= max_bytes);
+}
+
+}  // namespace karing::storage
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace karing::storage {
+
+// One gzip member holding `data`, at zlib `level` (1-9).
+bool gzip_compress(std::string_view data, int level, std::string& out);
+// Inflates a gzip stream. With `max_bytes` > 0 it stops once that much
+// output exists, so a prefix of a large file costs only that prefix.
+bool gzip_decompress(std::string_view data, std::string& out, size_t max_bytes = 0);
+
+}  // namespace karing::storage
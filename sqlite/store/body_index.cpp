@@ -0,0 +1,116 @@
+#include "store/body_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include "dao/karing_dao_internal.h"
+#include "store/entry_store.h"
+
+namespace karing::store {
+
+namespace {
+
+std::atomic<size_t>& configured_max_bytes() {
+  static std::atomic<size_t> max_bytes{body_index_options{}.max_bytes};
+  return max_bytes;
+}
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::unique_ptr<body_backfill>>& registry() {
+  static std::map<std::string, std::unique_ptr<body_backfill>> backfills;
+  return backfills;
+}
+
+}  // namespace
+
+void configure_body_index(const body_index_options& options) {
+  configured_max_bytes().store(options.max_bytes, std::memory_order_relaxed);
+}
+
+size_t body_index_max_bytes() {
+  return configured_max_bytes().load(std::memory_order_relaxed);
+}
+
+size_t utf8_prefix_length(const std::string& data, size_t max_bytes) {
+  if (data.size() <= max_bytes) return data.size();
+  size_t n = max_bytes;
+  // data[n] is the first byte left out; if it continues a sequence, drop that sequence too.
+  while (n > 0 && (static_cast<unsigned char>(data[n]) & 0xC0) == 0x80) --n;
+  return n;
+}
+
+std::optional<std::string> indexable_body(const std::string& mime, const std::string& data) {
+  const auto max_bytes = body_index_max_bytes();
+  if (max_bytes == 0 || dao::detail::media_kind_for_mime(mime) != "text") return std::nullopt;
+  return data.substr(0, utf8_prefix_length(data, max_bytes));
+}
+
+body_backfill::body_backfill(std::string db_path) : db_path_(std::move(db_path)) {}
+
+body_backfill::~body_backfill() {
+  stop();
+}
+
+body_backfill& body_backfill::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& backfills = registry();
+  auto it = backfills.find(db_path);
+  if (it == backfills.end()) it = backfills.emplace(db_path, std::make_unique<body_backfill>(db_path)).first;
+  return *it->second;
+}
+
+bool body_backfill::start(const backfill_options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stats_.running) return true;
+  if (worker_.joinable()) worker_.join();
+  options_ = options;
+  options_.batch = std::max(1, options_.batch);
+  options_.pause_ms = std::max(0, options_.pause_ms);
+  stopping_ = false;
+  stats_.running = true;
+  worker_ = std::thread([this] { run(); });
+  return true;
+}
+
+void body_backfill::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+backfill_stats body_backfill::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void body_backfill::run() {
+  const entry_store store(db_path_, std::string());
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    lock.unlock();
+    const int indexed = store.index_pending_bodies(options_.batch);
+    lock.lock();
+    if (indexed < 0) {
+      // Likely a busy writer; try again after a longer pause.
+      ++stats_.failed_batches;
+      wake_.wait_for(lock, std::chrono::milliseconds(std::max(options_.pause_ms, 1) * 20), [&] { return stopping_; });
+      continue;
+    }
+    stats_.indexed += indexed;
+    if (indexed == 0) break;
+    wake_.wait_for(lock, std::chrono::milliseconds(options_.pause_ms), [&] { return stopping_; });
+  }
+  stats_.running = false;
+}
+
+}  // namespace karing::store
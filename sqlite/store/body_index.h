@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace karing::store {
+
+struct body_index_options {
+  // Leading bytes of each text-like upload stored in entries.body_text for
+  // full-text search; 0 stops indexing new uploads.
+  size_t max_bytes{256 * 1024};
+};
+
+// Applies to every write after the call; set once at startup.
+void configure_body_index(const body_index_options& options);
+size_t body_index_max_bytes();
+
+// The part of an upload to index: at most body_index_max_bytes(), cut at a
+// UTF-8 boundary. nullopt when `mime` is not text-like or indexing is off.
+std::optional<std::string> indexable_body(const std::string& mime, const std::string& data);
+// Bytes of `data` kept when it is cut to `max_bytes` without splitting a UTF-8 sequence.
+size_t utf8_prefix_length(const std::string& data, size_t max_bytes);
+
+struct backfill_options {
+  // Rows indexed per write job, and the pause between jobs so uploads and
+  // edits are not starved while the backlog drains.
+  int batch{32};
+  int pause_ms{50};
+};
+
+struct backfill_stats {
+  bool running{false};
+  long long indexed{0};
+  long long failed_batches{0};
+};
+
+// Background job that indexes the bodies of text-like uploads stored before
+// body indexing existed (or while it was off). It exits once nothing is left.
+class body_backfill {
+ public:
+  explicit body_backfill(std::string db_path);
+  ~body_backfill();
+
+  body_backfill(const body_backfill&) = delete;
+  body_backfill& operator=(const body_backfill&) = delete;
+
+  static body_backfill& for_path(const std::string& db_path);
+
+  bool start(const backfill_options& options);
+  void stop();
+
+  backfill_stats stats() const;
+
+ private:
+  void run();
+
+  std::string db_path_;
+  backfill_options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread worker_;
+  bool stopping_{false};
+  backfill_stats stats_;
+};
+
+}  // namespace karing::store
@@ -0,0 +1,169 @@
+#include "store/change_feed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace karing::store {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+change_feed_options& configured_options() {
+  static change_feed_options options;
+  return options;
+}
+
+std::map<std::string, std::unique_ptr<change_feed>>& registry() {
+  static std::map<std::string, std::unique_ptr<change_feed>> feeds;
+  return feeds;
+}
+
+}  // namespace
+
+const char* change_kind_name(change_kind kind) {
+  switch (kind) {
+    case change_kind::created:
+      return "created";
+    case change_kind::updated:
+      return "updated";
+    case change_kind::deleted:
+      return "deleted";
+    case change_kind::swapped:
+      return "swapped";
+    case change_kind::resequenced:
+      return "resequenced";
+  }
+  return "unknown";
+}
+
+std::vector<change_event> change_subscription::take(bool& lost) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lost = lost_;
+  lost_ = false;
+  wake_pending_ = false;
+  std::vector<change_event> out(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.end()));
+  queue_.clear();
+  return out;
+}
+
+void change_subscription::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  queue_.clear();
+  wake_ = nullptr;
+}
+
+change_feed::change_feed() : options_(configured_options()) {
+  options_.ring_size = std::max(1, options_.ring_size);
+  options_.subscriber_buffer = std::max(1, options_.subscriber_buffer);
+  next_id_ = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void change_feed::configure(const change_feed_options& options) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  configured_options() = options;
+}
+
+change_feed& change_feed::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& feeds = registry();
+  auto it = feeds.find(db_path);
+  if (it == feeds.end()) it = feeds.emplace(db_path, std::make_unique<change_feed>()).first;
+  return *it->second;
+}
+
+void change_feed::publish(change_kind kind, std::vector<int> ids, std::vector<karing::dao::KaringRecord> records) {
+  std::vector<std::function<void()>> wakes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    change_event event;
+    event.id = next_id_++;
+    event.kind = kind;
+    event.ids = std::move(ids);
+    event.records = std::move(records);
+    ++published_;
+
+    const auto capacity = static_cast<size_t>(options_.subscriber_buffer);
+    for (auto& subscriber : subscribers_) {
+      std::lock_guard<std::mutex> sub_lock(subscriber->mutex_);
+      if (subscriber->closed_) continue;
+      if (subscriber->queue_.size() >= capacity) {
+        // A consumer this far behind resyncs from scratch instead of holding the writer's memory.
+        dropped_ += static_cast<long long>(subscriber->queue_.size()) + 1;
+        subscriber->queue_.clear();
+        subscriber->lost_ = true;
+      } else {
+        subscriber->queue_.push_back(event);
+      }
+      if (!subscriber->wake_pending_ && subscriber->wake_) {
+        subscriber->wake_pending_ = true;
+        wakes.push_back(subscriber->wake_);
+      }
+    }
+    prune_closed();
+
+    ring_.push_back(std::move(event));
+    while (static_cast<int>(ring_.size()) > options_.ring_size) ring_.pop_front();
+  }
+  for (const auto& wake : wakes) wake();
+}
+
+std::shared_ptr<change_subscription> change_feed::subscribe(std::optional<uint64_t> last_event_id, std::function<void()> wake) {
+  auto subscriber = std::make_shared<change_subscription>();
+  bool needs_wake = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> sub_lock(subscriber->mutex_);
+    subscriber->wake_ = wake;
+    if (last_event_id) {
+      const uint64_t newest = next_id_ - 1;
+      const uint64_t resumable_from = ring_.empty() ? newest : ring_.front().id - 1;
+      if (*last_event_id < resumable_from || *last_event_id > newest) {
+        subscriber->lost_ = true;
+      } else {
+        for (const auto& event : ring_) {
+          if (event.id > *last_event_id) subscriber->queue_.push_back(event);
+        }
+        if (subscriber->queue_.size() > static_cast<size_t>(options_.subscriber_buffer)) {
+          subscriber->queue_.clear();
+          subscriber->lost_ = true;
+        }
+      }
+      needs_wake = subscriber->lost_ || !subscriber->queue_.empty();
+      subscriber->wake_pending_ = needs_wake;
+    }
+    prune_closed();
+    subscribers_.push_back(subscriber);
+  }
+  if (needs_wake && wake) wake();
+  return subscriber;
+}
+
+void change_feed::prune_closed() {
+  subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                    [](const auto& subscriber) {
+                                      std::lock_guard<std::mutex> sub_lock(subscriber->mutex_);
+                                      return subscriber->closed_;
+                                    }),
+                     subscribers_.end());
+}
+
+change_feed_stats change_feed::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  change_feed_stats out;
+  out.subscribers = static_cast<int>(std::count_if(subscribers_.begin(), subscribers_.end(), [](const auto& subscriber) {
+    std::lock_guard<std::mutex> sub_lock(subscriber->mutex_);
+    return !subscriber->closed_;
+  }));
+  out.published = published_;
+  out.dropped = dropped_;
+  return out;
+}
+
+}  // namespace karing::store
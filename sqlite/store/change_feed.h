@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "dao/karing_dao.h"
+
+namespace karing::store {
+
+enum class change_kind {
+  created,
+  updated,
+  deleted,
+  swapped,
+  resequenced,
+};
+
+const char* change_kind_name(change_kind kind);
+
+struct change_event {
+  uint64_t id{0};
+  change_kind kind{change_kind::created};
+  std::vector<int> ids;
+  // Metadata of the rows after the change, without content; empty for deleted.
+  std::vector<karing::dao::KaringRecord> records;
+};
+
+struct change_feed_options {
+  // Past events kept for Last-Event-ID resumes.
+  int ring_size{256};
+  // Events queued per subscriber before it is marked as having lost some.
+  int subscriber_buffer{64};
+};
+
+struct change_feed_stats {
+  int subscribers{0};
+  long long published{0};
+  long long dropped{0};
+};
+
+class change_feed;
+
+// One consumer's queue. The feed calls `wake` when events arrive for an empty
+// queue; the consumer then drains them with take().
+class change_subscription {
+ public:
+  // Queued events, oldest first. `lost` is set when the buffer overflowed or
+  // the resume point had already left the ring, so the consumer must resync.
+  std::vector<change_event> take(bool& lost);
+  // Stops delivery; the feed forgets the subscription on its next publish or subscribe.
+  void close();
+
+ private:
+  friend class change_feed;
+
+  std::mutex mutex_;
+  std::deque<change_event> queue_;
+  std::function<void()> wake_;
+  bool lost_{false};
+  bool wake_pending_{false};
+  bool closed_{false};
+};
+
+// In-process broadcast of committed entry mutations for one database,
+// published by entry_store once a write has committed. Event ids start at the
+// feed's creation time in microseconds, so an id from an earlier process is
+// never mistaken for one in this ring.
+class change_feed {
+ public:
+  change_feed();
+
+  change_feed(const change_feed&) = delete;
+  change_feed& operator=(const change_feed&) = delete;
+
+  // Applies to feeds created after the call; set once at startup.
+  static void configure(const change_feed_options& options);
+  static change_feed& for_path(const std::string& db_path);
+
+  void publish(change_kind kind, std::vector<int> ids, std::vector<karing::dao::KaringRecord> records = {});
+
+  // Replays ring events after `last_event_id`, then follows new ones.
+  std::shared_ptr<change_subscription> subscribe(std::optional<uint64_t> last_event_id, std::function<void()> wake);
+
+  change_feed_stats stats() const;
+
+ private:
+  // Caller holds mutex_.
+  void prune_closed();
+
+  change_feed_options options_;
+
+  mutable std::mutex mutex_;
+  uint64_t next_id_{0};
+  std::deque<change_event> ring_;
+  std::vector<std::shared_ptr<change_subscription>> subscribers_;
+  long long published_{0};
+  long long dropped_{0};
+};
+
+}  // namespace karing::store
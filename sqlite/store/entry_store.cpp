@@ -1,253 +1,417 @@
 #include "store/entry_store.h"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 #include "dao/karing_dao.h"
 #include "dao/karing_dao_internal.h"
-#include "repository/store_state_repository.h"
+#include "db/slot_cursor.h"
 #include "storage/file_storage.h"
+#include "store/body_index.h"
+#include "store/change_feed.h"
+#include "store/write_queue.h"
 
 namespace karing::store {
 
 entry_store::entry_store(std::string db_path, std::string upload_path)
     : db_path_(std::move(db_path)), upload_path_(std::move(upload_path)) {}
 
-int entry_store::insert_text(const std::string& content) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return -1;
-
-  int slot_id = 0;
-  int max_items = 0;
-  repository::store_state_repository store_repo(db_path_);
-  if (!store_repo.fetch_state(slot_id, max_items)) return -1;
-
-  std::string old_file_path;
-  dao::detail::read_entry_file_path(db, slot_id, old_file_path);
-
-  if (!dao::detail::exec_simple(db, "BEGIN IMMEDIATE;")) return -1;
-
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "UPDATE entries SET "
-      "used=1, source_kind='direct_text', media_kind='text', content_text=?, file_path=NULL, "
-      "original_filename=NULL, mime_type='text/plain; charset=utf-8', size_bytes=?, stored_at=?, updated_at=? "
-      "WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return -1;
-  }
+namespace {
 
-  const auto ts = dao::detail::now_epoch();
+bool write_text(dao::detail::Db& db, int id, const std::string& content) {
+  dao::detail::Stmt stmt(db,
+                         "UPDATE entries SET "
+                         "used=1, source_kind='direct_text', media_kind='text', content_text=?, file_path=NULL, "
+                         "original_filename=NULL, mime_type='text/plain; charset=utf-8', size_bytes=?, updated_at=?, "
+                         "body_text=NULL, revision=revision+1 "
+                         "WHERE id=?;");
+  if (!stmt.ok()) return false;
   sqlite3_bind_text(stmt, 1, content.c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(content.size()));
-  sqlite3_bind_int64(stmt, 3, ts);
-  sqlite3_bind_int64(stmt, 4, ts);
-  sqlite3_bind_int(stmt, 5, slot_id);
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
-  sqlite3_finalize(stmt);
-
-  if (!ok || !dao::detail::advance_next_id(db, max_items) || !dao::detail::exec_simple(db, "COMMIT;")) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return -1;
-  }
+  sqlite3_bind_int64(stmt, 3, dao::detail::now_epoch());
+  sqlite3_bind_int(stmt, 4, id);
+  return sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
+}
 
-  storage::file_storage::remove_if_any(old_file_path);
-  return slot_id;
+void bind_body(sqlite3_stmt* stmt, int index, const std::optional<std::string>& body) {
+  if (body.has_value()) sqlite3_bind_text(stmt, index, body->data(), static_cast<int>(body->size()), SQLITE_TRANSIENT);
+  else sqlite3_bind_null(stmt, index);
 }
 
-bool entry_store::logical_delete(int id) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
+// Text-like uploads compress well; file_storage keeps them gzipped when configured to.
+bool compressible_upload(const std::string& mime) {
+  return dao::detail::media_kind_for_mime(mime) == "text";
+}
 
-  std::string file_path;
-  dao::KaringRecord dummy{};
-  if (!dao::detail::load_entry(db, id, dummy, &file_path, false)) return false;
-
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "UPDATE entries SET "
-      "used=0, source_kind=NULL, media_kind=NULL, content_text=NULL, file_path=NULL, "
-      "original_filename=NULL, mime_type=NULL, size_bytes=0, stored_at=NULL, updated_at=NULL "
-      "WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+bool write_file(dao::detail::Db& db,
+                int id,
+                const std::string& filename,
+                const std::string& mime,
+                const std::string& file_path,
+                long long size,
+                const std::optional<std::string>& body) {
+  dao::detail::Stmt stmt(db,
+                         "UPDATE entries SET "
+                         "used=1, source_kind='file_upload', media_kind=?, content_text=NULL, file_path=?, "
+                         "original_filename=?, mime_type=?, size_bytes=?, updated_at=?, body_text=?, revision=revision+1 "
+                         "WHERE id=?;");
+  if (!stmt.ok()) return false;
+  const auto media_kind = dao::detail::media_kind_for_mime(mime);
+  sqlite3_bind_text(stmt, 1, media_kind.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, file_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 3, filename.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 4, mime.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(size));
+  sqlite3_bind_int64(stmt, 6, dao::detail::now_epoch());
+  bind_body(stmt, 7, body);
+  sqlite3_bind_int(stmt, 8, id);
+  return sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
+}
+
+bool clear_slot(dao::detail::Db& db, int id, std::string& file_path) {
+  dao::KaringRecord ignored{};
+  if (!dao::detail::load_entry(db, id, ignored, &file_path, false)) return false;
+
+  dao::detail::Stmt stmt(db,
+                         "UPDATE entries SET "
+                         "used=0, source_kind=NULL, media_kind=NULL, content_text=NULL, file_path=NULL, "
+                         "original_filename=NULL, mime_type=NULL, size_bytes=0, stored_at=NULL, updated_at=NULL, body_text=NULL, "
+                         "revision=revision+1 "
+                         "WHERE id=?;");
+  if (!stmt.ok()) return false;
   sqlite3_bind_int(stmt, 1, id);
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
-  sqlite3_finalize(stmt);
-  if (ok) storage::file_storage::remove_if_any(file_path);
-  return ok;
+  return sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
 }
 
-bool entry_store::logical_delete_latest_recent(int max_age_seconds) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
-
-  repository::store_state_repository store_repo(db_path_);
-  const auto target_id = store_repo.previous_slot_id();
-  if (!target_id) return false;
-
-  sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db,
-                         "SELECT used, stored_at FROM entries WHERE id=?;",
-                         -1,
-                         &stmt,
-                         nullptr) != SQLITE_OK) {
-    return false;
+struct entry_state {
+  bool used{false};
+  std::optional<std::string> source_kind;
+  std::optional<std::string> media_kind;
+  std::optional<std::string> content_text;
+  std::optional<std::string> file_path;
+  std::optional<std::string> original_filename;
+  std::optional<std::string> mime_type;
+  long long size_bytes{0};
+  std::optional<long long> stored_at;
+  std::optional<long long> updated_at;
+  std::optional<std::string> body_text;
+};
+
+entry_state read_state_row(sqlite3_stmt* stmt) {
+  entry_state state;
+  state.used = sqlite3_column_int(stmt, 0) != 0;
+  if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) state.source_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+  if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) state.media_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+  if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) state.content_text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+  if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) state.file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+  if (sqlite3_column_type(stmt, 5) != SQLITE_NULL) state.original_filename = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+  if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) state.mime_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+  state.size_bytes = sqlite3_column_int64(stmt, 7);
+  if (sqlite3_column_type(stmt, 8) != SQLITE_NULL) state.stored_at = sqlite3_column_int64(stmt, 8);
+  if (sqlite3_column_type(stmt, 9) != SQLITE_NULL) state.updated_at = sqlite3_column_int64(stmt, 9);
+  if (sqlite3_column_type(stmt, 10) != SQLITE_NULL) {
+    state.body_text = std::string(reinterpret_cast<const char*>(sqlite3_column_blob(stmt, 10)),
+                                  static_cast<size_t>(sqlite3_column_bytes(stmt, 10)));
   }
-  sqlite3_bind_int(stmt, 1, *target_id);
-
-  bool can_delete = false;
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    const bool used = sqlite3_column_int(stmt, 0) != 0;
-    const bool has_stored_at = sqlite3_column_type(stmt, 1) != SQLITE_NULL;
-    const auto stored_at = has_stored_at ? sqlite3_column_int64(stmt, 1) : 0;
-    can_delete = used && has_stored_at && (dao::detail::now_epoch() - stored_at <= max_age_seconds);
-  }
-  sqlite3_finalize(stmt);
+  return state;
+}
 
-  if (!can_delete) return false;
-  return logical_delete(*target_id);
+bool load_state(dao::detail::Db& db, int id, entry_state& out) {
+  dao::detail::Stmt stmt(db,
+                         "SELECT used, source_kind, media_kind, content_text, file_path, original_filename, "
+                         "mime_type, size_bytes, stored_at, updated_at, body_text "
+                         "FROM entries WHERE id=?;");
+  if (!stmt.ok()) return false;
+  sqlite3_bind_int(stmt, 1, id);
+  if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+  out = read_state_row(stmt);
+  return true;
 }
 
-int entry_store::insert_file(const std::string& filename, const std::string& mime, const std::string& data) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return -1;
-  storage::file_storage storage(upload_path_);
+std::optional<std::vector<entry_state>> load_all_states(dao::detail::Db& db) {
+  dao::detail::Stmt stmt(db,
+                         "SELECT used, source_kind, media_kind, content_text, file_path, original_filename, "
+                         "mime_type, size_bytes, stored_at, updated_at, body_text "
+                         "FROM entries ORDER BY id ASC;");
+  if (!stmt.ok()) return std::nullopt;
+
+  std::vector<entry_state> states;
+  while (sqlite3_step(stmt) == SQLITE_ROW) states.push_back(read_state_row(stmt));
+  return states;
+}
+
+void bind_optional_text(sqlite3_stmt* stmt, int index, const std::optional<std::string>& value) {
+  if (value.has_value()) sqlite3_bind_text(stmt, index, value->c_str(), -1, SQLITE_TRANSIENT);
+  else sqlite3_bind_null(stmt, index);
+}
+
+void bind_optional_int64(sqlite3_stmt* stmt, int index, const std::optional<long long>& value) {
+  if (value.has_value()) sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(*value));
+  else sqlite3_bind_null(stmt, index);
+}
+
+// The revision stays with the slot, not the moved state, so a swap or
+// resequence changes the tag of every id it rewrites.
+bool store_state(dao::detail::Db& db, int id, const entry_state& state) {
+  dao::detail::Stmt stmt(db,
+                         "UPDATE entries SET "
+                         "used=?, source_kind=?, media_kind=?, content_text=?, file_path=?, original_filename=?, "
+                         "mime_type=?, size_bytes=?, stored_at=?, updated_at=?, body_text=?, revision=revision+1 "
+                         "WHERE id=?;");
+  if (!stmt.ok()) return false;
+  sqlite3_bind_int(stmt, 1, state.used ? 1 : 0);
+  bind_optional_text(stmt, 2, state.source_kind);
+  bind_optional_text(stmt, 3, state.media_kind);
+  bind_optional_text(stmt, 4, state.content_text);
+  bind_optional_text(stmt, 5, state.file_path);
+  bind_optional_text(stmt, 6, state.original_filename);
+  bind_optional_text(stmt, 7, state.mime_type);
+  sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(state.size_bytes));
+  bind_optional_int64(stmt, 9, state.stored_at);
+  bind_optional_int64(stmt, 10, state.updated_at);
+  bind_body(stmt, 11, state.body_text);
+  sqlite3_bind_int(stmt, 12, id);
+  return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+// Reservations can commit out of order, so only the furthest one moves next_id.
+// The claim is taken back if the write does not commit, so a later reservation
+// still persists its next_slot.
+bool persist_cursor(dao::detail::Db& db, db::slot_cursor& cursor, const db::slot_reservation& reservation) {
+  uint64_t previous = 0;
+  if (!cursor.claim_persist(reservation, previous)) return true;
+  write_queue::on_rollback([&cursor, reservation, previous] { cursor.restore_persist(reservation, previous); });
+  return dao::detail::write_next_id(db, reservation.next_slot);
+}
+
+// Row metadata for the change feed; bodies stay out of it.
+bool append_metadata(dao::detail::Db& db, int id, std::vector<dao::KaringRecord>& out) {
+  dao::KaringRecord record{};
+  if (!dao::detail::load_entry(db, id, record)) return false;
+  record.content.clear();
+  out.push_back(std::move(record));
+  return true;
+}
+
+std::atomic<uint64_t>& generation_for(const std::string& db_path) {
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<std::atomic<uint64_t>>> generations;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& slot = generations[db_path];
+  if (!slot) slot = std::make_unique<std::atomic<uint64_t>>(0);
+  return *slot;
+}
+
+}  // namespace
+
+uint64_t entry_store::write_generation(const std::string& db_path) {
+  return generation_for(db_path).load(std::memory_order_acquire);
+}
+
+void entry_store::publish(change_kind kind, std::vector<int> ids, std::vector<dao::KaringRecord> records) const {
+  change_feed::for_path(db_path_).publish(kind, std::move(ids), std::move(records));
+}
+
+bool entry_store::run_write(const write_queue::job& work) const {
+  const bool ok = write_queue::for_path(db_path_).run(work);
+  // Bumped before the caller sees the result, so a response to this write can
+  // never be followed by a read served from an older cache entry.
+  if (ok) generation_for(db_path_).fetch_add(1, std::memory_order_acq_rel);
+  return ok;
+}
 
-  int slot_id = 0;
-  int max_items = 0;
-  repository::store_state_repository store_repo(db_path_);
-  if (!store_repo.fetch_state(slot_id, max_items)) return -1;
+int entry_store::insert_text(const std::string& content) const {
+  auto& cursor = db::slot_cursor::for_path(db_path_);
+  auto reservation = cursor.reserve();
+  if (!reservation.ok()) return -1;
 
   std::string old_file_path;
-  dao::detail::read_entry_file_path(db, slot_id, old_file_path);
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    if (!cursor.current(reservation)) reservation = cursor.reserve();
+    if (!reservation.ok()) return false;
+    dao::detail::read_entry_file_path(db, reservation.slot, old_file_path);
+
+    dao::detail::Stmt stmt(db,
+                           "UPDATE entries SET "
+                           "used=1, source_kind='direct_text', media_kind='text', content_text=?, file_path=NULL, "
+                           "original_filename=NULL, mime_type='text/plain; charset=utf-8', size_bytes=?, stored_at=?, updated_at=?, "
+                           "body_text=NULL, revision=revision+1 "
+                           "WHERE id=?;");
+    if (!stmt.ok()) return false;
+    const auto ts = dao::detail::now_epoch();
+    sqlite3_bind_text(stmt, 1, content.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(content.size()));
+    sqlite3_bind_int64(stmt, 3, ts);
+    sqlite3_bind_int64(stmt, 4, ts);
+    sqlite3_bind_int(stmt, 5, reservation.slot);
+    if (sqlite3_step(stmt) != SQLITE_DONE || sqlite3_changes(db) == 0) return false;
+    return persist_cursor(db, cursor, reservation) && append_metadata(db, reservation.slot, changed);
+  });
+  if (!ok) return -1;
 
-  std::string new_file_path;
-  if (!storage.write_for_slot(slot_id, data, new_file_path)) return -1;
+  storage::file_storage::remove_if_any(old_file_path);
+  publish(change_kind::created, {reservation.slot}, std::move(changed));
+  return reservation.slot;
+}
 
-  if (!dao::detail::exec_simple(db, "BEGIN IMMEDIATE;")) {
-    storage::file_storage::remove_if_any(new_file_path);
-    return -1;
-  }
+bool entry_store::logical_delete(int id) const {
+  std::string file_path;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    return clear_slot(db, id, file_path);
+  });
+  if (!ok) return false;
+  storage::file_storage::remove_if_any(file_path);
+  publish(change_kind::deleted, {id});
+  return true;
+}
+
+bool entry_store::logical_delete_latest_recent(int max_age_seconds) const {
+  std::string file_path;
+  int deleted_id = 0;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    const auto target_id = dao::detail::previous_slot_id(db);
+    if (!target_id) return false;
+    deleted_id = *target_id;
+
+    bool can_delete = false;
+    {
+      dao::detail::Stmt stmt(db, "SELECT used, stored_at FROM entries WHERE id=?;");
+      if (!stmt.ok()) return false;
+      sqlite3_bind_int(stmt, 1, *target_id);
+      if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const bool used = sqlite3_column_int(stmt, 0) != 0;
+        const bool has_stored_at = sqlite3_column_type(stmt, 1) != SQLITE_NULL;
+        const auto stored_at = has_stored_at ? sqlite3_column_int64(stmt, 1) : 0;
+        can_delete = used && has_stored_at && (dao::detail::now_epoch() - stored_at <= max_age_seconds);
+      }
+    }
 
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "UPDATE entries SET "
-      "used=1, source_kind='file_upload', media_kind=?, content_text=NULL, file_path=?, "
-      "original_filename=?, mime_type=?, size_bytes=?, stored_at=?, updated_at=? "
-      "WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
+    return can_delete && clear_slot(db, *target_id, file_path);
+  });
+  if (!ok) return false;
+  storage::file_storage::remove_if_any(file_path);
+  publish(change_kind::deleted, {deleted_id});
+  return true;
+}
+
+int entry_store::insert_file(const std::string& filename, const std::string& mime, const std::string& data) const {
+  auto& cursor = db::slot_cursor::for_path(db_path_);
+  auto reservation = cursor.reserve();
+  if (!reservation.ok()) return -1;
+
+  storage::file_storage storage(upload_path_);
+  std::string new_file_path;
+  if (!storage.write_for_slot(reservation.slot, data, new_file_path, compressible_upload(mime))) {
     storage::file_storage::remove_if_any(new_file_path);
     return -1;
   }
 
-  const auto ts = dao::detail::now_epoch();
-  const auto media_kind = dao::detail::media_kind_for_mime(mime);
-  sqlite3_bind_text(stmt, 1, media_kind.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, new_file_path.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 3, filename.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 4, mime.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(data.size()));
-  sqlite3_bind_int64(stmt, 6, ts);
-  sqlite3_bind_int64(stmt, 7, ts);
-  sqlite3_bind_int(stmt, 8, slot_id);
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
-  sqlite3_finalize(stmt);
-
-  if (!ok || !dao::detail::advance_next_id(db, max_items) || !dao::detail::exec_simple(db, "COMMIT;")) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
+  const auto body = indexable_body(mime, data);
+  std::string old_file_path;
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    // A reseed (resequence or init) while this was queued hands out a fresh
+    // slot; the blob keeps its original name, which is only informational.
+    if (!cursor.current(reservation)) reservation = cursor.reserve();
+    if (!reservation.ok()) return false;
+    dao::detail::read_entry_file_path(db, reservation.slot, old_file_path);
+
+    dao::detail::Stmt stmt(db,
+                           "UPDATE entries SET "
+                           "used=1, source_kind='file_upload', media_kind=?, content_text=NULL, file_path=?, "
+                           "original_filename=?, mime_type=?, size_bytes=?, stored_at=?, updated_at=?, body_text=?, "
+                           "revision=revision+1 "
+                           "WHERE id=?;");
+    if (!stmt.ok()) return false;
+    const auto ts = dao::detail::now_epoch();
+    const auto media_kind = dao::detail::media_kind_for_mime(mime);
+    sqlite3_bind_text(stmt, 1, media_kind.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, new_file_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, filename.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, mime.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(data.size()));
+    sqlite3_bind_int64(stmt, 6, ts);
+    sqlite3_bind_int64(stmt, 7, ts);
+    bind_body(stmt, 8, body);
+    sqlite3_bind_int(stmt, 9, reservation.slot);
+    if (sqlite3_step(stmt) != SQLITE_DONE || sqlite3_changes(db) == 0) return false;
+    return persist_cursor(db, cursor, reservation) && append_metadata(db, reservation.slot, changed);
+  });
+  if (!ok) {
     storage::file_storage::remove_if_any(new_file_path);
     return -1;
   }
 
   storage::file_storage::remove_if_any(old_file_path);
-  return slot_id;
+  publish(change_kind::created, {reservation.slot}, std::move(changed));
+  return reservation.slot;
 }
 
 bool entry_store::update_text(int id, const std::string& content) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
-
   std::string old_file_path;
-  dao::KaringRecord current{};
-  if (!dao::detail::load_entry(db, id, current, &old_file_path)) return false;
-
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "UPDATE entries SET "
-      "used=1, source_kind='direct_text', media_kind='text', content_text=?, file_path=NULL, "
-      "original_filename=NULL, mime_type='text/plain; charset=utf-8', size_bytes=?, updated_at=? "
-      "WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
-  sqlite3_bind_text(stmt, 1, content.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(content.size()));
-  sqlite3_bind_int64(stmt, 3, dao::detail::now_epoch());
-  sqlite3_bind_int(stmt, 4, id);
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
-  sqlite3_finalize(stmt);
-  if (ok) storage::file_storage::remove_if_any(old_file_path);
-  return ok;
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    dao::KaringRecord current{};
+    if (!dao::detail::load_entry(db, id, current, &old_file_path)) return false;
+    return write_text(db, id, content) && append_metadata(db, id, changed);
+  });
+  if (!ok) return false;
+  storage::file_storage::remove_if_any(old_file_path);
+  publish(change_kind::updated, {id}, std::move(changed));
+  return true;
 }
 
 bool entry_store::update_file(int id, const std::string& filename, const std::string& mime, const std::string& data) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
   storage::file_storage storage(upload_path_);
+  std::string new_file_path;
+  if (!storage.write_for_slot(id, data, new_file_path, compressible_upload(mime))) return false;
 
+  const auto body = indexable_body(mime, data);
   std::string old_file_path;
-  dao::KaringRecord current{};
-  if (!dao::detail::load_entry(db, id, current, &old_file_path)) return false;
-
-  std::string new_file_path;
-  if (!storage.write_for_slot(id, data, new_file_path)) return false;
-
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "UPDATE entries SET "
-      "used=1, source_kind='file_upload', media_kind=?, content_text=NULL, file_path=?, "
-      "original_filename=?, mime_type=?, size_bytes=?, updated_at=? "
-      "WHERE id=?;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    storage::file_storage::remove_if_any(new_file_path);
-    return false;
-  }
-  const auto media_kind = dao::detail::media_kind_for_mime(mime);
-  sqlite3_bind_text(stmt, 1, media_kind.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, new_file_path.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 3, filename.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 4, mime.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(data.size()));
-  sqlite3_bind_int64(stmt, 6, dao::detail::now_epoch());
-  sqlite3_bind_int(stmt, 7, id);
-  const bool ok = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
-  sqlite3_finalize(stmt);
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    dao::KaringRecord current{};
+    if (!dao::detail::load_entry(db, id, current, &old_file_path)) return false;
+    return write_file(db, id, filename, mime, new_file_path, static_cast<long long>(data.size()), body) &&
+           append_metadata(db, id, changed);
+  });
   if (!ok) {
     storage::file_storage::remove_if_any(new_file_path);
     return false;
   }
   storage::file_storage::remove_if_any(old_file_path);
+  publish(change_kind::updated, {id}, std::move(changed));
   return true;
 }
 
 bool entry_store::patch_text(int id, const std::optional<std::string>& content) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
-  dao::KaringRecord current{};
-  std::string file_path;
-  if (!dao::detail::load_entry(db, id, current, &file_path) || current.is_file || !file_path.empty()) return false;
-  return update_text(id, content.value_or(current.content));
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    dao::KaringRecord current{};
+    std::string file_path;
+    if (!dao::detail::load_entry(db, id, current, &file_path) || current.is_file || !file_path.empty()) return false;
+    return write_text(db, id, content.value_or(current.content)) && append_metadata(db, id, changed);
+  });
+  if (!ok) return false;
+  publish(change_kind::updated, {id}, std::move(changed));
+  return true;
 }
 
 bool entry_store::patch_file(int id,
                              const std::optional<std::string>& filename,
                              const std::optional<std::string>& mime,
                              const std::optional<std::string>& data) const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
   dao::KaringRecord current{};
   std::string file_path;
-  if (!dao::detail::load_entry(db, id, current, &file_path) || file_path.empty()) return false;
+  {
+    dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+    if (!db.ok() || !dao::detail::load_entry(db, id, current, &file_path) || file_path.empty()) return false;
+  }
 
   std::string blob;
   if (data.has_value()) {
@@ -256,245 +420,154 @@ bool entry_store::patch_file(int id,
     if (!storage::file_storage::read(file_path, blob)) return false;
   }
 
-  return update_file(id,
-                     filename.value_or(current.filename),
-                     mime.value_or(current.mime),
-                     blob);
+  storage::file_storage storage(upload_path_);
+  std::string new_file_path;
+  if (!storage.write_for_slot(id, blob, new_file_path, compressible_upload(mime.value_or(current.mime)))) return false;
+  // The path check below also pins the mime, since every mime change writes a new file.
+  const auto body = indexable_body(mime.value_or(current.mime), blob);
+
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    // The blob was read outside the transaction; give up if the entry moved on since.
+    dao::KaringRecord latest{};
+    std::string latest_path;
+    if (!dao::detail::load_entry(db, id, latest, &latest_path) || latest_path != file_path) return false;
+    return write_file(db,
+                      id,
+                      filename.value_or(latest.filename),
+                      mime.value_or(latest.mime),
+                      new_file_path,
+                      static_cast<long long>(blob.size()),
+                      body) &&
+           append_metadata(db, id, changed);
+  });
+  if (!ok) {
+    storage::file_storage::remove_if_any(new_file_path);
+    return false;
+  }
+  storage::file_storage::remove_if_any(file_path);
+  publish(change_kind::updated, {id}, std::move(changed));
+  return true;
 }
 
 bool entry_store::swap_entries(int id1, int id2) const {
   if (id1 == id2) return true;
 
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return false;
-  if (!dao::detail::exec_simple(db, "BEGIN IMMEDIATE;")) return false;
-
-  struct entry_state {
-    bool used{false};
-    std::optional<std::string> source_kind;
-    std::optional<std::string> media_kind;
-    std::optional<std::string> content_text;
-    std::optional<std::string> file_path;
-    std::optional<std::string> original_filename;
-    std::optional<std::string> mime_type;
-    long long size_bytes{0};
-    std::optional<long long> stored_at;
-    std::optional<long long> updated_at;
-  };
-
-  auto load_state = [&](int id, entry_state& out) -> bool {
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql =
-        "SELECT used, source_kind, media_kind, content_text, file_path, original_filename, "
-        "mime_type, size_bytes, stored_at, updated_at "
-        "FROM entries WHERE id=?;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
-    sqlite3_bind_int(stmt, 1, id);
-    bool ok = false;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-      out.used = sqlite3_column_int(stmt, 0) != 0;
-      if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) out.source_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) out.media_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) out.content_text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) out.file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-      if (sqlite3_column_type(stmt, 5) != SQLITE_NULL) out.original_filename = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-      if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) out.mime_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      out.size_bytes = sqlite3_column_int64(stmt, 7);
-      if (sqlite3_column_type(stmt, 8) != SQLITE_NULL) out.stored_at = sqlite3_column_int64(stmt, 8);
-      if (sqlite3_column_type(stmt, 9) != SQLITE_NULL) out.updated_at = sqlite3_column_int64(stmt, 9);
-      ok = true;
-    }
-    sqlite3_finalize(stmt);
-    return ok;
-  };
-
-  auto bind_optional_text = [](sqlite3_stmt* stmt, int index, const std::optional<std::string>& value) {
-    if (value.has_value()) sqlite3_bind_text(stmt, index, value->c_str(), -1, SQLITE_TRANSIENT);
-    else sqlite3_bind_null(stmt, index);
-  };
-
-  auto bind_optional_int64 = [](sqlite3_stmt* stmt, int index, const std::optional<long long>& value) {
-    if (value.has_value()) sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(*value));
-    else sqlite3_bind_null(stmt, index);
-  };
-
-  auto store_state = [&](int id, const entry_state& state) -> bool {
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql =
-        "UPDATE entries SET "
-        "used=?, source_kind=?, media_kind=?, content_text=?, file_path=?, original_filename=?, "
-        "mime_type=?, size_bytes=?, stored_at=?, updated_at=? "
-        "WHERE id=?;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
-    sqlite3_bind_int(stmt, 1, state.used ? 1 : 0);
-    bind_optional_text(stmt, 2, state.source_kind);
-    bind_optional_text(stmt, 3, state.media_kind);
-    bind_optional_text(stmt, 4, state.content_text);
-    bind_optional_text(stmt, 5, state.file_path);
-    bind_optional_text(stmt, 6, state.original_filename);
-    bind_optional_text(stmt, 7, state.mime_type);
-    sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(state.size_bytes));
-    bind_optional_int64(stmt, 9, state.stored_at);
-    bind_optional_int64(stmt, 10, state.updated_at);
-    sqlite3_bind_int(stmt, 11, id);
-    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return ok;
-  };
-
-  entry_state first;
-  entry_state second;
-  if (!load_state(id1, first) || !load_state(id2, second)) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return false;
-  }
-
-  if (!store_state(id1, second) || !store_state(id2, first) || !dao::detail::exec_simple(db, "COMMIT;")) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return false;
-  }
-
+  std::vector<dao::KaringRecord> changed;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    entry_state first;
+    entry_state second;
+    if (!load_state(db, id1, first) || !load_state(db, id2, second)) return false;
+    if (!store_state(db, id1, second) || !store_state(db, id2, first)) return false;
+    // An empty slot has no metadata to report.
+    if (second.used && !append_metadata(db, id1, changed)) return false;
+    return !first.used || append_metadata(db, id2, changed);
+  });
+  if (!ok) return false;
+  publish(change_kind::swapped, {id1, id2}, std::move(changed));
   return true;
 }
 
-std::optional<std::pair<std::vector<karing::dao::KaringRecord>, int>> entry_store::resequence_entries() const {
-  dao::detail::Db db(db_path_);
-  if (!db.ok()) return std::nullopt;
-  if (!dao::detail::exec_simple(db, "BEGIN IMMEDIATE;")) return std::nullopt;
-
-  struct entry_state {
-    bool used{false};
-    std::optional<std::string> source_kind;
-    std::optional<std::string> media_kind;
-    std::optional<std::string> content_text;
-    std::optional<std::string> file_path;
-    std::optional<std::string> original_filename;
-    std::optional<std::string> mime_type;
-    long long size_bytes{0};
-    std::optional<long long> stored_at;
-    std::optional<long long> updated_at;
-  };
+int entry_store::index_pending_bodies(int batch) const {
+  const auto max_bytes = body_index_max_bytes();
+  if (max_bytes == 0) return 0;
 
-  auto load_all_states = [&]() -> std::optional<std::vector<entry_state>> {
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql =
-        "SELECT used, source_kind, media_kind, content_text, file_path, original_filename, "
-        "mime_type, size_bytes, stored_at, updated_at "
-        "FROM entries ORDER BY id ASC;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return std::nullopt;
-
-    std::vector<entry_state> states;
+  struct pending_body {
+    int id{0};
+    std::string file_path;
+    std::string body;
+  };
+  std::vector<pending_body> pending;
+  {
+    dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+    if (!db.ok()) return -1;
+    dao::detail::Stmt stmt(db,
+                           "SELECT id, file_path FROM entries "
+                           "WHERE used=1 AND media_kind='text' AND file_path IS NOT NULL AND body_text IS NULL "
+                           "ORDER BY id LIMIT ?;");
+    if (!stmt.ok()) return -1;
+    sqlite3_bind_int(stmt, 1, batch);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-      entry_state state;
-      state.used = sqlite3_column_int(stmt, 0) != 0;
-      if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) state.source_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) state.media_kind = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) state.content_text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) state.file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-      if (sqlite3_column_type(stmt, 5) != SQLITE_NULL) state.original_filename = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-      if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) state.mime_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      state.size_bytes = sqlite3_column_int64(stmt, 7);
-      if (sqlite3_column_type(stmt, 8) != SQLITE_NULL) state.stored_at = sqlite3_column_int64(stmt, 8);
-      if (sqlite3_column_type(stmt, 9) != SQLITE_NULL) state.updated_at = sqlite3_column_int64(stmt, 9);
-      states.push_back(std::move(state));
+      pending_body row;
+      row.id = sqlite3_column_int(stmt, 0);
+      row.file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+      pending.push_back(std::move(row));
     }
-    sqlite3_finalize(stmt);
-    return states;
-  };
-
-  auto bind_optional_text = [](sqlite3_stmt* stmt, int index, const std::optional<std::string>& value) {
-    if (value.has_value()) sqlite3_bind_text(stmt, index, value->c_str(), -1, SQLITE_TRANSIENT);
-    else sqlite3_bind_null(stmt, index);
-  };
-
-  auto bind_optional_int64 = [](sqlite3_stmt* stmt, int index, const std::optional<long long>& value) {
-    if (value.has_value()) sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(*value));
-    else sqlite3_bind_null(stmt, index);
-  };
-
-  auto store_state = [&](int id, const entry_state& state) -> bool {
-    sqlite3_stmt* stmt = nullptr;
-    const char* sql =
-        "UPDATE entries SET "
-        "used=?, source_kind=?, media_kind=?, content_text=?, file_path=?, original_filename=?, "
-        "mime_type=?, size_bytes=?, stored_at=?, updated_at=? "
-        "WHERE id=?;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
-    sqlite3_bind_int(stmt, 1, state.used ? 1 : 0);
-    bind_optional_text(stmt, 2, state.source_kind);
-    bind_optional_text(stmt, 3, state.media_kind);
-    bind_optional_text(stmt, 4, state.content_text);
-    bind_optional_text(stmt, 5, state.file_path);
-    bind_optional_text(stmt, 6, state.original_filename);
-    bind_optional_text(stmt, 7, state.mime_type);
-    sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(state.size_bytes));
-    bind_optional_int64(stmt, 9, state.stored_at);
-    bind_optional_int64(stmt, 10, state.updated_at);
-    sqlite3_bind_int(stmt, 11, id);
-    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return ok;
-  };
-
-  auto states = load_all_states();
-  if (!states.has_value()) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return std::nullopt;
   }
+  if (pending.empty()) return 0;
 
-  std::vector<std::pair<int, entry_state>> active_states;
-  active_states.reserve(states->size());
-  for (size_t i = 0; i < states->size(); ++i) {
-    if ((*states)[i].used) active_states.emplace_back(static_cast<int>(i + 1), (*states)[i]);
+  for (auto& row : pending) {
+    // An unreadable file is indexed as empty so the backfill does not retry it forever.
+    if (!storage::file_storage::read_prefix(row.file_path, max_bytes + 1, row.body)) row.body.clear();
+    row.body.resize(utf8_prefix_length(row.body, max_bytes));
   }
 
-  std::sort(active_states.begin(), active_states.end(), [](const auto& lhs, const auto& rhs) {
-    const auto left_stored = lhs.second.stored_at.value_or(0);
-    const auto right_stored = rhs.second.stored_at.value_or(0);
-    if (left_stored != right_stored) return left_stored < right_stored;
-    return lhs.first < rhs.first;
+  int indexed = 0;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    indexed = 0;
+    for (const auto& row : pending) {
+      // Skips rows rewritten since they were read; those carry their own body.
+      dao::detail::Stmt stmt(db, "UPDATE entries SET body_text=? WHERE id=? AND file_path=? AND body_text IS NULL;");
+      if (!stmt.ok()) return false;
+      sqlite3_bind_text(stmt, 1, row.body.data(), static_cast<int>(row.body.size()), SQLITE_TRANSIENT);
+      sqlite3_bind_int(stmt, 2, row.id);
+      sqlite3_bind_text(stmt, 3, row.file_path.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(stmt) != SQLITE_DONE) return false;
+      indexed += sqlite3_changes(db);
+    }
+    return true;
   });
+  return ok ? indexed : -1;
+}
 
-  std::vector<entry_state> resequenced(states->size());
-  for (size_t i = 0; i < active_states.size(); ++i) {
-    resequenced[i] = active_states[i].second;
-  }
+std::optional<std::pair<std::vector<karing::dao::KaringRecord>, int>> entry_store::resequence_entries() const {
+  size_t active_count = 0;
+  int next_id = 1;
+  const bool ok = run_write([&](dao::detail::Db& db) {
+    auto states = load_all_states(db);
+    if (!states.has_value()) return false;
+
+    std::vector<std::pair<int, entry_state>> active_states;
+    active_states.reserve(states->size());
+    for (size_t i = 0; i < states->size(); ++i) {
+      if ((*states)[i].used) active_states.emplace_back(static_cast<int>(i + 1), (*states)[i]);
+    }
 
-  for (size_t i = 0; i < resequenced.size(); ++i) {
-    if (!store_state(static_cast<int>(i + 1), resequenced[i])) {
-      dao::detail::exec_simple(db, "ROLLBACK;");
-      return std::nullopt;
+    std::sort(active_states.begin(), active_states.end(), [](const auto& lhs, const auto& rhs) {
+      const auto left_stored = lhs.second.stored_at.value_or(0);
+      const auto right_stored = rhs.second.stored_at.value_or(0);
+      if (left_stored != right_stored) return left_stored < right_stored;
+      return lhs.first < rhs.first;
+    });
+
+    std::vector<entry_state> resequenced(states->size());
+    for (size_t i = 0; i < active_states.size(); ++i) {
+      resequenced[i] = active_states[i].second;
     }
-  }
 
-  const int next_id = active_states.size() >= resequenced.size() ? 1 : static_cast<int>(active_states.size()) + 1;
+    for (size_t i = 0; i < resequenced.size(); ++i) {
+      if (!store_state(db, static_cast<int>(i + 1), resequenced[i])) return false;
+    }
 
-  sqlite3_stmt* next_stmt = nullptr;
-  if (sqlite3_prepare_v2(db,
-                         "UPDATE store_state SET next_id=?, updated_at=strftime('%s','now') WHERE singleton_id=1;",
-                         -1,
-                         &next_stmt,
-                         nullptr) != SQLITE_OK) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return std::nullopt;
-  }
-  sqlite3_bind_int(next_stmt, 1, next_id);
-  const bool next_ok = sqlite3_step(next_stmt) == SQLITE_DONE;
-  sqlite3_finalize(next_stmt);
-  if (!next_ok) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
-    return std::nullopt;
-  }
+    active_count = active_states.size();
+    next_id = active_states.size() >= resequenced.size() ? 1 : static_cast<int>(active_states.size()) + 1;
+    if (!dao::detail::write_next_id(db, next_id)) return false;
+    if (!dao::detail::exec_simple(db, "INSERT INTO entries_fts(entries_fts) VALUES('rebuild');")) return false;
 
-  if (!dao::detail::exec_simple(db, "INSERT INTO entries_fts(entries_fts) VALUES('rebuild');") ||
-      !dao::detail::exec_simple(db, "COMMIT;")) {
-    dao::detail::exec_simple(db, "ROLLBACK;");
+    // Inserts queued behind this job must see the compacted ring.
+    db::slot_cursor::for_path(db_path_).reset(next_id, static_cast<int>(resequenced.size()));
+    return true;
+  });
+  if (!ok) {
+    db::slot_cursor::for_path(db_path_).invalidate();
     return std::nullopt;
   }
 
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+  if (!db.ok()) return std::nullopt;
   std::vector<dao::KaringRecord> records;
-  records.reserve(active_states.size());
-  for (size_t i = 0; i < active_states.size(); ++i) {
+  records.reserve(active_count);
+  for (size_t i = 0; i < active_count; ++i) {
     dao::KaringRecord record{};
     std::string ignored_path;
     if (!dao::detail::load_entry(db, static_cast<int>(i + 1), record, &ignored_path)) {
@@ -503,6 +576,13 @@ std::optional<std::pair<std::vector<karing::dao::KaringRecord>, int>> entry_stor
     records.push_back(std::move(record));
   }
 
+  std::vector<int> ids;
+  std::vector<dao::KaringRecord> changed = records;
+  for (auto& record : changed) {
+    ids.push_back(record.id);
+    record.content.clear();
+  }
+  publish(change_kind::resequenced, std::move(ids), std::move(changed));
   return std::make_optional(std::make_pair(std::move(records), next_id));
 }
 
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "dao/karing_dao.h"
+#include "store/change_feed.h"
+#include "store/write_queue.h"
 
 namespace karing::store {
 
@@ -31,7 +34,18 @@ class entry_store {
   bool swap_entries(int id1, int id2) const;
   std::optional<std::pair<std::vector<karing::dao::KaringRecord>, int>> resequence_entries() const;
 
+  // Indexes the bodies of up to `batch` text-like uploads that have none yet.
+  // Returns the rows indexed, or -1 if the write failed.
+  int index_pending_bodies(int batch) const;
+
+  // Store-wide counter bumped after every committed write to `db_path`.
+  static uint64_t write_generation(const std::string& db_path);
+
  private:
+  bool run_write(const write_queue::job& work) const;
+  // Announces a committed change on the change_feed.
+  void publish(change_kind kind, std::vector<int> ids, std::vector<karing::dao::KaringRecord> records = {}) const;
+
   std::string db_path_;
   std::string upload_path_;
 };
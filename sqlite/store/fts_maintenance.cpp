@@ -0,0 +1,210 @@
+#include "store/fts_maintenance.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include "dao/karing_dao_internal.h"
+#include "store/entry_store.h"
+#include "store/write_queue.h"
+
+namespace karing::store {
+
+namespace {
+
+constexpr const char* kWordsTable = "entries_fts";
+constexpr const char* kTrigramTable = "entries_fts_tri";
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::unique_ptr<fts_maintenance>>& registry() {
+  static std::map<std::string, std::unique_ptr<fts_maintenance>> maintainers;
+  return maintainers;
+}
+
+bool has_index(dao::detail::Db& db, const char* table) {
+  dao::detail::Stmt stmt(db, "SELECT 1 FROM sqlite_master WHERE type='table' AND name=?;");
+  if (!stmt.ok()) return false;
+  sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+  return sqlite3_step(stmt) == SQLITE_ROW;
+}
+
+// FTS5 special commands are inserts into the table's hidden column of the same name.
+bool run_command(dao::detail::Db& db, const char* table, const std::string& command) {
+  const std::string sql = std::string("INSERT INTO ") + table + "(" + table + ") VALUES('" + command + "');";
+  return dao::detail::exec_simple(db, sql.c_str());
+}
+
+bool run_merge(dao::detail::Db& db, const char* table, int pages) {
+  const std::string sql = std::string("INSERT INTO ") + table + "(" + table + ", rank) VALUES('merge', " +
+                          std::to_string(pages) + ");";
+  return dao::detail::exec_simple(db, sql.c_str());
+}
+
+bool query_count(dao::detail::Db& db, const std::string& sql, long long& out) {
+  dao::detail::Stmt stmt(db, sql);
+  if (!stmt.ok() || sqlite3_step(stmt) != SQLITE_ROW) return false;
+  out = sqlite3_column_int64(stmt, 0);
+  return true;
+}
+
+// Every segment has at least one row in the %_idx table; %_data holds the pages.
+bool read_index_stats(dao::detail::Db& db, const char* table, fts_index_stats& out) {
+  out = {};
+  out.present = has_index(db, table);
+  if (!out.present) return true;
+  long long segments = 0;
+  if (!query_count(db, std::string("SELECT COUNT(DISTINCT segid) FROM ") + table + "_idx;", segments) ||
+      !query_count(db, std::string("SELECT COALESCE(SUM(length(block)), 0) FROM ") + table + "_data;", out.size_bytes)) {
+    return false;
+  }
+  out.segments = static_cast<int>(segments);
+  return true;
+}
+
+}  // namespace
+
+fts_maintenance::fts_maintenance(std::string db_path) : db_path_(std::move(db_path)) {}
+
+fts_maintenance::~fts_maintenance() {
+  stop();
+}
+
+fts_maintenance& fts_maintenance::for_path(const std::string& db_path) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& maintainers = registry();
+  auto it = maintainers.find(db_path);
+  if (it == maintainers.end()) it = maintainers.emplace(db_path, std::make_unique<fts_maintenance>(db_path)).first;
+  return *it->second;
+}
+
+bool fts_maintenance::start(const fts_maintenance_options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (worker_.joinable()) return true;
+  options_ = options;
+  options_.interval_ms = std::max(10, options_.interval_ms);
+  options_.idle_seconds = std::max(0, options_.idle_seconds);
+  options_.merge_pages = std::max(16, options_.merge_pages);
+  options_.steps_per_tick = std::max(1, options_.steps_per_tick);
+  stopping_ = false;
+  stats_.running = true;
+  worker_ = std::thread([this] { run(); });
+  return true;
+}
+
+void fts_maintenance::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    stats_.running = false;
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+int fts_maintenance::merge_step(int pages) {
+  bool merged = false;
+  const bool ok = write_queue::for_path(db_path_).run([&](dao::detail::Db& db) {
+    merged = false;
+    for (const char* table : {kWordsTable, kTrigramTable}) {
+      if (!has_index(db, table)) continue;
+      // A negative page count merges across levels, so steps continue until
+      // one segment is left; fewer than two changes means nothing was merged.
+      const int before = sqlite3_total_changes(db);
+      if (!run_merge(db, table, -std::max(1, pages))) return false;
+      if (sqlite3_total_changes(db) - before >= 2) merged = true;
+    }
+    return true;
+  });
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!ok) {
+    ++stats_.failures;
+    return -1;
+  }
+  if (!merged) return 0;
+  ++stats_.merge_steps;
+  stats_.last_merge_at = dao::detail::now_epoch();
+  return 1;
+}
+
+bool fts_maintenance::optimize() {
+  const bool ok = write_queue::for_path(db_path_).run([](dao::detail::Db& db) {
+    for (const char* table : {kWordsTable, kTrigramTable}) {
+      if (has_index(db, table) && !run_command(db, table, "optimize")) return false;
+    }
+    return true;
+  });
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+      ++stats_.failures;
+      return false;
+    }
+    ++stats_.optimize_runs;
+    stats_.last_optimize_at = dao::detail::now_epoch();
+  }
+  return refresh();
+}
+
+bool fts_maintenance::refresh() {
+  dao::detail::Db db(db_path_, dao::detail::Db::mode::read);
+  if (!db.ok()) return false;
+  fts_index_stats words;
+  fts_index_stats trigram;
+  if (!read_index_stats(db, kWordsTable, words) || !read_index_stats(db, kTrigramTable, trigram)) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.words = words;
+  stats_.trigram = trigram;
+  return true;
+}
+
+fts_maintenance_stats fts_maintenance::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void fts_maintenance::run() {
+  using clock = std::chrono::steady_clock;
+  uint64_t seen_generation = entry_store::write_generation(db_path_);
+  uint64_t refreshed_generation = seen_generation;
+  auto last_write = clock::now();
+  // The index is rebuilt at startup, so the first pass usually finds nothing to merge.
+  bool pending = true;
+  refresh();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms), [&] { return stopping_; });
+    if (stopping_) break;
+
+    const auto generation = entry_store::write_generation(db_path_);
+    const auto now = clock::now();
+    if (generation != seen_generation) {
+      seen_generation = generation;
+      last_write = now;
+      pending = true;
+    }
+    const bool idle = options_.idle_seconds > 0 && now - last_write >= std::chrono::seconds(options_.idle_seconds);
+    if (!(pending && idle) && generation == refreshed_generation) continue;
+    lock.unlock();
+
+    if (pending && idle) {
+      for (int step = 0; step < options_.steps_per_tick; ++step) {
+        const int merged = merge_step(options_.merge_pages);
+        if (merged == 0) pending = false;
+        if (merged <= 0) break;
+      }
+    }
+    if (refresh()) refreshed_generation = generation;
+
+    lock.lock();
+  }
+}
+
+}  // namespace karing::store
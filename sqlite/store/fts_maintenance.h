@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace karing::store {
+
+struct fts_maintenance_options {
+  int interval_ms{1000};
+  // Seconds without entry writes before merge steps start; 0 disables them.
+  int idle_seconds{10};
+  // Pages each merge step may write, and steps per idle tick.
+  int merge_pages{256};
+  int steps_per_tick{4};
+};
+
+struct fts_index_stats {
+  bool present{false};
+  int segments{0};
+  long long size_bytes{0};
+};
+
+struct fts_maintenance_stats {
+  bool running{false};
+  long long merge_steps{0};
+  long long optimize_runs{0};
+  long long failures{0};
+  int64_t last_merge_at{0};
+  int64_t last_optimize_at{0};
+  // entries_fts, and entries_fts_tri when the trigram index is kept.
+  fts_index_stats words;
+  fts_index_stats trigram;
+};
+
+// Keeps the FTS5 indexes of one database from fragmenting between rebuilds:
+// while entry writes are idle it runs incremental 'merge' steps through the
+// write queue until each index is back to one segment. optimize() does the
+// same in one go on the caller's thread.
+class fts_maintenance {
+ public:
+  explicit fts_maintenance(std::string db_path);
+  ~fts_maintenance();
+
+  fts_maintenance(const fts_maintenance&) = delete;
+  fts_maintenance& operator=(const fts_maintenance&) = delete;
+
+  static fts_maintenance& for_path(const std::string& db_path);
+
+  bool start(const fts_maintenance_options& options);
+  void stop();
+
+  // One merge step writing up to `pages` pages per index. Returns 1 if it
+  // merged segments, 0 if every index is down to one segment, -1 on error.
+  int merge_step(int pages);
+  // Merges every index into a single segment; blocks queued writes meanwhile.
+  bool optimize();
+  // Re-reads segment counts and index sizes for stats().
+  bool refresh();
+
+  fts_maintenance_stats stats() const;
+
+ private:
+  void run();
+
+  std::string db_path_;
+  fts_maintenance_options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread worker_;
+  bool stopping_{false};
+  fts_maintenance_stats stats_;
+};
+
+}  // namespace karing::store
@@ -0,0 +1,200 @@
+#include "store/write_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "dao/karing_dao_internal.h"
+#include "db/connection_pool.h"
+
+namespace karing::store {
+
+namespace {
+
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+write_queue_options& configured_options() {
+  static write_queue_options options;
+  return options;
+}
+
+std::map<std::string, std::unique_ptr<write_queue>>& registry() {
+  static std::map<std::string, std::unique_ptr<write_queue>> queues;
+  return queues;
+}
+
+// Undo hooks of the job running on this writer thread, if any.
+thread_local std::vector<std::function<void()>>* current_undos = nullptr;
+
+void run_undos(std::vector<std::function<void()>>& undos) {
+  for (auto it = undos.rbegin(); it != undos.rend(); ++it) (*it)();
+  undos.clear();
+}
+
+}  // namespace
+
+void write_queue::on_rollback(std::function<void()> undo) {
+  if (current_undos) current_undos->push_back(std::move(undo));
+}
+
+write_queue::write_queue(std::string db_path)
+    : db_path_(std::move(db_path)), options_(configured_options()) {
+  options_.batch_window_ms = std::max(0, options_.batch_window_ms);
+  options_.max_batch = std::max(1, options_.max_batch);
+  worker_ = std::thread([this] { worker_loop(); });
+}
+
+write_queue::~write_queue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+void write_queue::configure(const write_queue_options& options) {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  configured_options() = options;
+}
+
+write_queue& write_queue::for_path(const std::string& db_path) {
+  // Create the pool registry first so it is destroyed after the queues that use it.
+  db::connection_pool::for_path(db_path);
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto& queues = registry();
+  auto it = queues.find(db_path);
+  if (it == queues.end()) it = queues.emplace(db_path, std::make_unique<write_queue>(db_path)).first;
+  return *it->second;
+}
+
+std::future<bool> write_queue::submit(job work, completion done) {
+  pending_job item{std::move(work), std::move(done), {}};
+  auto future = item.result.get_future();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (std::this_thread::get_id() == worker_.get_id()) {
+    // A job that writes again joins its own transaction instead of deadlocking.
+    dao::detail::Db* db = current_db_;
+    lock.unlock();
+    const bool ok = db && item.work(*db);
+    if (item.done) item.done(ok);
+    item.result.set_value(ok);
+    return future;
+  }
+  queue_.push_back(std::move(item));
+  stats_.pending = static_cast<int>(queue_.size());
+  lock.unlock();
+  wake_.notify_all();
+  return future;
+}
+
+bool write_queue::run(job work) {
+  return submit(std::move(work)).get();
+}
+
+write_queue_stats write_queue::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void write_queue::worker_loop() {
+  const auto max_batch = static_cast<size_t>(options_.max_batch);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) return;
+
+    if (options_.batch_window_ms > 0 && !stopping_ && queue_.size() < max_batch) {
+      wake_.wait_for(lock, std::chrono::milliseconds(options_.batch_window_ms), [&] {
+        return stopping_ || queue_.size() >= max_batch;
+      });
+    }
+
+    std::deque<pending_job> batch;
+    while (!queue_.empty() && batch.size() < max_batch) {
+      batch.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+    }
+    stats_.pending = static_cast<int>(queue_.size());
+    lock.unlock();
+    run_batch(batch);
+    lock.lock();
+  }
+}
+
+void write_queue::run_batch(std::deque<pending_job>& batch) {
+  std::vector<bool> outcomes(batch.size(), false);
+  // Undos of the jobs released into the transaction, for a failed COMMIT.
+  std::vector<std::function<void()>> batch_undos;
+  bool committed = false;
+  {
+    dao::detail::Db db(db_path_);
+    if (db.ok() && dao::detail::exec_simple(db, "BEGIN IMMEDIATE;")) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_db_ = &db;
+      }
+      for (size_t i = 0; i < batch.size(); ++i) {
+        if (!dao::detail::exec_simple(db, "SAVEPOINT write_job;")) continue;
+        bool ok = false;
+        std::vector<std::function<void()>> undos;
+        current_undos = &undos;
+        try {
+          ok = batch[i].work(db);
+        } catch (...) {
+          ok = false;
+        }
+        current_undos = nullptr;
+        if (ok) ok = dao::detail::exec_simple(db, "RELEASE write_job;");
+        if (!ok) {
+          dao::detail::exec_simple(db, "ROLLBACK TO write_job;");
+          dao::detail::exec_simple(db, "RELEASE write_job;");
+          run_undos(undos);
+        } else {
+          batch_undos.insert(batch_undos.end(), std::make_move_iterator(undos.begin()),
+                             std::make_move_iterator(undos.end()));
+        }
+        outcomes[i] = ok;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_db_ = nullptr;
+      }
+      committed = dao::detail::exec_simple(db, "COMMIT;");
+      if (!committed) {
+        dao::detail::exec_simple(db, "ROLLBACK;");
+        run_undos(batch_undos);
+      }
+    }
+  }
+
+  int failed = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (!committed || !outcomes[i]) ++failed;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int size = static_cast<int>(batch.size());
+    stats_.jobs += size;
+    ++stats_.batches;
+    stats_.failed_jobs += failed;
+    if (!committed) ++stats_.failed_commits;
+    stats_.last_batch = size;
+    stats_.max_batch = std::max(stats_.max_batch, size);
+  }
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    const bool ok = committed && outcomes[i];
+    if (batch[i].done) batch[i].done(ok);
+    batch[i].result.set_value(ok);
+  }
+}
+
+}  // namespace karing::store
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace karing::dao::detail {
+struct Db;
+}
+
+namespace karing::store {
+
+struct write_queue_options {
+  // How long the writer lingers for more jobs after the first one arrives.
+  int batch_window_ms{1};
+  int max_batch{64};
+};
+
+struct write_queue_stats {
+  int pending{0};
+  long long jobs{0};
+  long long batches{0};
+  long long failed_jobs{0};
+  long long failed_commits{0};
+  int last_batch{0};
+  int max_batch{0};
+};
+
+// Single writer thread that owns the pooled write connection for one database.
+// Queued jobs are grouped into one BEGIN IMMEDIATE/COMMIT, each inside its own
+// savepoint so a failing job does not roll back its neighbours.
+class write_queue {
+ public:
+  // Runs on the writer thread inside the open transaction; return false to undo it.
+  using job = std::function<bool(dao::detail::Db& db)>;
+  // Called on the writer thread once the job's outcome is durable (or not).
+  using completion = std::function<void(bool committed)>;
+
+  explicit write_queue(std::string db_path);
+  ~write_queue();
+
+  write_queue(const write_queue&) = delete;
+  write_queue& operator=(const write_queue&) = delete;
+
+  // Applies to queues created after the call; set once at startup.
+  static void configure(const write_queue_options& options);
+  static write_queue& for_path(const std::string& db_path);
+
+  std::future<bool> submit(job work, completion done = {});
+  // From inside a job: `undo` runs on the writer thread if the job's writes
+  // are rolled back, by its own savepoint or by a failed COMMIT. Undos run
+  // newest first, so in-memory state can be put back step by step.
+  static void on_rollback(std::function<void()> undo);
+  // Submits and blocks until the job's batch has committed or rolled back.
+  bool run(job work);
+
+  write_queue_stats stats() const;
+
+ private:
+  struct pending_job {
+    job work;
+    completion done;
+    std::promise<bool> result;
+  };
+
+  void worker_loop();
+  void run_batch(std::deque<pending_job>& batch);
+
+  std::string db_path_;
+  write_queue_options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<pending_job> queue_;
+  std::thread worker_;
+  bool stopping_{false};
+  dao::detail::Db* current_db_{nullptr};
+  write_queue_stats stats_;
+};
+
+}  // namespace karing::store
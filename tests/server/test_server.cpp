@@ -1,8 +1,12 @@
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -10,13 +14,29 @@
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
 #include <json/json.h>
+#include <sqlite3.h>
 
+#include "controllers/events_controller.h"
+#include "controllers/fts_controller.h"
 #include "controllers/health_controller.h"
 #include "controllers/karing_root_controller.h"
 #include "controllers/karing_search_controller.h"
 #include "controllers/karing_search_live_controller.h"
 #include "dao/karing_dao.h"
 #include "db/db_init.h"
+#include "http/byte_range.h"
+#include "http/conditional.h"
+#include "http/event_stream.h"
+#include "http/record_json.h"
+#include "services/live_search_cache.h"
+#include "services/live_search_session.h"
+#include "services/search_service.h"
+#include "storage/file_storage.h"
+#include "store/change_feed.h"
+#include "storage/gzip.h"
+#include "utils/compression.h"
+#include "utils/executor.h"
+#include "utils/json_response.h"
 #include "utils/upload_mime.h"
 #include "utils/limits.h"
 #include "utils/options.h"
@@ -64,8 +84,12 @@ void set_current_options(const temp_env& env) {
 }
 
 drogon::HttpResponsePtr invoke(const std::function<void(std::function<void(const drogon::HttpResponsePtr&)>&&)>& fn) {
-  drogon::HttpResponsePtr response;
-  fn([&](const drogon::HttpResponsePtr& resp) { response = resp; });
+  // Controllers answer from an executor thread.
+  auto done = std::make_shared<std::promise<drogon::HttpResponsePtr>>();
+  auto future = done->get_future();
+  fn([done](const drogon::HttpResponsePtr& resp) { done->set_value(resp); });
+  expect(future.wait_for(std::chrono::seconds(30)) == std::future_status::ready, "controller did not answer in time");
+  const auto response = future.get();
   expect(response != nullptr, "controller did not produce a response");
   return response;
 }
@@ -115,6 +139,80 @@ void test_options_parse_modes() {
     auto parsed = karing::options::parse(3, argv);
     expect(parsed.action_kind == karing::options::action::error, "conflicting db modes should be rejected");
   }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--journal-mode";
+    char arg2[] = "delete";
+    char arg3[] = "--wal-autocheckpoint";
+    char arg4[] = "200";
+    char arg5[] = "--sqlite-mmap-mb";
+    char arg6[] = "32";
+    char arg7[] = "--sqlite-cache-mb";
+    char arg8[] = "8";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8};
+    auto parsed = karing::options::parse(9, argv);
+    expect(parsed.journal_mode == "delete", "--journal-mode should be parsed");
+    expect(parsed.wal_autocheckpoint == 200, "--wal-autocheckpoint should be parsed");
+    expect(parsed.sqlite_mmap_mb == 32, "--sqlite-mmap-mb should be parsed");
+    expect(parsed.sqlite_cache_mb == 8, "--sqlite-cache-mb should be parsed");
+  }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--journal-mode";
+    char arg2[] = "memory";
+    char* argv[] = {arg0, arg1, arg2};
+    auto parsed = karing::options::parse(3, argv);
+    expect(parsed.action_kind == karing::options::action::error, "unknown journal mode should be rejected");
+  }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--fts-tokenizer";
+    char arg2[] = "trigram";
+    char* argv[] = {arg0, arg1, arg2};
+    auto parsed = karing::options::parse(3, argv);
+    expect(parsed.fts_tokenizer == "trigram", "--fts-tokenizer should be parsed");
+    arg2[0] = 'x';
+    parsed = karing::options::parse(3, argv);
+    expect(parsed.action_kind == karing::options::action::error, "unknown tokenizer should be rejected");
+  }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--fts-prefix";
+    char arg2[] = "2,4";
+    char* argv[] = {arg0, arg1, arg2};
+    expect(karing::options::parse(3, argv).fts_prefix == "2 4", "--fts-prefix should be normalized");
+    char off[] = "0";
+    argv[2] = off;
+    expect(karing::options::parse(3, argv).fts_prefix.empty(), "--fts-prefix 0 should disable the prefix index");
+    char too_long[] = "1000";
+    argv[2] = too_long;
+    expect(karing::options::parse(3, argv).action_kind == karing::options::action::error, "out of range prefix should be rejected");
+  }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--fts-automerge";
+    char arg2[] = "0";
+    char arg3[] = "--fts-merge-idle";
+    char arg4[] = "30";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    auto parsed = karing::options::parse(5, argv);
+    expect(parsed.fts_automerge == 0 && parsed.fts_merge_idle_seconds == 30, "FTS merge options should be parsed");
+  }
+
+  {
+    char arg0[] = "karing";
+    char arg1[] = "--compress-min-bytes";
+    char arg2[] = "0";
+    char arg3[] = "--store-gzip";
+    char* argv[] = {arg0, arg1, arg2, arg3};
+    auto parsed = karing::options::parse(4, argv);
+    expect(parsed.compress_min_bytes == 0 && parsed.store_gzip, "compression options should be parsed");
+  }
 }
 
 void test_root_json_crud_and_delete() {
@@ -159,6 +257,13 @@ void test_root_json_crud_and_delete() {
   auto get_by_id_resp = invoke([&](auto&& cb) { controller.get_karing(get_by_id, std::move(cb)); });
   expect(std::string(get_by_id_resp->getBody()) == "hello patch", "GET /?id=1 should reflect patch");
 
+  get_by_id->setParameter("json", "true");
+  get_by_id->setParameter("fields", "id,filename,content_length");
+  auto projected = response_json(invoke([&](auto&& cb) { controller.get_karing(get_by_id, std::move(cb)); }));
+  expect(projected["data"][0]["content_length"].asInt() == 11 && !projected["data"][0].isMember("content") &&
+             !projected["data"][0].isMember("created_at"),
+         "GET /?json=true&fields= should return only the requested keys");
+
   auto delete_req = drogon::HttpRequest::newHttpRequest();
   delete_req->setMethod(drogon::Delete);
   auto delete_resp = invoke([&](auto&& cb) { controller.delete_karing(delete_req, std::move(cb)); });
@@ -277,6 +382,93 @@ void test_search_and_live_search() {
   expect(live_json["data"].size() >= 2, "/search/live should return prefix matches");
   expect(live_json["data"][0].isMember("preview"), "/search/live text record should include preview");
 
+  auto file_search_req = drogon::HttpRequest::newHttpRequest();
+  file_search_req->setMethod(drogon::Get);
+  file_search_req->setParameter("q", "audio");
+  file_search_req->setParameter("type", "file");
+  file_search_req->setParameter("mime", "audio/*");
+  auto file_search_json = response_json(invoke([&](auto&& cb) { search_controller.search(file_search_req, std::move(cb)); }));
+  expect(file_search_json["data"].size() == 1, "/search should apply type and mime filters");
+  expect(file_search_json["data"][0]["mime"].asString() == "audio/mpeg", "/search mime filter should match the file");
+
+  auto first_page_req = drogon::HttpRequest::newHttpRequest();
+  first_page_req->setMethod(drogon::Get);
+  first_page_req->setParameter("limit", "2");
+  auto first_page_json = response_json(invoke([&](auto&& cb) { search_controller.search(first_page_req, std::move(cb)); }));
+  expect(first_page_json["data"].size() == 2 && first_page_json["data"][1]["id"].asInt() == 2, "first page should hold ids 3 and 2");
+  expect(first_page_json["meta"].isMember("next_cursor"), "full page should carry next_cursor");
+
+  auto next_page_req = drogon::HttpRequest::newHttpRequest();
+  next_page_req->setMethod(drogon::Get);
+  next_page_req->setParameter("limit", "2");
+  next_page_req->setParameter("after", first_page_json["meta"]["next_cursor"].asString());
+  auto next_page_json = response_json(invoke([&](auto&& cb) { search_controller.search(next_page_req, std::move(cb)); }));
+  expect(next_page_json["data"].size() == 1 && next_page_json["data"][0]["id"].asInt() == 1, "after= should resume past the cursor");
+  expect(!next_page_json["meta"].isMember("next_cursor"), "short page should not carry next_cursor");
+
+  next_page_req->setParameter("sort", "stored_at");
+  auto mismatched_resp = invoke([&](auto&& cb) { search_controller.search(next_page_req, std::move(cb)); });
+  expect(mismatched_resp->getStatusCode() == drogon::k400BadRequest, "cursor from another sort should be rejected");
+
+  auto rank_req = drogon::HttpRequest::newHttpRequest();
+  rank_req->setMethod(drogon::Get);
+  rank_req->setParameter("q", "alpha");
+  rank_req->setParameter("sort", "rank");
+  auto rank_json = response_json(invoke([&](auto&& cb) { search_controller.search(rank_req, std::move(cb)); }));
+  expect(rank_json["data"].size() == 1 && rank_json["data"][0].isMember("score"), "sort=rank should return a score");
+  rank_req->setParameter("q", "");
+  auto rank_without_q = invoke([&](auto&& cb) { search_controller.search(rank_req, std::move(cb)); });
+  expect(rank_without_q->getStatusCode() == drogon::k400BadRequest, "sort=rank should require q");
+
+  auto snippet_req = drogon::HttpRequest::newHttpRequest();
+  snippet_req->setMethod(drogon::Get);
+  snippet_req->setParameter("q", "alpha");
+  snippet_req->setParameter("snippet", "true");
+  auto snippet_json = response_json(invoke([&](auto&& cb) { search_controller.search(snippet_req, std::move(cb)); }));
+  expect(snippet_json["data"][0]["snippet"].asString() == "alpha note", "snippet=true should return the fragment");
+  expect(!snippet_json["data"][0].isMember("content"), "snippet=true should drop content");
+  expect(snippet_json["data"][0]["highlights"][0][1].asInt() == 5, "snippet=true should report highlight ranges");
+
+  auto fields_req = drogon::HttpRequest::newHttpRequest();
+  fields_req->setMethod(drogon::Get);
+  fields_req->setParameter("type", "text");
+  fields_req->setParameter("fields", "id,content_length,created_at");
+  auto fields_json = response_json(invoke([&](auto&& cb) { search_controller.search(fields_req, std::move(cb)); }));
+  expect(fields_json["data"].size() == 2 && fields_json["data"][0].size() == 3, "fields= should limit the keys");
+  expect(fields_json["data"][0]["content_length"].asInt() == 11, "content_length should report the stored size");
+  fields_req->setParameter("fields", "id,body");
+  auto bad_fields = invoke([&](auto&& cb) { search_controller.search(fields_req, std::move(cb)); });
+  expect(bad_fields->getStatusCode() == drogon::k400BadRequest, "unknown fields should be rejected");
+
+  live_req->setParameter("fields", "id,filename");
+  auto live_fields_json = response_json(invoke([&](auto&& cb) { live_controller.search_live(live_req, std::move(cb)); }));
+  expect(live_fields_json["data"].size() >= 2 && !live_fields_json["data"][0].isMember("preview"),
+         "/search/live fields= should drop the preview");
+
+  auto substring_req = drogon::HttpRequest::newHttpRequest();
+  substring_req->setMethod(drogon::Get);
+  substring_req->setParameter("q", "lph");
+  substring_req->setParameter("mode", "substring");
+  auto no_trigram_resp = invoke([&](auto&& cb) { live_controller.search_live(substring_req, std::move(cb)); });
+  expect(no_trigram_resp->getStatusCode() == drogon::k400BadRequest, "mode=substring should need the trigram index");
+
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 5, false, karing::db::journal_mode::rollback,
+                                             karing::db::fts_options{karing::db::fts_tokenizer::trigram}).ok,
+         "trigram init should succeed");
+  karing::options::current().fts_tokenizer = "trigram";
+  auto substring_json = response_json(invoke([&](auto&& cb) { live_controller.search_live(substring_req, std::move(cb)); }));
+  auto short_req = drogon::HttpRequest::newHttpRequest();
+  short_req->setMethod(drogon::Get);
+  short_req->setParameter("q", "al");
+  auto short_live = invoke([&](auto&& cb) { live_controller.search_live(short_req, std::move(cb)); });
+  short_req->setParameter("q", "a");
+  auto short_search = invoke([&](auto&& cb) { search_controller.search(short_req, std::move(cb)); });
+  karing::options::current().fts_tokenizer = "unicode61";
+  expect(substring_json["data"].size() == 1 && substring_json["data"][0]["id"].asInt() == 1, "mode=substring should match inside words");
+  expect(short_live->getStatusCode() == drogon::k200OK && response_json(short_live)["data"].size() == 2,
+         "short live queries should still match word prefixes with the trigram index");
+  expect(short_search->getStatusCode() == drogon::k200OK, "a one-character /search should not be rejected");
+
   auto bad_search_req = drogon::HttpRequest::newHttpRequest();
   bad_search_req->setMethod(drogon::Get);
   bad_search_req->setParameter("sort", "bad");
@@ -287,6 +479,409 @@ void test_search_and_live_search() {
   bad_live_req->setMethod(drogon::Get);
   auto bad_live_resp = invoke([&](auto&& cb) { live_controller.search_live(bad_live_req, std::move(cb)); });
   expect(bad_live_resp->getStatusCode() == drogon::k400BadRequest, "/search/live should require q");
+
+#if defined(KARING_USE_COROUTINES)
+  auto task_resp = drogon::sync_wait(search_controller.search_task(search_req));
+  expect(task_resp->getStatusCode() == drogon::k200OK, "coroutine /search should succeed");
+  expect(response_json(task_resp)["data"].size() == search_json["data"].size(), "coroutine /search should match");
+  auto task_live_resp = drogon::sync_wait(live_controller.search_live_task(bad_live_req));
+  expect(task_live_resp->getStatusCode() == drogon::k400BadRequest, "coroutine /search/live should require q");
+#endif
+}
+
+void test_live_search_cache_refines_prefixes() {
+  const auto env = make_temp_env("live-cache");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 10, false).ok, "db init should succeed");
+  set_current_options(env);
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("docker compose notes") == 1, "insert docker");
+  expect(dao.insert_text("dockerfile tips") == 2, "insert dockerfile");
+  expect(dao.insert_text("doctor appointment") == 3, "insert doctor");
+
+  karing::services::search_service service(env.db_path.string(), env.upload_path.string(), 25);
+  auto& cache = karing::services::live_search_cache::for_path(env.db_path.string());
+  karing::services::search_request request;
+  request.limit = 10;
+
+  request.q = "do";
+  expect(service.live_search(request).records.size() == 3, "first keystroke should query SQLite");
+  request.q = "dock";
+  expect(service.live_search(request).records.size() == 2, "extended query should narrow the cached hits");
+  request.q = "DOCK   co";
+  const auto narrowed = service.live_search(request);
+  expect(narrowed.records.size() == 1 && narrowed.records[0].id == 1, "added terms should match word prefixes");
+  request.q = "dock";
+  expect(service.live_search(request).records.size() == 2, "repeated query should hit the cache");
+  auto stats = cache.stats();
+  expect(stats.misses == 1 && stats.refined == 2 && stats.hits == 1, "only the first query should reach SQLite");
+
+  expect(dao.insert_text("docking station") == 4, "insert docking");
+  expect(service.live_search(request).records.size() == 3, "a write should invalidate cached results");
+  stats = cache.stats();
+  expect(stats.invalidations == 1 && stats.misses == 2, "the write generation should drop the cache");
+
+  request.limit = 2;
+  request.q = "do";
+  expect(service.live_search(request).records.size() == 2, "truncated result should fill the limit");
+  request.q = "doc";
+  expect(service.live_search(request).records.size() == 2, "truncated hits should not be refined");
+  expect(cache.stats().misses == 4, "a prefix cut off by limit should fall back to SQLite");
+
+  request.limit = 10;
+  request.sort = "rank";
+  request.q = "dock";
+  service.live_search(request);
+  request.q = "docke";
+  expect(service.live_search(request).records.size() == 2, "sort=rank should still match");
+  expect(cache.stats().misses == 6, "relevance order should not be refined from a prefix");
+}
+
+void test_live_search_session_delivers_latest() {
+  const auto env = make_temp_env("live-session");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 10, false).ok, "db init should succeed");
+  set_current_options(env);
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("alpha note") == 1, "insert alpha");
+  expect(dao.insert_text("alpine note") == 2, "insert alpine");
+  expect(dao.insert_text("beta note") == 3, "insert beta");
+
+  std::mutex mutex;
+  std::condition_variable delivered_cv;
+  std::vector<std::pair<long long, size_t>> delivered;
+  auto session = std::make_shared<karing::services::live_search_session>(
+      karing::services::search_service(env.db_path.string(), env.upload_path.string(), 25),
+      [&](long long seq, const karing::services::search_result& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        delivered.emplace_back(seq, result.records.size());
+        delivered_cv.notify_all();
+      });
+
+  // Hold every read-lane thread so the three keystrokes arrive before any query runs.
+  std::promise<void> release;
+  const auto gate = release.get_future().share();
+  for (int i = 0; i < karing::limits::kMaxExecutorThreads; ++i) {
+    expect(karing::executor::submit(karing::executor::lane::read, [gate] { gate.wait(); }), "blocker should queue");
+  }
+  karing::services::search_request request;
+  request.limit = 10;
+  request.q = "n";
+  expect(session->submit(request, 1), "first query should queue");
+  request.q = "no";
+  expect(session->submit(request, 2), "second query should queue");
+  request.q = "alp";
+  expect(session->submit(request, 3), "third query should queue");
+  release.set_value();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  expect(delivered_cv.wait_for(lock, std::chrono::seconds(30), [&] { return !delivered.empty(); }), "a result should arrive");
+  expect(delivered.size() == 1 && delivered[0].first == 3 && delivered[0].second == 2, "only the newest query should answer");
+  lock.unlock();
+
+  session->close();
+  expect(session->submit(request, 4), "a closed session should ignore queries");
+}
+
+void test_change_event_frames() {
+  karing::store::change_event event;
+  event.id = 42;
+  event.kind = karing::store::change_kind::created;
+  event.ids = {3};
+  karing::dao::KaringRecord record{};
+  record.id = 3;
+  record.filename = "a.txt";
+  record.mime = "text/plain";
+  record.is_file = true;
+  event.records.push_back(record);
+
+  const auto frame = karing::http::format_change_event(event);
+  expect(frame.rfind("id: 42\nevent: created\ndata: ", 0) == 0, "frame should start with id and event");
+  expect(frame.size() > 2 && frame.compare(frame.size() - 2, 2, "\n\n") == 0, "frame should end with a blank line");
+  const auto data = frame.substr(frame.find("data: ") + 6);
+  expect(data.find('\n') == data.size() - 2, "data should fit on one line");
+
+  Json::Value json;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  expect(reader->parse(data.data(), data.data() + data.size() - 2, &json, &errors), "data should be JSON");
+  expect(json["ids"][0].asInt() == 3, "data should list the ids");
+  expect(json["records"][0]["id"].asInt() == 3 && json["records"][0]["filename"].asString() == "a.txt",
+         "data should carry record metadata");
+
+  event.kind = karing::store::change_kind::deleted;
+  event.records.clear();
+  const auto deleted = karing::http::format_change_event(event);
+  expect(deleted.find("event: deleted\n") != std::string::npos && deleted.find("records") == std::string::npos,
+         "deleted events should carry ids only");
+  expect(karing::http::format_reset_event().rfind("event: reset\n", 0) == 0, "reset should be its own event");
+}
+
+void test_events_release_disconnected_clients() {
+  const auto env = make_temp_env("events_keep_alive");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 4, false).ok, "db init should succeed");
+  set_current_options(env);
+  auto& feed = karing::store::change_feed::for_path(env.db_path.string());
+
+  karing::controllers::events_controller controller;
+  auto req = drogon::HttpRequest::newHttpRequest();
+  auto resp = invoke([&](auto&& cb) { controller.events(req, std::move(cb)); });
+  auto stream = std::make_unique<drogon::ResponseStream>();
+  auto* raw = stream.get();
+  resp->streamCallback_(std::move(stream));
+  expect(feed.stats().subscribers == 1, "an open stream should subscribe");
+
+  karing::controllers::events_controller::keep_alive();
+  expect(!raw->sent_.empty() && raw->sent_.back() == karing::http::format_keep_alive(),
+         "open streams should get a keep-alive comment");
+  expect(feed.stats().subscribers == 1, "a delivered keep-alive should keep the subscription");
+
+  // Nothing is published, so only the keep-alive can notice the disconnect.
+  raw->closed_ = true;
+  karing::controllers::events_controller::keep_alive();
+  expect(feed.stats().subscribers == 0, "a disconnected stream should release its subscription");
+}
+
+void test_streamed_records_match_json_trees() {
+  karing::dao::KaringRecord text{};
+  text.id = 5;
+  text.content = std::string("quote \" backslash \\ tab\t newline\n ctl") + '\x01' + " utf8 日本語";
+  text.size_bytes = static_cast<int64_t>(text.content.size());
+  text.created_at = 1711111111;
+  text.updated_at = 1711112222;
+  text.score = 2.5;
+  karing::dao::KaringRecord snippet{};
+  snippet.id = 6;
+  snippet.snippet = "...the \"budget\"...";
+  snippet.highlights = {{4, 8}};
+  snippet.created_at = 1711111800;
+  karing::dao::KaringRecord file{};
+  file.id = 7;
+  file.is_file = true;
+  file.filename = "a b.txt";
+  file.mime = "text/plain";
+  file.score = -0.125;
+  const std::vector<karing::dao::KaringRecord> records{text, snippet, file};
+
+  Json::Value meta;
+  meta["count"] = 3;
+  Json::Value extra;
+  extra["seq"] = 9;
+  auto all_fields = karing::http::live_record_fields();
+  all_fields.content = true;
+  all_fields.content_length = true;
+  for (const auto& fields : {karing::http::record_fields{}, karing::http::live_record_fields(), all_fields}) {
+    const auto body = karing::http::ok_records_body(records, fields, meta, extra);
+    Json::Value parsed;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    expect(reader->parse(body.data(), body.data() + body.size(), &parsed, &errors), "streamed body should be JSON");
+    Json::Value data(Json::arrayValue);
+    for (const auto& record : records) data.append(karing::http::record_to_json(record, fields));
+    auto expected = karing::http::ok_body(data, meta);
+    expected["seq"] = 9;
+    expect(parsed == expected, "streamed body should match the Json::Value envelope");
+  }
+  expect(karing::http::ok_records_body({}, {}).find("\"data\":[]") != std::string::npos,
+         "an empty page should still carry a data array");
+}
+
+void test_response_compression() {
+  using karing::http::content_coding;
+  expect(karing::http::negotiate("") == content_coding::identity, "no Accept-Encoding should stay identity");
+  expect(karing::http::negotiate("gzip, deflate") == content_coding::gzip, "gzip should be picked");
+  expect(karing::http::negotiate("GZIP;q=0.5, identity") == content_coding::gzip, "codings should be case-insensitive");
+  expect(karing::http::negotiate("gzip;q=0, *;q=0") == content_coding::identity, "q=0 should refuse a coding");
+  expect(karing::http::negotiate("br;q=0, *") == content_coding::gzip, "a wildcard should admit gzip");
+
+  const auto env = make_temp_env("compression");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 40, false).ok, "db init should succeed");
+  set_current_options(env);
+  karing::http::compression_options compression;
+  compression.min_bytes = 256;
+  karing::http::configure_compression(compression);
+  karing::storage::file_storage_options storage;
+  storage.gzip_text = true;
+  karing::storage::file_storage::configure(storage);
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  for (int i = 0; i < 30; ++i) dao.insert_text("repeated note body number " + std::to_string(i));
+  std::string file_body;
+  for (int i = 0; i < 100; ++i) file_body += "stored text line " + std::to_string(i) + "\n";
+  const int file_id = dao.insert_file("stored.txt", "text/plain", file_body);
+
+  karing::controllers::karing_search_controller search;
+  auto search_req = drogon::HttpRequest::newHttpRequest();
+  search_req->setMethod(drogon::Get);
+  search_req->addHeader("accept-encoding", "gzip");
+  auto search_resp = invoke([&](auto&& cb) { search.search(search_req, std::move(cb)); });
+  expect(search_resp->getHeader("content-encoding") == "gzip" &&
+             search_resp->getHeader("vary") == "Accept-Encoding",
+         "a large JSON page should be gzipped");
+  std::string inflated;
+  expect(karing::storage::gzip_decompress(search_resp->getBody(), inflated), "the page should inflate");
+  Json::Value page;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  expect(reader->parse(inflated.data(), inflated.data() + inflated.size(), &page, &errors) &&
+             page["data"].size() == 25,
+         "the inflated page should be the JSON result");
+
+  auto plain_req = drogon::HttpRequest::newHttpRequest();
+  plain_req->setMethod(drogon::Get);
+  auto plain_resp = invoke([&](auto&& cb) { search.search(plain_req, std::move(cb)); });
+  expect(plain_resp->getHeader("content-encoding").empty() && response_json(plain_resp)["data"].size() == 25,
+         "clients without Accept-Encoding should get identity");
+
+  karing::controllers::karing_root_controller root;
+  auto stored_req = drogon::HttpRequest::newHttpRequest();
+  stored_req->setMethod(drogon::Get);
+  stored_req->setParameter("id", std::to_string(file_id));
+  stored_req->addHeader("accept-encoding", "gzip");
+  auto stored_resp = invoke([&](auto&& cb) { root.get_karing(stored_req, std::move(cb)); });
+  expect(stored_resp->getHeader("content-encoding") == "gzip" && stored_resp->getBody().size() < file_body.size() &&
+             karing::storage::gzip_decompress(stored_resp->getBody(), inflated) && inflated == file_body,
+         "a gzip-stored upload should be sent as stored");
+
+  stored_req->addHeader("accept-encoding", "identity");
+  stored_resp = invoke([&](auto&& cb) { root.get_karing(stored_req, std::move(cb)); });
+  expect(stored_resp->getHeader("content-encoding").empty() && std::string(stored_resp->getBody()) == file_body,
+         "a gzip-stored upload should be inflated for other clients");
+  expect(stored_resp->getHeader("vary") == "Accept-Encoding", "the inflated body should still name Vary");
+  const auto identity_tag = stored_resp->getHeader("etag");
+  stored_req->addHeader("accept-encoding", "gzip");
+  stored_resp = invoke([&](auto&& cb) { root.get_karing(stored_req, std::move(cb)); });
+  const auto gzip_tag = stored_resp->getHeader("etag");
+  expect(gzip_tag == karing::http::coded_entity_tag(identity_tag, content_coding::gzip) &&
+             gzip_tag.find("-gzip\"") != std::string::npos,
+         "gzip bodies should carry their own entity tag");
+  stored_req->addHeader("accept-encoding", "identity");
+  stored_req->addHeader("if-none-match", gzip_tag);
+  stored_resp = invoke([&](auto&& cb) { root.get_karing(stored_req, std::move(cb)); });
+  expect(stored_resp->getStatusCode() == drogon::k304NotModified, "a coded tag should still validate the entry");
+  expect(stored_resp->getHeader("vary") == "Accept-Encoding", "a 304 should carry the Vary of its 200");
+
+  auto latest_req = drogon::HttpRequest::newHttpRequest();
+  latest_req->setMethod(drogon::Get);
+  latest_req->setParameter("id", "30");
+  latest_req->addHeader("accept-encoding", "gzip");
+  latest_req->setParameter("json", "true");
+  dao.update_text(30, std::string(2000, 'x'));
+  auto latest_resp = invoke([&](auto&& cb) { root.get_karing(latest_req, std::move(cb)); });
+  expect(latest_resp->getHeader("content-encoding") == "gzip" &&
+             latest_resp->getHeader("etag").find("-gzip\"") != std::string::npos,
+         "compressing a tagged body should switch to the gzip entity tag");
+
+  karing::storage::file_storage::configure({});
+  karing::http::configure_compression({});
+}
+
+void test_root_conditional_get() {
+  int64_t parsed = 0;
+  expect(karing::http::http_date(784111777) == "Sun, 06 Nov 1994 08:49:37 GMT", "http dates should be IMF-fixdate");
+  expect(karing::http::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", parsed) && parsed == 784111777,
+         "IMF-fixdate should parse back");
+  expect(!karing::http::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT", parsed), "RFC 850 dates should be rejected");
+
+  const auto env = make_temp_env("conditional");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 5, false).ok, "db init should succeed");
+  set_current_options(env);
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("first note") == 1, "insert text");
+  expect(dao.insert_file("digits.bin", "application/octet-stream", "0123456789") == 2, "insert file");
+
+  karing::controllers::karing_root_controller controller;
+  const auto get = [&](const std::vector<std::pair<std::string, std::string>>& params,
+                       const std::vector<std::pair<std::string, std::string>>& headers) {
+    auto req = drogon::HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    for (const auto& [key, value] : params) req->setParameter(key, value);
+    for (const auto& [key, value] : headers) req->addHeader(key, value);
+    return invoke([&](auto&& cb) { controller.get_karing(req, std::move(cb)); });
+  };
+
+  auto latest = get({}, {});
+  const auto latest_tag = latest->getHeader("etag");
+  const auto latest_modified = latest->getHeader("last-modified");
+  expect(latest->getStatusCode() == drogon::k200OK && latest_tag.size() > 2 && latest_tag.front() == '"',
+         "GET / should carry a strong ETag");
+  expect(!latest_modified.empty(), "GET / should carry Last-Modified");
+
+  auto repeat = get({}, {{"if-none-match", latest_tag}});
+  expect(repeat->getStatusCode() == drogon::k304NotModified && repeat->getBody().empty(),
+         "a matching If-None-Match should answer 304 without a body");
+  expect(repeat->getHeader("etag") == latest_tag && repeat->getHeader("last-modified") == latest_modified,
+         "304 should repeat the validators");
+  expect(repeat->getHeader("vary") == "Accept-Encoding", "304 should repeat Vary while compression is on");
+  expect(get({}, {{"if-none-match", "\"stale\", W/" + latest_tag}})->getStatusCode() == drogon::k304NotModified,
+         "If-None-Match should compare weakly across a list");
+  expect(get({}, {{"if-none-match", "*"}})->getStatusCode() == drogon::k304NotModified,
+         "If-None-Match: * should match an existing entry");
+  expect(get({}, {{"if-none-match", "\"stale\""}})->getStatusCode() == drogon::k200OK,
+         "a stale tag should get the body");
+  expect(get({}, {{"if-modified-since", latest_modified}})->getStatusCode() == drogon::k304NotModified,
+         "an unchanged entry should answer If-Modified-Since with 304");
+  expect(get({}, {{"if-modified-since", "Thu, 01 Jan 1970 00:00:00 GMT"}})->getStatusCode() == drogon::k200OK,
+         "an older If-Modified-Since should get the body");
+  expect(get({}, {{"if-none-match", "\"stale\""}, {"if-modified-since", latest_modified}})->getStatusCode() ==
+             drogon::k200OK,
+         "If-None-Match should take precedence over If-Modified-Since");
+
+  auto text = get({{"id", "1"}}, {});
+  const auto text_tag = text->getHeader("etag");
+  expect(!text_tag.empty() && text_tag != latest_tag, "each entry should have its own tag");
+  auto text_json = get({{"id", "1"}, {"json", "true"}}, {});
+  const auto json_tag = text_json->getHeader("etag");
+  expect(!json_tag.empty() && json_tag != text_tag, "JSON bodies should be tagged apart from raw ones");
+  expect(get({{"id", "1"}, {"json", "true"}, {"fields", "filename"}}, {})->getHeader("etag") != json_tag,
+         "fields= should change the JSON tag");
+  expect(get({{"id", "1"}, {"json", "true"}}, {{"if-none-match", json_tag}})->getStatusCode() ==
+             drogon::k304NotModified,
+         "JSON polls should be answered with 304");
+  expect(get({{"id", "1"}}, {{"if-none-match", json_tag}})->getStatusCode() == drogon::k200OK,
+         "a JSON tag should not validate the raw body");
+
+  expect(dao.update_text(1, "first note, edited"), "update text");
+  auto edited = get({{"id", "1"}}, {{"if-none-match", text_tag}});
+  expect(edited->getStatusCode() == drogon::k200OK && std::string(edited->getBody()) == "first note, edited",
+         "an edited entry should send the new body");
+  expect(edited->getHeader("etag") != text_tag, "an edit should change the tag");
+
+  // Same-second, same-size rows differ only by revision. Pin the timestamps so
+  // the clock cannot tell the versions apart.
+  const auto pin_timestamps = [&] {
+    sqlite3* handle = nullptr;
+    expect(sqlite3_open_v2(env.db_path.string().c_str(), &handle, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK &&
+               sqlite3_exec(handle, "UPDATE entries SET stored_at=1700000000, updated_at=NULL WHERE id IN (3, 4);",
+                            nullptr, nullptr, nullptr) == SQLITE_OK,
+           "timestamps should be pinned");
+    sqlite3_close(handle);
+  };
+  expect(dao.insert_text("left") == 3 && dao.insert_text("right") == 4, "insert same-size texts");
+  pin_timestamps();
+  const auto left_tag = get({{"id", "3"}}, {})->getHeader("etag");
+  expect(dao.update_text(3, "LEFT"), "same-size edit");
+  pin_timestamps();
+  auto same_second = get({{"id", "3"}}, {{"if-none-match", left_tag}});
+  expect(same_second->getStatusCode() == drogon::k200OK && std::string(same_second->getBody()) == "LEFT",
+         "a same-size edit within one second should send the new body");
+  const auto edited_tag = same_second->getHeader("etag");
+  expect(dao.swap_entries(3, 4), "swap same-size entries");
+  pin_timestamps();
+  auto swapped = get({{"id", "3"}}, {{"if-none-match", edited_tag}});
+  expect(swapped->getStatusCode() == drogon::k200OK && std::string(swapped->getBody()) == "right",
+         "a swap should send the entry that moved in");
+
+  // The 304 comes from the row alone: the upload is not even opened.
+  karing::dao::KaringRecord located;
+  std::string path;
+  expect(dao.get_file_location(2, located, path), "file location should be readable");
+  fs::remove(path);
+  expect(get({{"id", "2"}}, {{"if-none-match", latest_tag}})->getStatusCode() == drogon::k304NotModified,
+         "conditional GETs should not read the stored file");
 }
 
 void test_health_response() {
@@ -309,6 +904,38 @@ void test_health_response() {
   expect(json["listener"]["address"].asString() == "127.0.0.1", "health should report listener address");
   expect(json["listener"]["port"].asInt() == 8080, "health should report listener port");
   expect(json["db"]["max_items"].asInt() == 3, "health should expose db max_items");
+  expect(json["pool"]["size"].asInt() >= 1, "health should expose pool size");
+  expect(json["pool"]["in_use"].asInt() == 0, "health should report no leaked pool leases");
+  expect(json["wal"]["journal_mode"].asString() == "wal", "health should report journal mode");
+  expect(json["wal"].isMember("checkpoint_lag_frames"), "health should report checkpoint lag");
+  expect(json["writes"]["pending"].asInt() == 0, "health should report the write queue");
+  expect(json["live_cache"]["capacity"].asInt() > 0, "health should report the live-search cache");
+  expect(json["events"]["subscribers"].asInt() == 0, "health should report the change feed");
+  expect(json["body_index"]["max_bytes"].asInt() > 0, "health should report body indexing");
+  expect(json["fts"]["automerge"].asInt() == karing::limits::kDefaultFtsAutomerge && json["fts"].isMember("indexes"),
+         "health should report FTS maintenance");
+  expect(json["executor"]["read"]["active"].asInt() == 1, "health should run on the read lane");
+  expect(json["executor"]["file"]["submitted"].asInt64() > 0, "earlier file requests should use the file lane");
+  expect(json["executor"].isMember("write") && json["executor"]["write"].isMember("avg_wait_us"),
+         "health should report executor wait times");
+}
+
+void test_fts_optimize() {
+  const auto env = make_temp_env("fts_optimize");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 4, false).ok, "db init should succeed");
+  set_current_options(env);
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("first note") > 0 && dao.insert_text("second note") > 0, "inserts should succeed");
+
+  karing::controllers::fts_controller controller;
+  auto req = drogon::HttpRequest::newHttpRequest();
+  req->setMethod(drogon::Post);
+  auto resp = invoke([&](auto&& cb) { controller.optimize(req, std::move(cb)); });
+  expect(resp->getStatusCode() == drogon::k200OK, "/fts/optimize should succeed");
+  auto json = response_json(resp);
+  expect(json["data"]["optimize_runs"].asInt() == 1, "optimize should be counted");
+  expect(json["data"]["indexes"]["entries_fts"]["segments"].asInt() == 1, "optimize should leave one segment");
+  expect(!json["data"]["indexes"].isMember("entries_fts_tri"), "only kept indexes should be reported");
 }
 
 void test_upload_mime_support() {
@@ -387,6 +1014,101 @@ void test_root_file_and_text_file_responses() {
          "unicode file download should include filename*");
   expect(unicode_disposition.find("UTF-8''") != std::string::npos,
          "unicode file download should use RFC 5987 encoding");
+  expect(std::string(unicode_download_resp->getBody()) == "jp-mp3", "file download should send the stored bytes");
+
+  karing::dao::KaringRecord located;
+  std::string path;
+  expect(dao.get_file_location(4, located, path), "file location should be readable");
+  fs::remove(path);
+  auto missing_resp = invoke([&](auto&& cb) { controller.get_karing(unicode_download_req, std::move(cb)); });
+  expect(missing_resp->getStatusCode() == drogon::k404NotFound, "a missing upload file should answer 404");
+}
+
+void test_root_file_ranges() {
+  using karing::http::parse_range;
+  using karing::http::range_kind;
+  const auto suffix = parse_range("bytes=-4", 10);
+  expect(suffix.kind == range_kind::partial && suffix.range.offset == 6 && suffix.range.length == 4,
+         "suffix ranges should cover the tail");
+  const auto clamped = parse_range("bytes=8-100", 10);
+  expect(clamped.kind == range_kind::partial && clamped.range.offset == 8 && clamped.range.length == 2,
+         "range ends should be clamped to the body");
+  expect(parse_range("bytes=-20", 10).range.length == 10, "long suffixes should cover the whole body");
+  expect(parse_range("bytes=5-2", 10).kind == range_kind::full, "reversed ranges should be ignored");
+  expect(parse_range("items=0-1", 10).kind == range_kind::full, "other units should be ignored");
+  expect(parse_range("bytes=0-", 0).kind == range_kind::unsatisfiable, "empty bodies should have no ranges");
+  expect(parse_range("bytes=99999999999999999999999-", 10).kind == range_kind::unsatisfiable,
+         "huge positions should not wrap around");
+
+  const auto env = make_temp_env("ranges");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 5, false).ok, "db init should succeed");
+  set_current_options(env);
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_file("digits.bin", "application/octet-stream", "0123456789") == 1, "insert file");
+  expect(dao.insert_file("note.txt", "text/plain", "text file body") == 2, "insert text file");
+
+  karing::controllers::karing_root_controller controller;
+  const auto get = [&](const std::string& id, const std::string& range, const std::string& if_range = "") {
+    auto req = drogon::HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Get);
+    req->setParameter("id", id);
+    req->setParameter("as", "download");
+    if (!range.empty()) req->addHeader("range", range);
+    if (!if_range.empty()) req->addHeader("if-range", if_range);
+    return invoke([&](auto&& cb) { controller.get_karing(req, std::move(cb)); });
+  };
+
+  auto whole = get("1", "");
+  expect(whole->getStatusCode() == drogon::k200OK && std::string(whole->getBody()) == "0123456789",
+         "a plain GET should send the whole file");
+  expect(whole->getHeader("accept-ranges") == "bytes", "file responses should advertise byte ranges");
+  const auto last_modified = whole->getHeader("last-modified");
+  expect(last_modified.size() == 29 && last_modified.find(" GMT") != std::string::npos,
+         "file responses should carry Last-Modified");
+
+  auto middle = get("1", "bytes=2-5");
+  expect(middle->getStatusCode() == drogon::k206PartialContent, "a satisfiable range should answer 206");
+  expect(std::string(middle->getBody()) == "2345", "206 should send only the requested bytes");
+  expect(middle->getHeader("content-range") == "bytes 2-5/10", "206 should carry Content-Range");
+  expect(middle->getHeader("content-disposition").find("attachment") != std::string::npos,
+         "partial downloads should keep the attachment header");
+
+  auto tail = get("1", "bytes=-3");
+  expect(tail->getStatusCode() == drogon::k206PartialContent && std::string(tail->getBody()) == "789",
+         "suffix ranges should send the tail");
+  auto open_ended = get("1", "bytes=7-");
+  expect(open_ended->getHeader("content-range") == "bytes 7-9/10", "open ranges should run to the end");
+
+  auto beyond = get("1", "bytes=10-");
+  expect(beyond->getStatusCode() == drogon::k416RequestedRangeNotSatisfiable, "ranges past the end should answer 416");
+  expect(beyond->getHeader("content-range") == "bytes */10", "416 should report the full length");
+  auto multiple = get("1", "bytes=0-1,4-5");
+  expect(multiple->getStatusCode() == drogon::k416RequestedRangeNotSatisfiable, "multiple ranges should be rejected");
+  auto malformed = get("1", "bytes=abc");
+  expect(malformed->getStatusCode() == drogon::k200OK, "malformed ranges should be ignored");
+
+  auto matching = get("1", "bytes=0-0", last_modified);
+  expect(matching->getStatusCode() == drogon::k206PartialContent && std::string(matching->getBody()) == "0",
+         "a matching If-Range should keep the range");
+  auto stale = get("1", "bytes=0-0", "Thu, 01 Jan 1970 00:00:00 GMT");
+  expect(stale->getStatusCode() == drogon::k200OK && std::string(stale->getBody()) == "0123456789",
+         "a stale If-Range date should send the whole file");
+  auto etag = get("1", "bytes=0-0", "\"abc\"");
+  expect(etag->getStatusCode() == drogon::k200OK, "an unknown If-Range entity tag should send the whole file");
+  auto current_tag = get("1", "bytes=0-0", whole->getHeader("etag"));
+  expect(current_tag->getStatusCode() == drogon::k206PartialContent, "the current ETag in If-Range should keep the range");
+  auto weak_tag = get("1", "bytes=0-0", "W/" + whole->getHeader("etag"));
+  expect(weak_tag->getStatusCode() == drogon::k200OK, "weak If-Range tags should never match");
+
+  auto text_req = drogon::HttpRequest::newHttpRequest();
+  text_req->setMethod(drogon::Get);
+  text_req->setParameter("id", "2");
+  text_req->addHeader("range", "bytes=5-8");
+  auto text_resp = invoke([&](auto&& cb) { controller.get_karing(text_req, std::move(cb)); });
+  expect(text_resp->getStatusCode() == drogon::k206PartialContent && std::string(text_resp->getBody()) == "file",
+         "text files should honor ranges too");
+  expect(text_resp->contentTypeString().find("text/plain") != std::string::npos,
+         "partial text files should keep their content type");
 }
 
 }  // namespace
@@ -398,8 +1120,17 @@ int main() {
       {"root_swap", test_root_swap},
       {"root_resequence", test_root_resequence},
       {"root_file_and_text_file_responses", test_root_file_and_text_file_responses},
+      {"root_file_ranges", test_root_file_ranges},
+      {"root_conditional_get", test_root_conditional_get},
       {"search_and_live_search", test_search_and_live_search},
+      {"live_search_cache_refines_prefixes", test_live_search_cache_refines_prefixes},
+      {"live_search_session_delivers_latest", test_live_search_session_delivers_latest},
+      {"change_event_frames", test_change_event_frames},
+      {"events_release_disconnected_clients", test_events_release_disconnected_clients},
+      {"streamed_records_match_json_trees", test_streamed_records_match_json_trees},
+      {"response_compression", test_response_compression},
       {"health_response", test_health_response},
+      {"fts_optimize", test_fts_optimize},
       {"upload_mime_support", test_upload_mime_support},
   };
 
@@ -0,0 +1,155 @@
+// Live-search latency with and without the entries_fts prefix index.
+// usage: karing_live_search_bench [rows] [queries]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include "dao/karing_dao.h"
+#include "db/db_init.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kWordsPerNote = 30;
+constexpr int kVocabulary = 20000;
+constexpr int kLiveLimit = 10;
+
+std::vector<std::string> make_vocabulary(std::mt19937& rng) {
+  static const char* syllables[] = {"ka", "ri", "n",  "go", "to", "mi", "sa", "ne", "lu", "po", "te", "ra",
+                                    "shi", "ku", "zo", "ba", "de", "fi", "ya", "mo", "chi", "wa", "el", "or"};
+  constexpr int count = sizeof(syllables) / sizeof(syllables[0]);
+  std::uniform_int_distribution<int> pick(0, count - 1);
+  std::uniform_int_distribution<int> length(2, 5);
+  std::vector<std::string> words;
+  words.reserve(kVocabulary);
+  for (int i = 0; i < kVocabulary; ++i) {
+    std::string word;
+    for (int n = length(rng); n > 0; --n) word += syllables[pick(rng)];
+    words.push_back(std::move(word));
+  }
+  return words;
+}
+
+bool fill(const fs::path& db_path, int rows, const std::vector<std::string>& words, std::mt19937& rng) {
+  sqlite3* db = nullptr;
+  if (sqlite3_open_v2(db_path.string().c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) return false;
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+  sqlite3_prepare_v2(db,
+                     "UPDATE entries SET used=1, source_kind='direct_text', media_kind='text', content_text=?, "
+                     "stored_at=? WHERE id=?;",
+                     -1, &stmt, nullptr);
+  std::uniform_int_distribution<size_t> pick(0, words.size() - 1);
+  for (int id = 1; id <= rows; ++id) {
+    std::string note;
+    for (int w = 0; w < kWordsPerNote; ++w) {
+      if (w > 0) note.push_back(' ');
+      note += words[pick(rng)];
+    }
+    sqlite3_reset(stmt);
+    sqlite3_bind_text(stmt, 1, note.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, 1700000000 + id);
+    sqlite3_bind_int(stmt, 3, id);
+    sqlite3_step(stmt);
+  }
+  sqlite3_finalize(stmt);
+  const bool ok = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+  sqlite3_close(db);
+  return ok;
+}
+
+// Keystroke-style queries: one or two terms cut to 2-4 characters, as /search/live sends them.
+std::vector<std::string> make_queries(int count, const std::vector<std::string>& words, std::mt19937& rng) {
+  std::uniform_int_distribution<size_t> pick(0, words.size() - 1);
+  std::uniform_int_distribution<int> cut(2, 4);
+  std::uniform_int_distribution<int> terms(1, 2);
+  std::vector<std::string> queries;
+  queries.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    std::string q;
+    for (int t = terms(rng); t > 0; --t) {
+      if (!q.empty()) q += " AND ";
+      q += "\"" + words[pick(rng)].substr(0, cut(rng)) + "\"*";
+    }
+    queries.push_back(std::move(q));
+  }
+  return queries;
+}
+
+long long percentile(const std::vector<long long>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  const auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[index];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int rows = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+  const int query_count = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5000;
+
+  const auto root = fs::temp_directory_path() /
+                    ("karing-bench-live-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directories(root / "uploads");
+  const auto db_path = root / "karing.sqlite";
+
+  std::mt19937 rng(42);
+  const auto words = make_vocabulary(rng);
+  karing::db::fts_options fts;
+  fts.prefix.clear();
+  if (!karing::db::init_sqlite_schema_file(db_path.string(), rows, false, karing::db::journal_mode::wal, fts).ok ||
+      !fill(db_path, rows, words, rng)) {
+    std::cerr << "failed to prepare benchmark database\n";
+    return 1;
+  }
+  const auto queries = make_queries(query_count, words, rng);
+
+  std::cout << "rows=" << rows << " queries=" << query_count << " limit=" << kLiveLimit << "\n";
+  std::cout << std::left << std::setw(10) << "prefix" << std::right << std::setw(10) << "p50_us" << std::setw(10)
+            << "p95_us" << std::setw(10) << "p99_us" << std::setw(10) << "max_us" << "\n";
+
+  for (const std::string prefix : {"", "2 3", "2 3 4"}) {
+    fts.prefix = prefix;
+    if (!karing::db::init_sqlite_schema_file(db_path.string(), rows, false, karing::db::journal_mode::wal, fts).ok) {
+      std::cerr << "failed to rebuild entries_fts with prefix='" << prefix << "'\n";
+      return 1;
+    }
+
+    karing::dao::KaringDao dao(db_path.string(), (root / "uploads").string());
+    karing::dao::KaringDao::Filters filters;
+    filters.sort = karing::dao::SortField::id;
+    filters.projection.preview_chars = 120;
+    std::vector<karing::dao::KaringRecord> found;
+    for (size_t i = 0; i < std::min<size_t>(queries.size(), 200); ++i) {
+      found.clear();
+      dao.try_search_fts(queries[i], kLiveLimit, filters, found);
+    }
+
+    std::vector<long long> micros;
+    micros.reserve(queries.size());
+    for (const auto& q : queries) {
+      found.clear();
+      const auto start = std::chrono::steady_clock::now();
+      dao.try_search_fts(q, kLiveLimit, filters, found);
+      micros.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(micros.begin(), micros.end());
+    std::cout << std::left << std::setw(10) << ("'" + prefix + "'") << std::right << std::setw(10)
+              << percentile(micros, 0.50) << std::setw(10) << percentile(micros, 0.95) << std::setw(10)
+              << percentile(micros, 0.99) << std::setw(10) << micros.back() << "\n";
+  }
+
+  std::error_code ec;
+  fs::remove_all(root, ec);
+  return 0;
+}
@@ -1,18 +1,31 @@
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <optional>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <sqlite3.h>
 
 #include "dao/karing_dao.h"
+#include "db/connection_pool.h"
 #include "db/db_init.h"
 #include "db/db_introspection.h"
+#include "db/slot_cursor.h"
+#include "db/wal_checkpointer.h"
+#include "storage/file_storage.h"
+#include "storage/gzip.h"
+#include "store/body_index.h"
+#include "store/change_feed.h"
+#include "store/entry_store.h"
+#include "store/fts_maintenance.h"
+#include "store/write_queue.h"
 
 namespace fs = std::filesystem;
 
@@ -191,6 +204,8 @@ void test_force_shrink_reassigns_ids_and_removes_old_files() {
   expect(query_text(db.handle, "SELECT content_text FROM entries WHERE id=1;") == "entry-3", "oldest kept entry should move to id 1");
   expect(query_text(db.handle, "SELECT content_text FROM entries WHERE id=2;") == "entry-4", "next kept entry should move to id 2");
   expect(query_text(db.handle, "SELECT content_text FROM entries WHERE id=3;") == "entry-5", "newest kept entry should move to id 3");
+  expect(query_int(db.handle, "SELECT MIN(revision) FROM entries WHERE used=1;") > 1,
+         "moved entries should get a revision no earlier write used");
 }
 
 void test_swap_entries_exchanges_slot_contents() {
@@ -267,6 +282,680 @@ void test_resequence_entries_compacts_ids_from_one() {
          "next_id should point to first cleared slot");
 }
 
+void test_connection_pool_reuses_connections() {
+  const auto env = make_temp_env("pool");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false);
+  expect(init.ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  for (int i = 0; i < 6; ++i) {
+    expect(dao.insert_text("pooled-" + std::to_string(i)) == i + 1, "pooled insert should use next slot");
+    expect(dao.get_by_id(i + 1).has_value(), "pooled read should see committed insert");
+  }
+
+  auto& pool = karing::db::connection_pool::for_path(env.db_path.string());
+  const auto stats = pool.stats();
+  expect(stats.opened <= 2, "sequential calls should reuse one reader and one writer");
+  expect(stats.acquired >= 12, "every dao call should borrow from the pool");
+  expect(stats.in_use == 0, "all leases should be returned");
+
+  auto* writer = pool.acquire(karing::db::connection_pool::role::writer);
+  expect(writer != nullptr, "writer should be available");
+  auto* nested = pool.acquire(karing::db::connection_pool::role::writer);
+  expect(nested == writer, "writer should be re-entrant on the owning thread");
+  pool.release(nested);
+  pool.release(writer);
+  expect(pool.stats().in_use == 0, "nested writer lease should be returned");
+}
+
+void test_statement_cache_reuses_prepared_sql() {
+  const auto env = make_temp_env("stmt_cache");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false);
+  expect(init.ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("cached alpha") == 1, "first insert");
+  expect(dao.insert_text("cached beta") == 2, "second insert");
+
+  auto& pool = karing::db::connection_pool::for_path(env.db_path.string());
+  expect(dao.list_latest(10, karing::dao::SortField::id, true).size() == 2, "list should see both rows");
+  const auto primed = pool.stats().statements_prepared;
+
+  for (int i = 0; i < 5; ++i) {
+    expect(dao.get_by_id(1).has_value(), "cached load_entry should keep working");
+    expect(dao.list_latest(10, karing::dao::SortField::updated_at, false).size() == 2, "primed ordering should list rows");
+    std::vector<karing::dao::KaringRecord> found;
+    expect(dao.try_search_fts("cached", 10, karing::dao::SortField::stored_at, true, found), "cached fts query should run");
+    expect(found.size() == 2, "cached fts query should match both rows");
+  }
+  const auto stats = pool.stats();
+  expect(stats.statements_prepared == primed + 1, "repeat calls should only prepare load_entry once more");
+  expect(stats.statement_hits >= 15, "repeat calls should hit the statement cache");
+
+  sqlite_db db(env.db_path);
+  exec_sql(db.handle, "UPDATE entries SET content_text='changed outside' WHERE id=1;");
+  const auto record = dao.get_by_id(1);
+  expect(record.has_value() && record->content == "changed outside", "cached statement should see external writes");
+}
+
+void test_reader_connections_are_read_only_and_tuned() {
+  const auto env = make_temp_env("read_only");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false, karing::db::journal_mode::wal);
+  expect(init.ok, "schema init should succeed");
+
+  karing::db::pool_options tuned;
+  tuned.wal = true;
+  tuned.reader_mmap_bytes = 8LL * 1024 * 1024;
+  tuned.reader_cache_kib = 2048;
+  karing::db::connection_pool::configure(tuned);
+  auto& pool = karing::db::connection_pool::for_path(env.db_path.string());
+  karing::db::connection_pool::configure(karing::db::pool_options{});
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("read path") == 1, "writer should still insert");
+
+  auto* reader = pool.acquire(karing::db::connection_pool::role::reader);
+  expect(reader != nullptr, "reader should be leased");
+  expect(sqlite3_db_readonly(reader->handle, "main") == 1, "reader should be opened read-only");
+  expect(query_text(reader->handle, "PRAGMA cache_size;") == "-2048", "reader cache size should be applied");
+  expect(query_text(reader->handle, "PRAGMA temp_store;") == "2", "reader temp store should be memory");
+  const std::string mmap = query_text(reader->handle, "PRAGMA mmap_size;");
+  expect(mmap == "8388608" || mmap == "0", "reader mmap size should be applied where supported");
+  expect(sqlite3_exec(reader->handle, "DELETE FROM entries;", nullptr, nullptr, nullptr) == SQLITE_READONLY,
+         "reader should refuse writes");
+  pool.release(reader);
+
+  expect(dao.get_by_id(1).has_value(), "read path should still load entries");
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("read", 10, karing::dao::SortField::id, true, found) && found.size() == 1,
+         "read path should still search");
+}
+
+void test_fts_filters_fill_page_in_sql() {
+  const auto env = make_temp_env("fts_filters");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false);
+  expect(init.ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_file("report-a.png", "image/png", "png") == 1, "insert png");
+  expect(dao.insert_file("report-b.jpg", "image/jpeg", "jpg") == 2, "insert jpeg");
+  expect(dao.insert_file("report-c.mp3", "audio/mpeg", "mp3") == 3, "insert mp3");
+  for (int i = 0; i < 4; ++i) expect(dao.insert_text("report text " + std::to_string(i)) == 4 + i, "insert text");
+
+  karing::dao::KaringDao::Filters files;
+  files.is_file = 1;
+  files.sort = karing::dao::SortField::id;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("report", 2, files, found), "filtered fts should run");
+  expect(found.size() == 2 && found[0].id == 3 && found[1].id == 2, "file filter should fill the page with files");
+
+  auto images = files;
+  images.mime_prefix = "image/";
+  found.clear();
+  expect(dao.try_search_fts("report", 10, images, found), "mime prefix fts should run");
+  expect(found.size() == 2 && found[0].mime == "image/jpeg" && found[1].mime == "image/png", "mime prefix should match images only");
+
+  auto png = files;
+  png.mime = "image/png";
+  found.clear();
+  expect(dao.try_search_fts("report", 10, png, found) && found.size() == 1 && found[0].id == 1, "exact mime should match one");
+
+  karing::dao::KaringDao::Filters texts;
+  texts.is_file = 0;
+  texts.sort = karing::dao::SortField::id;
+  texts.order_desc = false;
+  found.clear();
+  expect(dao.try_search_fts("report", 3, texts, found), "text filter fts should run");
+  expect(found.size() == 3 && found[0].id == 4 && !found[0].is_file, "text filter should fill the page with text rows");
+  expect(dao.count_filtered(images) == 2, "count should honour mime prefix");
+}
+
+void test_keyset_pages_resume_after_cursor() {
+  const auto env = make_temp_env("keyset");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false);
+  expect(init.ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  for (int i = 0; i < 6; ++i) expect(dao.insert_text("page note " + std::to_string(i)) == 1 + i, "insert text");
+  sqlite_db db(env.db_path);
+  exec_sql(db.handle, "UPDATE entries SET updated_at=100 WHERE id IN (2,5); UPDATE entries SET updated_at=NULL WHERE id NOT IN (2,5);");
+
+  karing::dao::KaringDao::Filters by_id;
+  by_id.sort = karing::dao::SortField::id;
+  by_id.after = karing::dao::KaringDao::PageCursor{std::nullopt, 4};
+  const auto listed = dao.list_filtered(10, by_id);
+  expect(listed.size() == 3 && listed[0].id == 3 && listed[2].id == 1, "id cursor should resume below the last id");
+
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("page", 10, by_id, found), "fts with cursor should run");
+  expect(found.size() == 3 && found[0].id == 3, "fts cursor should resume below the last id");
+
+  // updated_at desc: both stamped rows (id desc), then the NULL rows.
+  karing::dao::KaringDao::Filters by_updated;
+  by_updated.sort = karing::dao::SortField::updated_at;
+  std::vector<int> seen;
+  for (int page = 0; page < 4; ++page) {
+    const auto rows = dao.list_filtered(2, by_updated);
+    for (const auto& row : rows) seen.push_back(row.id);
+    if (rows.size() < 2) break;
+    by_updated.after = karing::dao::KaringDao::PageCursor{rows.back().updated_at, rows.back().id};
+  }
+  expect((seen == std::vector<int>{5, 2, 6, 4, 3, 1}), "updated_at pages should cover every row once across NULLs");
+  expect(dao.count_filtered(by_updated) == 6, "count should ignore the cursor");
+}
+
+void test_rank_sort_orders_by_relevance() {
+  const auto env = make_temp_env("rank");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false);
+  expect(init.ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("lorem ipsum dolor sit amet consectetur kiwi adipiscing elit sed do eiusmod") == 1, "insert long");
+  expect(dao.insert_text("kiwi kiwi kiwi") == 2, "insert dense");
+  expect(dao.insert_file("kiwi.png", "image/png", "png") == 3, "insert file");
+  expect(dao.insert_text("banana") == 4, "insert miss");
+
+  karing::dao::KaringDao::Filters ranked;
+  ranked.sort = karing::dao::SortField::rank;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("kiwi", 2, ranked, found), "rank search should run");
+  expect(found.size() == 2 && found[0].score.has_value(), "rank search should return top-k with scores");
+  expect(found[0].id != 1 && found[1].id != 1, "weak match should fall outside the top two");
+  expect(*found[0].score >= *found[1].score, "scores should descend");
+
+  auto texts = ranked;
+  texts.is_file = 0;
+  texts.order_desc = false;
+  found.clear();
+  expect(dao.try_search_fts("kiwi", 10, texts, found), "filtered rank search should run");
+  expect(found.size() == 2 && found[0].id == 1 && found[1].id == 2, "asc rank with filters should list least relevant first");
+
+  karing::dao::KaringDao::Filters by_id;
+  by_id.sort = karing::dao::SortField::id;
+  found.clear();
+  expect(dao.try_search_fts("kiwi", 10, by_id, found) && !found[0].score.has_value(), "non-rank search should carry no score");
+}
+
+void test_fts_snippets_replace_content() {
+  const auto env = make_temp_env("snippet");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false);
+  expect(init.ok, "schema init should succeed");
+
+  std::string long_note;
+  for (int i = 0; i < 200; ++i) long_note += "filler ";
+  long_note += "needle tail";
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text(long_note) == 1, "insert long note");
+  expect(dao.insert_file("needle.txt", "text/plain", "x") == 2, "insert file");
+
+  karing::dao::KaringDao::Filters filters;
+  filters.snippet = true;
+  for (const auto sort : {karing::dao::SortField::id, karing::dao::SortField::rank}) {
+    filters.sort = sort;
+    std::vector<karing::dao::KaringRecord> found;
+    expect(dao.try_search_fts("needle", 10, filters, found) && found.size() == 2, "snippet search should run");
+    const auto& text = found[0].id == 1 ? found[0] : found[1];
+    expect(text.content.empty() && text.snippet.has_value(), "snippet should replace content");
+    expect(text.snippet->size() < 200, "snippet should be a fragment");
+    expect(text.highlights.size() == 1, "snippet should report the match");
+    const auto [offset, length] = text.highlights[0];
+    expect(text.snippet->substr(offset, length) == "needle", "highlight should point at the match");
+  }
+
+  karing::dao::KaringDao::Filters preview;
+  preview.sort = karing::dao::SortField::id;
+  preview.projection.preview_chars = 12;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("needle", 10, preview, found), "preview search should run");
+  expect(found.back().content == "filler fille", "preview should read only the leading characters");
+
+  karing::dao::KaringDao::Filters bare;
+  bare.sort = karing::dao::SortField::id;
+  bare.projection.content = false;
+  found.clear();
+  expect(dao.try_search_fts("needle", 10, bare, found) && !found.empty(), "search without content should run");
+  expect(found.back().content.empty() && found.back().size_bytes > 0, "a bare search should leave content unread");
+  const auto listed = dao.list_filtered(10, bare);
+  expect(!listed.empty() && listed.front().content.empty() && listed.front().size_bytes > 0,
+         "a bare listing should report sizes without content");
+  const auto single = dao.get_by_id(1, bare.projection);
+  expect(single && single->content.empty() && single->size_bytes == static_cast<int64_t>(long_note.size()),
+         "get_by_id should honour the projection");
+  const auto head = dao.get_by_id(1, {true, 6});
+  expect(head && head->content == "filler", "get_by_id should read a preview");
+
+  // Control bytes equal to the snippet markers stay text, right up against the match.
+  const std::string control_note = std::string("a\x03") + "b \x02" + "marked\x03 z\x02";
+  expect(dao.insert_text(control_note) == 3, "insert note with control bytes");
+  found.clear();
+  expect(dao.try_search_fts("marked", 10, filters, found) && found.size() == 1 && found[0].snippet.has_value(),
+         "snippet search should find the note");
+  expect(*found[0].snippet == control_note, "control bytes should survive in the snippet");
+  expect(found[0].highlights.size() == 1 && found[0].highlights[0] == std::make_pair(5, 6),
+         "the highlight should cover only the match");
+}
+
+void test_trigram_index_matches_substrings() {
+  const auto env = make_temp_env("trigram");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false, karing::db::journal_mode::rollback,
+                                                        karing::db::fts_options{karing::db::fts_tokenizer::trigram});
+  expect(init.ok, "trigram schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("東京都の天気予報") == 1, "insert japanese");
+  expect(dao.insert_text("unbelievable results") == 2, "insert english");
+
+  karing::dao::KaringDao::Filters filters;
+  filters.sort = karing::dao::SortField::id;
+  filters.substring = true;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("\"天気予\"", 10, filters, found) && found.size() == 1 && found[0].id == 1, "trigram should match CJK");
+  found.clear();
+  expect(dao.try_search_fts("\"believ\"", 10, filters, found) && found.size() == 1 && found[0].id == 2, "trigram should match mid-word");
+
+  expect(dao.update_text(2, "plain words"), "update english");
+  found.clear();
+  expect(dao.try_search_fts("\"believ\"", 10, filters, found) && found.empty(), "update should drop stale trigrams");
+
+  filters.substring = false;
+  found.clear();
+  expect(dao.try_search_fts("\"believ\"", 10, filters, found) && found.empty(), "word index should not match substrings");
+
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 16, false).ok, "unicode61 re-init should succeed");
+  sqlite_db db(env.db_path);
+  expect(query_text(db.handle, "SELECT count(*) FROM sqlite_master WHERE name='entries_fts_tri';") == "0",
+         "switching back should drop the trigram index");
+}
+
+void test_fts_prefix_index_follows_init_options() {
+  const auto env = make_temp_env("fts_prefix");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false).ok, "schema init should succeed");
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("prefix probe") == 1, "insert text");
+
+  const auto table_sql = [&] {
+    sqlite_db db(env.db_path);
+    return query_text(db.handle, "SELECT sql FROM sqlite_master WHERE name='entries_fts';");
+  };
+  expect(table_sql().find("prefix='2 3'") != std::string::npos, "default init should index 2 and 3 character prefixes");
+
+  karing::db::fts_options no_prefix;
+  no_prefix.prefix.clear();
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false, karing::db::journal_mode::rollback, no_prefix).ok,
+         "re-init without prefixes should succeed");
+  expect(table_sql().find("prefix=''") != std::string::npos, "rebuild should apply the configured prefixes");
+
+  karing::dao::KaringDao::Filters filters;
+  filters.sort = karing::dao::SortField::id;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("\"pr\"* AND \"pro\"*", 10, filters, found) && found.size() == 1, "prefix queries should still match");
+}
+
+void test_fts_search_stops_when_cancelled() {
+  const auto env = make_temp_env("fts_cancel");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 300, false).ok, "schema init should succeed");
+  {
+    sqlite_db db(env.db_path);
+    exec_sql(db.handle,
+             "UPDATE entries SET used=1, source_kind='direct_text', media_kind='text', content_text='note ' || id, "
+             "stored_at=id;");
+  }
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  std::atomic<bool> cancel{true};
+  karing::dao::KaringDao::Filters filters;
+  filters.sort = karing::dao::SortField::id;
+  filters.cancel = &cancel;
+  std::vector<karing::dao::KaringRecord> found;
+  expect(!dao.try_search_fts("\"note\"", 1000, filters, found) && found.empty(), "a cancelled search should fail without rows");
+
+  cancel = false;
+  expect(dao.try_search_fts("\"note\"", 1000, filters, found) && found.size() == 300,
+         "the connection should serve the next search once the flag is clear");
+}
+
+void test_wal_mode_keeps_readers_serving_and_checkpoints() {
+  const auto env = make_temp_env("wal");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false, karing::db::journal_mode::wal);
+  expect(init.ok, "wal schema init should succeed");
+
+  sqlite_db db(env.db_path);
+  expect(query_text(db.handle, "PRAGMA journal_mode;") == "wal", "init should switch the database to wal");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(dao.insert_text("wal-before") == 1, "wal insert");
+
+  exec_sql(db.handle, "BEGIN IMMEDIATE; UPDATE entries SET content_text='uncommitted' WHERE id=1;");
+  const auto during = dao.get_by_id(1);
+  expect(during.has_value() && during->content == "wal-before", "readers should see the last commit while a write is open");
+  exec_sql(db.handle, "COMMIT;");
+
+  karing::db::wal_checkpointer checkpointer(env.db_path.string());
+  expect(checkpointer.checkpoint(false), "passive checkpoint should succeed");
+  auto stats = checkpointer.stats();
+  expect(stats.wal_frames > 0, "wal should hold committed frames");
+  expect(stats.checkpointed_frames == stats.wal_frames, "passive checkpoint should catch up when idle");
+
+  expect(checkpointer.checkpoint(true), "truncate checkpoint should succeed when idle");
+  stats = checkpointer.stats();
+  expect(stats.wal_bytes == 0 && stats.wal_frames == 0, "truncate should empty the wal file");
+  expect(stats.passive_runs == 1 && stats.truncate_runs == 1, "checkpoint runs should be counted");
+}
+
+void test_write_queue_group_commits_concurrent_inserts() {
+  const auto env = make_temp_env("write_queue");
+  const auto init = karing::db::init_sqlite_schema_file(env.db_path.string(), 64, false, karing::db::journal_mode::wal);
+  expect(init.ok, "schema init should succeed");
+
+  constexpr int kThreads = 8;
+  constexpr int kPerThread = 6;
+  std::vector<std::vector<int>> ids(kThreads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+      for (int i = 0; i < kPerThread; ++i) {
+        if (i % 2 == 0) ids[t].push_back(dao.insert_text("queued-" + std::to_string(t) + "-" + std::to_string(i)));
+        else ids[t].push_back(dao.insert_file("queued.bin", "application/octet-stream", "blob-" + std::to_string(t)));
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  std::set<int> unique;
+  for (const auto& per_thread : ids) {
+    for (const int id : per_thread) {
+      expect(id > 0, "queued insert should succeed");
+      unique.insert(id);
+    }
+  }
+  expect(unique.size() == static_cast<size_t>(kThreads * kPerThread), "concurrent inserts should get distinct slots");
+
+  sqlite_db db(env.db_path);
+  expect(query_int(db.handle, "SELECT COUNT(1) FROM entries WHERE used=1;") == kThreads * kPerThread,
+         "every queued insert should be committed");
+  expect(query_int(db.handle, "SELECT next_id FROM store_state WHERE singleton_id=1;") == kThreads * kPerThread + 1,
+         "next_id should advance once per insert");
+
+  const auto stats = karing::store::write_queue::for_path(env.db_path.string()).stats();
+  expect(stats.jobs == kThreads * kPerThread, "every insert should pass through the write queue");
+  expect(stats.failed_jobs == 0 && stats.failed_commits == 0, "queued inserts should not fail");
+  expect(stats.batches <= stats.jobs, "batches should never outnumber jobs");
+
+  for (const auto& item : fs::directory_iterator(env.upload_path)) {
+    expect(item.path().filename().string().rfind("entry_", 0) == 0, "uploads should be named after their slot");
+  }
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  expect(!dao.update_text(999, "missing"), "a failing job should report failure");
+  expect(dao.update_text(1, "still writable"), "a failed job should not poison the queue");
+}
+
+void test_text_file_bodies_are_indexed() {
+  const auto env = make_temp_env("body_index");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false).ok, "schema init should succeed");
+  karing::store::body_index_options index_options;
+  index_options.max_bytes = 32;
+  karing::store::configure_body_index(index_options);
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  const auto hits = [&](const std::string& query) {
+    std::vector<karing::dao::KaringRecord> out;
+    expect(dao.try_search_fts(query, 10, karing::dao::SortField::id, true, out), "search should succeed");
+    std::set<int> ids;
+    for (const auto& record : out) ids.insert(record.id);
+    return ids;
+  };
+
+  const int notes = dao.insert_file("notes.txt", "text/plain", "alpha bravo charlie delta echo foxtrot zulu");
+  const int blob = dao.insert_file("data.bin", "application/octet-stream", "bravo");
+  const int text = dao.insert_text("plain words");
+  expect(notes == 1 && blob == 2 && text == 3, "inserts should succeed");
+  expect(hits("bravo") == std::set<int>{notes}, "text file bodies should match, binary ones should not");
+  expect(hits("zulu").empty(), "bytes past the cap should not be indexed");
+  expect(dao.get_by_id(notes)->content.empty(), "the indexed body should not be served as content");
+
+  karing::dao::KaringDao::Filters snippets;
+  snippets.snippet = true;
+  std::vector<karing::dao::KaringRecord> bodies;
+  expect(dao.try_search_fts("charlie", 10, snippets, bodies) && bodies.size() == 1, "snippet search should find the body");
+  expect(bodies[0].snippet.has_value() && !bodies[0].snippet->empty(), "a body match should get a snippet");
+  expect(bodies[0].highlights.size() == 1 &&
+             bodies[0].snippet->substr(bodies[0].highlights[0].first, bodies[0].highlights[0].second) == "charlie",
+         "the snippet should highlight the body match");
+
+  expect(dao.update_file(notes, "notes.txt", "text/markdown", "# kilo lima"), "update should succeed");
+  expect(hits("bravo").empty() && hits("kilo") == std::set<int>{notes}, "an update should replace the indexed body");
+  expect(dao.swap_entries(notes, text), "swap should succeed");
+  expect(hits("kilo") == std::set<int>{text}, "the body should move with its entry");
+
+  sqlite_db db(env.db_path);
+  exec_sql(db.handle, "UPDATE entries SET body_text=NULL;");
+  expect(hits("kilo").empty(), "clearing body_text should drop it from the index");
+  auto& backfill = karing::store::body_backfill::for_path(env.db_path.string());
+  karing::store::backfill_options backfill_options;
+  backfill_options.batch = 1;
+  backfill_options.pause_ms = 0;
+  expect(backfill.start(backfill_options), "backfill should start");
+  for (int i = 0; i < 200 && backfill.stats().running; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  backfill.stop();
+  expect(!backfill.stats().running && backfill.stats().indexed == 1, "backfill should index the pending upload");
+  expect(hits("kilo") == std::set<int>{text}, "backfilled bodies should be searchable");
+  expect(query_int(db.handle, "SELECT COUNT(1) FROM entries WHERE body_text IS NOT NULL;") == 1,
+         "only text-like uploads should get a body");
+
+  karing::store::configure_body_index({});
+  expect(karing::store::utf8_prefix_length("a\xC3\xA9" "b", 2) == 1, "a cut should not split a UTF-8 sequence");
+
+  // A database from before body indexing gains the column on the next init.
+  const auto legacy = make_temp_env("body_index_legacy");
+  {
+    sqlite3* handle = nullptr;
+    sqlite3_open(legacy.db_path.string().c_str(), &handle);
+    exec_sql(handle,
+             "CREATE TABLE entries (id INTEGER PRIMARY KEY, used INTEGER NOT NULL DEFAULT 0, source_kind TEXT, "
+             "media_kind TEXT, content_text TEXT, file_path TEXT, original_filename TEXT, mime_type TEXT, "
+             "size_bytes INTEGER NOT NULL DEFAULT 0, stored_at INTEGER, updated_at INTEGER);"
+             "INSERT INTO entries(id, used, media_kind, content_text, stored_at) VALUES(1, 1, 'text', 'kept', 1);");
+    sqlite3_close(handle);
+  }
+  expect(karing::db::init_sqlite_schema_file(legacy.db_path.string(), 4, false).ok, "legacy init should succeed");
+  sqlite_db migrated(legacy.db_path);
+  expect(query_int(migrated.handle, "SELECT COUNT(1) FROM pragma_table_info('entries') WHERE name='body_text';") == 1,
+         "init should add body_text");
+  expect(query_int(migrated.handle, "SELECT COUNT(1) FROM pragma_table_info('entries') WHERE name='revision';") == 1,
+         "init should add revision");
+  expect(query_text(migrated.handle, "SELECT content_text FROM entries WHERE id=1;") == "kept", "rows should survive");
+}
+
+void test_text_uploads_can_be_stored_gzipped() {
+  const auto env = make_temp_env("store_gzip");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 4, false).ok, "schema init should succeed");
+  karing::storage::file_storage_options storage;
+  storage.gzip_text = true;
+  karing::storage::file_storage::configure(storage);
+
+  std::string body;
+  for (int i = 0; i < 200; ++i) body += "line " + std::to_string(i) + " of a compressible note\n";
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  const int text = dao.insert_file("notes.txt", "text/plain", body);
+  const int binary = dao.insert_file("data.bin", "application/octet-stream", body);
+  expect(text == 1 && binary == 2, "inserts should succeed");
+
+  sqlite_db db(env.db_path);
+  const auto text_path = query_text(db.handle, "SELECT file_path FROM entries WHERE id=1;");
+  const auto binary_path = query_text(db.handle, "SELECT file_path FROM entries WHERE id=2;");
+  expect(karing::storage::file_storage::is_gzip(text_path) && !karing::storage::file_storage::is_gzip(binary_path),
+         "only text-like uploads should be stored gzipped");
+  expect(fs::file_size(text_path) < body.size() / 4, "the stored text should be compressed");
+  expect(query_int(db.handle, "SELECT size_bytes FROM entries WHERE id=1;") == static_cast<long long>(body.size()),
+         "size_bytes should keep the uncompressed size");
+
+  std::string mime;
+  std::string filename;
+  std::string data;
+  expect(dao.get_file_blob(text, mime, filename, data) && data == body, "reads should inflate the stored file");
+  karing::dao::KaringRecord located;
+  std::string location;
+  expect(dao.get_file_location(text, located, location) && location == text_path, "the location should be the stored file");
+  expect(karing::storage::file_storage::read_stored(text_path, data) && data.size() < body.size(),
+         "stored reads should return the gzip stream");
+  std::string inflated;
+  expect(karing::storage::gzip_decompress(data, inflated) && inflated == body, "the stored stream should be gzip");
+  expect(karing::storage::file_storage::read_prefix(text_path, 10, data) && data == body.substr(0, 10),
+         "prefix reads should inflate only the prefix");
+
+  std::vector<karing::dao::KaringRecord> hits;
+  expect(dao.try_search_fts("compressible", 10, karing::dao::SortField::id, true, hits) && hits.size() == 1 &&
+             hits.front().id == text,
+         "the body of a gzipped upload should be indexed");
+  expect(dao.patch_file(text, std::string("renamed.txt"), std::nullopt, std::nullopt), "patch should succeed");
+  expect(dao.get_file_blob(text, mime, filename, data) && data == body && filename == "renamed.txt",
+         "a patch should carry the inflated body over");
+
+  karing::storage::file_storage::configure({});
+}
+
+void test_fts_maintenance_merges_segments() {
+  const auto env = make_temp_env("fts_maintenance");
+  karing::db::fts_options fts{karing::db::fts_tokenizer::trigram};
+  fts.automerge = 0;
+  fts.crisismerge = 64;
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false, karing::db::journal_mode::wal, fts).ok,
+         "schema init should succeed");
+  {
+    sqlite_db db(env.db_path);
+    expect(query_int(db.handle, "SELECT v FROM entries_fts_config WHERE k='automerge';") == 0 &&
+               query_int(db.handle, "SELECT v FROM entries_fts_tri_config WHERE k='crisismerge';") == 64,
+           "merge settings should be stored on every FTS table");
+  }
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  for (const char* text : {"alpha one", "bravo two", "charlie three", "delta four"}) {
+    expect(dao.insert_text(text) > 0, "insert should succeed");
+  }
+  auto& maintenance = karing::store::fts_maintenance::for_path(env.db_path.string());
+  expect(maintenance.refresh(), "refresh should succeed");
+  const auto before = maintenance.stats();
+  expect(before.words.present && before.trigram.present && before.words.segments >= 4 && before.words.size_bytes > 0,
+         "each committed write should add a segment while automerge is off");
+
+  int steps = 0;
+  for (int merged = 1; merged == 1 && steps < 50; ++steps) merged = maintenance.merge_step(16);
+  expect(maintenance.merge_step(16) == 0, "merging should stop once one segment is left");
+  expect(maintenance.refresh(), "refresh should succeed");
+  const auto after = maintenance.stats();
+  expect(after.words.segments == 1 && after.trigram.segments == 1 && after.merge_steps > 0,
+         "merge steps should leave one segment per index");
+
+  std::vector<karing::dao::KaringRecord> found;
+  expect(dao.try_search_fts("charlie", 10, karing::dao::SortField::id, true, found) && found.size() == 1,
+         "merged index should still match");
+
+  expect(dao.insert_text("echo five") > 0 && dao.insert_text("foxtrot six") > 0, "insert should succeed");
+  expect(maintenance.optimize(), "optimize should succeed");
+  const auto optimized = maintenance.stats();
+  expect(optimized.words.segments == 1 && optimized.optimize_runs == 1 && optimized.last_optimize_at > 0,
+         "optimize should merge the new segments");
+}
+
+void test_change_feed_publishes_committed_writes() {
+  const auto env = make_temp_env("change_feed");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 8, false).ok, "schema init should succeed");
+
+  using karing::store::change_kind;
+  karing::store::change_feed_options feed_options;
+  feed_options.ring_size = 4;
+  feed_options.subscriber_buffer = 2;
+  karing::store::change_feed::configure(feed_options);
+  auto& feed = karing::store::change_feed::for_path(env.db_path.string());
+  karing::store::change_feed::configure({});
+
+  std::atomic<int> wakes{0};
+  auto subscription = feed.subscribe(std::nullopt, [&] { ++wakes; });
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  bool lost = true;
+
+  expect(dao.insert_text("first body") == 1, "insert should succeed");
+  auto events = subscription->take(lost);
+  expect(!lost && events.size() == 1 && wakes == 1, "one commit should wake the subscriber once");
+  expect(events[0].kind == change_kind::created && events[0].ids == std::vector<int>{1}, "insert should publish created");
+  expect(events[0].records.size() == 1 && events[0].records[0].content.empty(), "events should carry metadata only");
+  const auto first_id = events[0].id;
+
+  expect(dao.update_text(1, "changed") && dao.insert_file("two.txt", "text/plain", "two") == 2, "writes should succeed");
+  events = subscription->take(lost);
+  expect(events.size() == 2 && events[0].kind == change_kind::updated && events[1].kind == change_kind::created,
+         "events should arrive in commit order");
+  expect(events[1].records[0].filename == "two.txt", "created event should describe the new row");
+  const auto third_id = events[1].id;
+
+  expect(!dao.update_text(7, "missing"), "failed write should report failure");
+  expect(dao.swap_entries(1, 2) && dao.logical_delete(2), "swap and delete should succeed");
+  events = subscription->take(lost);
+  expect(events.size() == 2, "failed writes should not publish");
+  expect(events[0].kind == change_kind::swapped && events[0].records.size() == 2, "swap should describe both rows");
+  expect(events[1].kind == change_kind::deleted && events[1].records.empty(), "delete should publish ids only");
+
+  auto resumed = feed.subscribe(third_id, nullptr);
+  events = resumed->take(lost);
+  expect(!lost && events.size() == 2 && events[0].kind == change_kind::swapped, "resume should replay later events");
+  expect(resumed->take(lost).empty() && !lost, "replayed events should be taken once");
+  resumed->close();
+  auto stale = feed.subscribe(first_id - 1, nullptr);
+  stale->take(lost);
+  expect(lost, "a resume point older than the ring should be reported lost");
+  stale->close();
+
+  for (int i = 0; i < 3; ++i) expect(dao.insert_text("burst") > 0, "burst insert should succeed");
+  events = subscription->take(lost);
+  expect(lost && events.empty(), "a full buffer should be dropped and reported lost");
+  expect(feed.stats().dropped == 3, "dropped events should be counted");
+}
+
+void test_slot_cursor_wraps_and_persists_next_id() {
+  const auto env = make_temp_env("slot_cursor");
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 3, false).ok, "schema init should succeed");
+
+  karing::dao::KaringDao dao(env.db_path.string(), env.upload_path.string());
+  const std::vector<int> expected = {1, 2, 3, 1, 2};
+  for (const int id : expected) {
+    expect(dao.insert_text("ring-" + std::to_string(id)) == id, "cursor should walk the ring in order");
+  }
+  sqlite_db db(env.db_path);
+  expect(query_int(db.handle, "SELECT next_id FROM store_state WHERE singleton_id=1;") == 3,
+         "next_id should be persisted with the insert");
+
+  auto& cursor = karing::db::slot_cursor::for_path(env.db_path.string());
+  const auto first = cursor.reserve();
+  const auto second = cursor.reserve();
+  expect(first.slot == 3 && second.slot == 1, "reservations should hand out consecutive slots");
+  uint64_t previous = 0;
+  expect(cursor.claim_persist(second, previous), "the furthest reservation should persist next_id");
+  expect(!cursor.claim_persist(first, previous), "an earlier reservation committing late must not move next_id back");
+
+  // A claim whose job rolls back is taken back, so the next furthest reservation persists instead.
+  const auto third = cursor.reserve();
+  const auto fourth = cursor.reserve();
+  bool undone = false;
+  const bool rolled_back = !karing::store::write_queue::for_path(env.db_path.string()).run([&](auto&) {
+    uint64_t before = 0;
+    if (!cursor.claim_persist(fourth, before)) return true;
+    karing::store::write_queue::on_rollback([&, before] {
+      cursor.restore_persist(fourth, before);
+      undone = true;
+    });
+    return false;
+  });
+  expect(rolled_back && undone, "a failing job should run its rollback hooks");
+  expect(cursor.claim_persist(third, previous), "a rolled-back claim must not hide earlier reservations");
+
+  expect(karing::db::init_sqlite_schema_file(env.db_path.string(), 5, false).ok, "schema grow should succeed");
+  expect(!cursor.current(first), "init should invalidate outstanding reservations");
+  const int after_grow = query_int(db.handle, "SELECT next_id FROM store_state WHERE singleton_id=1;");
+  expect(dao.insert_text("after-grow") == after_grow, "cursor should reseed from store_state after init");
+}
+
 }  // namespace
 
 int main() {
@@ -277,6 +966,23 @@ int main() {
       {"force_shrink_reassigns_ids_and_removes_old_files", test_force_shrink_reassigns_ids_and_removes_old_files},
       {"swap_entries_exchanges_slot_contents", test_swap_entries_exchanges_slot_contents},
       {"resequence_entries_compacts_ids_from_one", test_resequence_entries_compacts_ids_from_one},
+      {"connection_pool_reuses_connections", test_connection_pool_reuses_connections},
+      {"statement_cache_reuses_prepared_sql", test_statement_cache_reuses_prepared_sql},
+      {"reader_connections_are_read_only_and_tuned", test_reader_connections_are_read_only_and_tuned},
+      {"fts_filters_fill_page_in_sql", test_fts_filters_fill_page_in_sql},
+      {"keyset_pages_resume_after_cursor", test_keyset_pages_resume_after_cursor},
+      {"rank_sort_orders_by_relevance", test_rank_sort_orders_by_relevance},
+      {"fts_snippets_replace_content", test_fts_snippets_replace_content},
+      {"trigram_index_matches_substrings", test_trigram_index_matches_substrings},
+      {"fts_prefix_index_follows_init_options", test_fts_prefix_index_follows_init_options},
+      {"fts_search_stops_when_cancelled", test_fts_search_stops_when_cancelled},
+      {"wal_mode_keeps_readers_serving_and_checkpoints", test_wal_mode_keeps_readers_serving_and_checkpoints},
+      {"write_queue_group_commits_concurrent_inserts", test_write_queue_group_commits_concurrent_inserts},
+      {"text_file_bodies_are_indexed", test_text_file_bodies_are_indexed},
+      {"text_uploads_can_be_stored_gzipped", test_text_uploads_can_be_stored_gzipped},
+      {"fts_maintenance_merges_segments", test_fts_maintenance_merges_segments},
+      {"change_feed_publishes_committed_writes", test_change_feed_publishes_committed_writes},
+      {"slot_cursor_wraps_and_persists_next_id", test_slot_cursor_wraps_and_persists_next_id},
   };
 
   int failed = 0;